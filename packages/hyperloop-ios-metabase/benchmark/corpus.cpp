@@ -0,0 +1,275 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <cerrno>
+#include <fstream>
+#include <sys/stat.h>
+#include "corpus.h"
+
+namespace hyperloop {
+
+	/**
+	 * create a directory and any missing parents
+	 */
+	static bool makeDirectories (const std::string &dir) {
+		for (size_t slash = dir.find('/', 1); ; slash = dir.find('/', slash + 1)) {
+			auto path = dir.substr(0, slash);
+			if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+				return false;
+			}
+			if (slash == std::string::npos) {
+				return true;
+			}
+		}
+	}
+
+	static std::string numbered (const char *name, unsigned n) {
+		return name + std::to_string(n);
+	}
+
+	CorpusOptions::CorpusOptions () : frameworks(4), classes(200), categories(50), protocols(50),
+		methods(8), properties(4), blocks(20), structs(40), unions(10), typedefDepth(3), seed(1), moduleMaps(false) {
+	}
+
+	Corpus::Corpus (const CorpusOptions &_options) : options(_options), state(_options.seed ? _options.seed : 1) {
+	}
+
+	/**
+	 * xorshift, so a seed gives the same corpus on every platform
+	 */
+	unsigned Corpus::next (unsigned n) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return n ? state % n : 0;
+	}
+
+	/**
+	 * framework a class or protocol is declared in, HLKit0 is reserved for
+	 * the shared types unless there is only one framework
+	 */
+	static unsigned frameworkOf (unsigned index, unsigned count, unsigned frameworks) {
+		if (frameworks < 2 || count == 0) {
+			return 0;
+		}
+		return 1 + static_cast<unsigned>(static_cast<unsigned long long>(index) * (frameworks - 1) / count);
+	}
+
+	std::string Corpus::randomType (unsigned classLimit, unsigned protocolLimit, unsigned blockLimit) {
+		switch (next(16)) {
+			case 0: return "double";
+			case 1: return "float";
+			case 2: return "unsigned long long";
+			case 3: return "const char *";
+			case 4: return "id";
+			case 5: return "SEL";
+			case 6: return "Class";
+			case 7: return "HLObject *";
+			case 8: {
+				if (classLimit) {
+					return numbered("HLClass", next(classLimit)) + " *";
+				}
+				break;
+			}
+			case 9: {
+				if (options.structs) {
+					return numbered("HLStruct", next(options.structs));
+				}
+				break;
+			}
+			case 10: {
+				if (options.structs) {
+					return numbered("HLStruct", next(options.structs)) + " *";
+				}
+				break;
+			}
+			case 11: {
+				if (options.structs && options.typedefDepth) {
+					return numbered("HLStruct", next(options.structs)) + numbered("Alias", options.typedefDepth - 1);
+				}
+				break;
+			}
+			case 12: {
+				if (blockLimit) {
+					return numbered("HLBlock", next(blockLimit));
+				}
+				break;
+			}
+			case 13: {
+				if (protocolLimit) {
+					return "id<" + numbered("HLProtocol", next(protocolLimit)) + ">";
+				}
+				break;
+			}
+			case 14: {
+				if (options.unions) {
+					return numbered("HLUnion", next(options.unions));
+				}
+				break;
+			}
+			default: {
+				break;
+			}
+		}
+		return "int";
+	}
+
+	void Corpus::writeMembers (std::ostringstream &out, const std::string &prefix, unsigned classLimit, unsigned protocolLimit) {
+		for (unsigned p = 0; p < options.properties; p++) {
+			out << "@property (nonatomic, assign) " << randomType(classLimit, protocolLimit, options.blocks) << " " << prefix << "Property" << p << ";\n";
+		}
+		for (unsigned m = 0; m < options.methods; m++) {
+			// one draw per statement, the order operands of << are evaluated in isn't fixed
+			std::string kind = next(5) == 0 ? "+ (" : "- (";
+			std::string returns = next(3) == 0 ? "void" : randomType(classLimit, protocolLimit, options.blocks);
+			out << kind << returns << ")" << prefix << "Method" << m;
+			auto arguments = next(4);
+			for (unsigned a = 0; a < arguments; a++) {
+				out << (a ? " with" + std::to_string(a) : "") << ":(" << randomType(classLimit, protocolLimit, options.blocks) << ")arg" << a;
+			}
+			out << ";\n";
+		}
+	}
+
+	std::string Corpus::header (unsigned framework) {
+		std::ostringstream out;
+		out << "/**\n * synthetic header " << framework << "\n */\n\n";
+
+		if (options.moduleMaps && framework > 0) {
+			// declarations only reference earlier ones, so the frameworks before this one
+			for (unsigned f = 0; f < framework; f++) {
+				out << "#import <" << numbered("HLKit", f) << "/" << numbered("HLKit", f) << ".h>\n";
+			}
+			out << "\n";
+		}
+
+		if (framework == 0) {
+			out << "__attribute__((objc_root_class))\n@interface HLObject\n+ (instancetype)alloc;\n- (instancetype)init;\n@end\n\n";
+			for (unsigned s = 0; s < options.structs; s++) {
+				out << "typedef struct HLStruct" << s << " {\n\tint a;\n\tdouble b;\n\tfloat c[4];\n";
+				if (s > 0 && next(2)) {
+					out << "\tHLStruct" << next(s) << " nested;\n";
+				}
+				out << "\tconst char *name;\n} HLStruct" << s << ";\n";
+				for (unsigned d = 0; d < options.typedefDepth; d++) {
+					out << "typedef " << (d ? numbered("HLStruct", s) + numbered("Alias", d - 1) : numbered("HLStruct", s))
+						<< " HLStruct" << s << "Alias" << d << ";\n";
+				}
+				out << "\n";
+			}
+			for (unsigned u = 0; u < options.unions; u++) {
+				out << "typedef union HLUnion" << u << " {\n\tint i;\n\tfloat f;\n";
+				if (options.structs) {
+					out << "\tHLStruct" << next(options.structs) << " s;\n";
+				}
+				out << "} HLUnion" << u << ";\n\n";
+			}
+			for (unsigned b = 0; b < options.blocks; b++) {
+				// blocks only take the blocks declared before them
+				std::string returns = next(2) ? "void" : randomType(0, 0, b);
+				std::string first = randomType(0, 0, b);
+				std::string second = randomType(0, 0, b);
+				out << "typedef " << returns << " (^HLBlock" << b << ")(" << first << ", " << second << ");\n";
+			}
+			out << "\n";
+		}
+
+		for (unsigned p = 0; p < options.protocols; p++) {
+			if (frameworkOf(p, options.protocols, options.frameworks) != framework) {
+				continue;
+			}
+			out << "@protocol HLProtocol" << p;
+			if (p > 0 && next(2)) {
+				out << " <HLProtocol" << next(p) << ">";
+			}
+			out << "\n";
+			unsigned classLimit = 0;
+			while (classLimit < options.classes && frameworkOf(classLimit, options.classes, options.frameworks) < framework) {
+				classLimit++;
+			}
+			writeMembers(out, numbered("protocol", p), classLimit, p);
+			out << "@optional\n- (void)protocol" << p << "Optional;\n@end\n\n";
+		}
+
+		unsigned protocolLimit = 0;
+		while (protocolLimit < options.protocols && frameworkOf(protocolLimit, options.protocols, options.frameworks) <= framework) {
+			protocolLimit++;
+		}
+		for (unsigned c = 0; c < options.classes; c++) {
+			if (frameworkOf(c, options.classes, options.frameworks) != framework) {
+				continue;
+			}
+			out << "@interface HLClass" << c << " : " << (c > 0 && next(2) ? numbered("HLClass", next(c)) : "HLObject");
+			if (protocolLimit) {
+				out << " <HLProtocol" << next(protocolLimit) << ">";
+			}
+			out << "\n";
+			writeMembers(out, numbered("class", c), c, protocolLimit);
+			out << "@end\n\n";
+		}
+
+		for (unsigned n = 0; options.classes && n < options.categories; n++) {
+			auto c = n % options.classes;
+			if (frameworkOf(c, options.classes, options.frameworks) != framework) {
+				continue;
+			}
+			out << "@interface HLClass" << c << " (HLCategory" << n << ")\n";
+			writeMembers(out, numbered("category", n), c, protocolLimit);
+			out << "@end\n\n";
+		}
+
+		return out.str();
+	}
+
+	bool Corpus::write (const std::string &dir) {
+		state = options.seed ? options.seed : 1;
+		std::ostringstream imports;
+		auto frameworks = options.frameworks ? options.frameworks : 1;
+		for (unsigned f = 0; f < frameworks; f++) {
+			auto name = numbered("HLKit", f);
+			auto headers = dir + "/" + name + ".framework/Headers";
+			if (!makeDirectories(headers)) {
+				return false;
+			}
+			auto path = headers + "/" + name + ".h";
+			std::ofstream out(path, std::ios::out | std::ios::trunc);
+			out << header(f);
+			out.close();
+			if (out.fail()) {
+				return false;
+			}
+			if (options.moduleMaps) {
+				auto modules = dir + "/" + name + ".framework/Modules";
+				if (!makeDirectories(modules)) {
+					return false;
+				}
+				std::ofstream map(modules + "/module.modulemap", std::ios::out | std::ios::trunc);
+				map << "framework module " << name << " {\n\tumbrella header \"" << name << ".h\"\n\texport *\n\tmodule * { export * }\n}\n";
+				map.close();
+				if (map.fail()) {
+					return false;
+				}
+				imports << "#import <" << name << "/" << name << ".h>\n";
+			} else {
+				imports << "#import \"" << path << "\"\n";
+			}
+		}
+		umbrella = dir + "/corpus.h";
+		std::ofstream out(umbrella, std::ios::out | std::ios::trunc);
+		out << imports.str();
+		out.close();
+		return !out.fail();
+	}
+
+	std::map<std::string, unsigned> Corpus::getExpectedCounts () const {
+		std::map<std::string, unsigned> counts;
+		counts["classes"] = options.classes + 1;
+		counts["categories"] = options.classes ? options.categories : 0;
+		counts["protocols"] = options.protocols;
+		counts["structs"] = options.structs;
+		counts["unions"] = options.unions;
+		counts["typedefs"] = options.structs * (options.typedefDepth + 1) + options.unions + options.blocks;
+		return counts;
+	}
+}
@@ -0,0 +1,88 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_BENCHMARK_CORPUS_H
+#define HYPERLOOP_BENCHMARK_CORPUS_H
+
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace hyperloop {
+
+	/**
+	 * shape of a synthetic Objective-C header corpus
+	 */
+	struct CorpusOptions {
+		CorpusOptions ();
+
+		/** number of frameworks the declarations are spread over */
+		unsigned frameworks;
+		unsigned classes;
+		unsigned categories;
+		unsigned protocols;
+		/** methods and properties per class, category and protocol */
+		unsigned methods;
+		unsigned properties;
+		/** block typedefs, used as method and property types */
+		unsigned blocks;
+		unsigned structs;
+		unsigned unions;
+		/** length of the typedef chain aliasing each struct */
+		unsigned typedefDepth;
+		/** seed for the choice of types, the same seed gives the same corpus */
+		unsigned seed;
+		/**
+		 * write a module map per framework, and import frameworks as
+		 * <HLKitN/HLKitN.h> from the frameworks using them, so every
+		 * framework can be built as a clang module
+		 */
+		bool moduleMaps;
+	};
+
+	/**
+	 * Writes a corpus of framework style headers below a directory:
+	 *
+	 *   <dir>/HLKit0.framework/Headers/HLKit0.h ... HLKitN.h
+	 *   <dir>/corpus.h, importing every framework header
+	 *   <dir>/HLKitN.framework/Modules/module.modulemap, with moduleMaps
+	 *
+	 * HLKit0 holds the root class, structs, unions, typedef chains and
+	 * blocks, the classes, categories and protocols are spread over the
+	 * other frameworks. Declarations only reference ones written before
+	 * them, so the corpus parses without any system headers.
+	 */
+	class Corpus {
+		public:
+			Corpus (const CorpusOptions &options);
+
+			/**
+			 * write the corpus, returns false if a file can't be written
+			 */
+			bool write (const std::string &dir);
+
+			/**
+			 * path of the umbrella header, set by write
+			 */
+			inline const std::string& getUmbrellaHeader() const { return umbrella; }
+
+			/**
+			 * number of top level definitions per kind the generator should find,
+			 * keyed like the -stats counters
+			 */
+			std::map<std::string, unsigned> getExpectedCounts () const;
+
+		private:
+			std::string header (unsigned framework);
+			std::string randomType (unsigned classLimit, unsigned protocolLimit, unsigned blockLimit);
+			void writeMembers (std::ostringstream &out, const std::string &prefix, unsigned classLimit, unsigned protocolLimit);
+			unsigned next (unsigned n);
+
+			CorpusOptions options;
+			std::string umbrella;
+			unsigned state;
+	};
+}
+
+#endif
@@ -0,0 +1,232 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ *
+ * Microbenchmark for classifying primitive types and encodings, which the
+ * generator does for every argument, return value and field it resolves.
+ * Compares the hashed switch in src/encoding.cpp against the chains of
+ * string comparisons it replaced (kept below as "legacy") and checks that
+ * both give the same answers before timing them.
+ *
+ * Build and run from the package directory:
+ *
+ *   c++ -std=c++11 -O2 -Isrc benchmark/encoding.cpp src/encoding.cpp -o encoding && ./encoding
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "encoding.h"
+
+namespace legacy {
+
+	static std::string getEncodingFromType (const std::string &str) {
+		if (str == "char" || str == "char16" || str == "char32" || str == "s_char" || str == "char_s") {
+			return "c";
+		} else if (str == "int") {
+			return "i";
+		} else if (str == "short") {
+			return "s";
+		} else if (str == "long") {
+			return "l";
+		} else if (str == "long_long" || str == "long long") {
+			return "q";
+		} else if (str == "char_u" || str == "uchar" || str == "unsigned char") {
+			return "C";
+		} else if (str == "uint" || str == "unsigned int") {
+			return "I";
+		} else if (str == "ushort" || str == "unsigned short") {
+			return "S";
+		} else if (str == "ulong" || str == "unsigned long") {
+			return "L";
+		} else if (str == "long_double" || str == "long double") {
+			return "D";
+		} else if (str == "ulonglong" || str == "unsigned long long") {
+			return "Q";
+		} else if (str == "float") {
+			return "f";
+		} else if (str == "double") {
+			return "d";
+		} else if (str == "bool" || str == "_Bool") {
+			return "B";
+		} else if (str == "void") {
+			return "v";
+		} else if (str == "char *") {
+			return "*";
+		} else if (str == "obj_interface" || str == "id" || str == "objc_pointer") {
+			return "@";
+		} else if (str == "enum") {
+			return "i";
+		} else if (str == "Class") {
+			return "#";
+		} else if (str == "SEL") {
+			return ":";
+		} else if (str == "block") {
+			return "@?";
+		}
+		return "?";
+	}
+
+	static std::string EncodingToType (const std::string &encoding) {
+		if (encoding == "i") {
+			return "int";
+		} else if (encoding == "l") {
+			return "long";
+		} else if (encoding == "c") {
+			return "c";
+		} else if (encoding == "d") {
+			return "double";
+		} else if (encoding == "f") {
+			return "float";
+		} else if (encoding == "s") {
+			return "short";
+		} else if (encoding == "q") {
+			return "long long";
+		} else if (encoding == "C") {
+			return "unsigned char";
+		} else if (encoding == "I") {
+			return "unsigned int";
+		} else if (encoding == "S") {
+			return "unsigned short";
+		} else if (encoding == "L") {
+			return "unsigned long";
+		} else if (encoding == "Q") {
+			return "unsigned long long";
+		} else if (encoding == "B") {
+			return "bool";
+		} else if (encoding == "v") {
+			return "void";
+		} else if (encoding == "*") {
+			return "char *";
+		} else if (encoding == "@") {
+			return "id";
+		} else if (encoding == "#") {
+			return "Class";
+		} else if (encoding == ":") {
+			return "SEL";
+		} else if (encoding == "@?") {
+			return "block";
+		}
+		return "unknown";
+	}
+}
+
+/**
+ * types as the resolver sees them, weighted roughly like an SDK: mostly
+ * object pointers, structs and typedefs that aren't primitives at all
+ */
+static std::vector<std::string> makeTypes () {
+	const char *samples[] = {
+		"objc_pointer", "objc_pointer", "objc_pointer", "typedef", "typedef", "struct", "pointer",
+		"enum", "double", "uint", "ulong", "long", "bool", "void", "id", "SEL", "Class", "block",
+		"char_s", "char_u", "int", "float", "long_long", "ulonglong", "char *", "unexposed",
+		"record", "constant_array", "incomplete_array", "function_proto", "NSString *", "CGRect",
+		"unsigned int", "unsigned long long", "long double", "_Bool", "char16", "obj_interface"
+	};
+	std::vector<std::string> types;
+	for (int r = 0; r < 1000; r++) {
+		for (auto sample : samples) {
+			types.push_back(sample);
+		}
+	}
+	return types;
+}
+
+static std::vector<std::string> makeEncodings () {
+	const char *samples[] = {
+		"@", "@", "@", "{CGRect={CGPoint=dd}{CGSize=dd}}", "^v", "v", "d", "Q", "q", "B", "c",
+		"C", "i", "I", "s", "S", "l", "L", "f", "*", "#", ":", "@?", "^@", "[4i]", "(?=if)", "?"
+	};
+	std::vector<std::string> encodings;
+	for (int r = 0; r < 1000; r++) {
+		for (auto sample : samples) {
+			encodings.push_back(sample);
+		}
+	}
+	return encodings;
+}
+
+template <typename F>
+static double timeIt (size_t iterations, F fn) {
+	double best = 0;
+	for (int run = 0; run < 5; run++) {
+		auto start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < iterations; i++) {
+			fn();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		double ms = std::chrono::duration<double, std::milli>(end - start).count();
+		if (run == 0 || ms < best) {
+			best = ms;
+		}
+	}
+	return best;
+}
+
+static void report (const char *name, double legacyMs, double currentMs) {
+	std::cout << std::left << std::setw(24) << name
+		<< std::right << std::fixed << std::setprecision(2)
+		<< std::setw(12) << legacyMs << " ms"
+		<< std::setw(12) << currentMs << " ms"
+		<< std::setw(10) << (legacyMs / currentMs) << "x" << std::endl;
+}
+
+int main (int argc, char* argv[]) {
+	auto types = makeTypes();
+	auto encodings = makeEncodings();
+
+	for (auto &type : types) {
+		auto expected = legacy::getEncodingFromType(type);
+		auto actual = hyperloop::encodingOf(hyperloop::primitiveForType(type));
+		if (expected != actual) {
+			std::cerr << "mismatch encoding " << type << ": " << actual << " instead of " << expected << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	for (auto &encoding : encodings) {
+		auto expected = legacy::EncodingToType(encoding);
+		auto actual = hyperloop::typeOf(hyperloop::primitiveForEncoding(encoding));
+		if (expected != actual) {
+			std::cerr << "mismatch type of " << encoding << ": " << actual << " instead of " << expected << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	// the only encoding the legacy chain had no type for
+	if (std::string(hyperloop::typeOf(hyperloop::primitiveForEncoding("D"))) != "long double") {
+		std::cerr << "mismatch type of D" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	size_t sink = 0;
+	std::cout << std::left << std::setw(24) << "benchmark" << std::right << std::setw(15) << "legacy" << std::setw(15) << "current" << std::setw(11) << "speedup" << std::endl;
+
+	auto legacyTypes = timeIt(20, [&]() {
+		for (auto &type : types) {
+			sink += legacy::getEncodingFromType(type).length();
+		}
+	});
+	auto currentTypes = timeIt(20, [&]() {
+		for (auto &type : types) {
+			sink += std::string(hyperloop::encodingOf(hyperloop::primitiveForType(type))).length();
+		}
+	});
+	report("type to encoding", legacyTypes, currentTypes);
+
+	auto legacyEncodings = timeIt(20, [&]() {
+		for (auto &encoding : encodings) {
+			sink += legacy::EncodingToType(encoding).length();
+		}
+	});
+	auto currentEncodings = timeIt(20, [&]() {
+		for (auto &encoding : encodings) {
+			sink += std::string(hyperloop::typeOf(hyperloop::primitiveForEncoding(encoding))).length();
+		}
+	});
+	report("encoding to type", legacyEncodings, currentEncodings);
+
+	return sink == 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
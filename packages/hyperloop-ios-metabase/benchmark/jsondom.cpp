@@ -0,0 +1,220 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ *
+ * Microbenchmark for building and reading Json::Value documents shaped like
+ * a metabase: wide sections with thousands of definitions, each a small
+ * object with the same handful of member names.
+ *
+ * Reports time and the heap blocks and bytes still in use by the finished
+ * document, with member names given as plain strings (copied into every
+ * object) and as Json::StaticString (stored by pointer), which is what the
+ * generator's toJSON methods use.
+ *
+ * Built with -DJSON_USE_STD_MAP, objects are stored in a std::map as jsoncpp
+ * did before Value::ObjectValues, which is what the savings are measured
+ * against. Build and run both from the package directory:
+ *
+ *   c++ -std=c++11 -O2 -Isrc benchmark/jsondom.cpp src/jsoncpp.cpp -o jsondom && ./jsondom
+ *   c++ -std=c++11 -O2 -Isrc -DJSON_USE_STD_MAP benchmark/jsondom.cpp src/jsoncpp.cpp -o jsondom-map && ./jsondom-map
+ *
+ * or build the jsondom-benchmark and jsondom-map-benchmark CMake targets.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "json/json.h"
+
+/**
+ * heap blocks and bytes currently in use by the process, -1 where the
+ * allocator doesn't report them
+ */
+struct HeapUsage {
+	long long blocks;
+	long long bytes;
+};
+
+static HeapUsage heapUsage () {
+	HeapUsage usage = { -1, -1 };
+#if defined(__APPLE__)
+	malloc_statistics_t stats;
+	malloc_zone_statistics(NULL, &stats);
+	usage.blocks = static_cast<long long>(stats.blocks_in_use);
+	usage.bytes = static_cast<long long>(stats.size_in_use);
+#elif defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	struct mallinfo2 info = mallinfo2();
+	usage.bytes = static_cast<long long>(info.uordblks + info.hblkhd);
+#endif
+	return usage;
+}
+
+static const char *frameworks[] = { "UIKit", "Foundation", "CoreGraphics", "AVFoundation" };
+
+/**
+ * build a metabase shaped document, Key is const char * or Json::StaticString
+ */
+template <typename Key>
+static Json::Value buildDocument (int classCount) {
+	const Key name("name"), framework("framework"), thirdparty("thirdparty"), filename("filename"),
+		line("line"), introducedIn("introducedIn"), selector("selector"), encoding("encoding"),
+		returns("returns"), arguments("arguments"), instance("instance"), type("type"), value("value"),
+		methods("methods"), properties("properties"), optional("optional"), superclass("superclass");
+	Json::Value classes;
+	for (int c = 0; c < classCount; c++) {
+		std::string fw = frameworks[c % 4];
+		std::string className = "Class" + std::to_string(c);
+		Json::Value cls;
+		cls[name] = className;
+		cls[framework] = fw;
+		cls[thirdparty] = false;
+		cls[filename] = "/Applications/Xcode.app/Contents/Developer/Platforms/iPhoneSimulator.platform/Developer/SDKs/iPhoneSimulator.sdk/System/Library/Frameworks/" + fw + ".framework/Headers/" + className + ".h";
+		cls[line] = std::to_string(c);
+		cls[introducedIn] = "9.0.0";
+		cls[superclass] = "NSObject";
+		for (int m = 0; m < 8; m++) {
+			std::string sel = "doSomething" + std::to_string(m) + ":withObject:";
+			Json::Value method;
+			method[selector] = sel;
+			method[name] = "doSomething" + std::to_string(m);
+			method[encoding] = "v32@0:8@16q24";
+			method[instance] = true;
+			Json::Value ret;
+			ret[type] = "void";
+			ret[value] = "void";
+			ret[encoding] = "v";
+			method[returns] = ret;
+			Json::Value args(Json::arrayValue);
+			for (int a = 0; a < 2; a++) {
+				Json::Value arg;
+				arg[name] = "arg" + std::to_string(a);
+				arg[type] = "objc_pointer";
+				arg[value] = "NSString *";
+				arg[encoding] = "@";
+				args.append(arg);
+			}
+			method[arguments] = args;
+			cls[methods][sel] = method;
+		}
+		Json::Value property;
+		property[name] = "title";
+		property[optional] = false;
+		property[type][type] = "objc_pointer";
+		property[type][value] = "NSString *";
+		property[type][encoding] = "@";
+		cls[properties]["title"] = property;
+		classes[className] = cls;
+	}
+	Json::Value root;
+	root["classes"] = classes;
+	return root;
+}
+
+template <typename F>
+static double timeIt (int runs, F fn) {
+	double best = 0;
+	for (int run = 0; run < runs; run++) {
+		auto start = std::chrono::high_resolution_clock::now();
+		fn();
+		auto end = std::chrono::high_resolution_clock::now();
+		double ms = std::chrono::duration<double, std::milli>(end - start).count();
+		if (run == 0 || ms < best) {
+			best = ms;
+		}
+	}
+	return best;
+}
+
+template <typename Key>
+static void reportBuild (const char *label, int classCount) {
+	auto before = heapUsage();
+	Json::Value root = buildDocument<Key>(classCount);
+	auto after = heapUsage();
+	auto ms = timeIt(5, [&]() {
+		Json::Value other = buildDocument<Key>(classCount);
+	});
+	std::cout << std::left << std::setw(28) << label << std::right << std::fixed << std::setprecision(2)
+		<< std::setw(10) << ms << " ms";
+	if (before.blocks >= 0) {
+		std::cout << std::setw(12) << (after.blocks - before.blocks) << " blocks";
+	}
+	if (before.bytes >= 0) {
+		std::cout << std::setw(14) << (after.bytes - before.bytes) << " bytes";
+	}
+	std::cout << std::endl;
+}
+
+int main (int argc, char* argv[]) {
+	const int classCount = argc > 1 ? atoi(argv[1]) : 5000;
+	size_t sink = 0;
+
+#ifdef JSON_USE_STD_MAP
+	const char *storage = "std::map";
+#else
+	const char *storage = "ObjectValues";
+#endif
+	std::cout << "document with " << classCount << " classes, objects stored in " << storage << std::endl;
+	reportBuild<const char *>("build (string keys)", classCount);
+	reportBuild<Json::StaticString>("build (static keys)", classCount);
+
+	Json::StreamWriterBuilder builder;
+	builder.settings_["indentation"] = "";
+	auto json = Json::writeString(builder, buildDocument<Json::StaticString>(classCount));
+	auto parse = timeIt(5, [&]() {
+		Json::Value parsed;
+		Json::Reader reader;
+		reader.parse(json, parsed, false);
+		sink += parsed["classes"].size();
+	});
+	std::cout << std::left << std::setw(28) << "parse" << std::right << std::setw(10) << parse << " ms" << std::endl;
+
+	Json::Value document = buildDocument<Json::StaticString>(classCount);
+	auto copy = timeIt(5, [&]() {
+		Json::Value copied = document;
+		sink += copied.size();
+	});
+	std::cout << std::left << std::setw(28) << "deep copy" << std::right << std::setw(10) << copy << " ms" << std::endl;
+
+	// a wide object filled out of key order and iterated once, which puts
+	// it in key order, then looked up member by member
+	std::vector<std::string> names;
+	for (int i = 0; i < 100000; i++) {
+		names.push_back("Symbol" + std::to_string((i * 7919) % 100000));
+	}
+	Json::Value wide;
+	auto fill = timeIt(3, [&]() {
+		Json::Value object;
+		for (size_t i = 0; i < names.size(); i++) {
+			object[names[i]] = static_cast<int>(i);
+		}
+		sink += object.begin().name().length();
+		wide.swap(object);
+	});
+	auto members = wide.getMemberNames();
+	auto sorted = names;
+	std::sort(sorted.begin(), sorted.end());
+	if (members != sorted) {
+		std::cerr << "wide object members are not in key order" << std::endl;
+		return EXIT_FAILURE;
+	}
+	auto lookup = timeIt(3, [&]() {
+		for (size_t i = 0; i < names.size(); i++) {
+			sink += wide.isMember(names[i]) ? 1 : 0;
+		}
+	});
+	std::cout << std::left << std::setw(28) << "wide object fill (100k)" << std::right << std::setw(10) << fill << " ms" << std::endl;
+	std::cout << std::left << std::setw(28) << "wide object lookup (100k)" << std::right << std::setw(10) << lookup << " ms" << std::endl;
+
+	return sink == 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
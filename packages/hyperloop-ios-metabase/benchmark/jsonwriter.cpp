@@ -0,0 +1,250 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ *
+ * Microbenchmark for the string escaping and integer formatting used by the
+ * bundled jsoncpp writer. Compares the current writer against the previous
+ * character-by-character implementation (kept below as the "legacy" writer)
+ * and checks that both produce identical output before timing them.
+ *
+ * Build and run from the package directory:
+ *
+ *   c++ -std=c++11 -O2 -march=native -Isrc benchmark/jsonwriter.cpp src/jsoncpp.cpp -o jsonwriter && ./jsonwriter
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "json/json.h"
+
+namespace legacy {
+
+	static bool isControlCharacter(char ch) { return ch > 0 && ch <= 0x1F; }
+
+	static bool containsControlCharacter0(const char* str, unsigned len) {
+		char const* end = str + len;
+		while (end != str) {
+			if (isControlCharacter(*str) || 0 == *str) {
+				return true;
+			}
+			++str;
+		}
+		return false;
+	}
+
+	static char const* strnpbrk(char const* s, char const* accept, size_t n) {
+		char const* const end = s + n;
+		for (char const* cur = s; cur < end; ++cur) {
+			int const c = *cur;
+			for (char const* a = accept; *a; ++a) {
+				if (*a == c) {
+					return cur;
+				}
+			}
+		}
+		return NULL;
+	}
+
+	static std::string valueToQuotedStringN(const char* value, unsigned length) {
+		if (strnpbrk(value, "\"\\\b\f\n\r\t", length) == NULL &&
+			!containsControlCharacter0(value, length)) {
+			return std::string("\"") + std::string(value, length) + "\"";
+		}
+		std::string result;
+		result.reserve(length * 2 + 3);
+		result += "\"";
+		char const* end = value + length;
+		for (const char* c = value; c != end; ++c) {
+			switch (*c) {
+				case '\"': result += "\\\""; break;
+				case '\\': result += "\\\\"; break;
+				case '\b': result += "\\b"; break;
+				case '\f': result += "\\f"; break;
+				case '\n': result += "\\n"; break;
+				case '\r': result += "\\r"; break;
+				case '\t': result += "\\t"; break;
+				default: {
+					if (isControlCharacter(*c) || *c == 0) {
+						std::ostringstream oss;
+						oss << "\\u" << std::hex << std::uppercase << std::setfill('0')
+							<< std::setw(4) << static_cast<int>(*c);
+						result += oss.str();
+					} else {
+						result += *c;
+					}
+					break;
+				}
+			}
+		}
+		result += "\"";
+		return result;
+	}
+
+	static std::string valueToString(Json::LargestInt value) {
+		char buffer[3 * sizeof(Json::LargestUInt) + 1];
+		char* current = buffer + sizeof(buffer);
+		bool negative = value < 0;
+		Json::LargestUInt v = negative ? Json::LargestUInt(0) - Json::LargestUInt(value) : Json::LargestUInt(value);
+		*--current = 0;
+		do {
+			*--current = static_cast<char>(v % 10U + static_cast<unsigned>('0'));
+			v /= 10;
+		} while (v != 0);
+		if (negative) {
+			*--current = '-';
+		}
+		return current;
+	}
+}
+
+/**
+ * corpus resembling metabase output: selectors, type spellings, encodings,
+ * absolute header paths and the occasional string that needs escaping
+ */
+static std::vector<std::string> makeStrings () {
+	const char *samples[] = {
+		"initWithFrame:",
+		"tableView:cellForRowAtIndexPath:",
+		"NSString *",
+		"void (^)(NSArray<NSURLSessionDataTask *> *, NSError *)",
+		"{CGRect={CGPoint=dd}{CGSize=dd}}",
+		"@",
+		"obj_interface",
+		"UIKit",
+		"/Applications/Xcode.app/Contents/Developer/Platforms/iPhoneSimulator.platform/Developer/SDKs/iPhoneSimulator.sdk/System/Library/Frameworks/UIKit.framework/Headers/UITableView.h",
+		"introducedIn",
+		"13.0.0",
+		"a \"quoted\" value",
+		"C:\\path\\with\\backslashes",
+		"line\nbreak\tand tab"
+	};
+	std::vector<std::string> strings;
+	for (int r = 0; r < 2000; r++) {
+		for (auto sample : samples) {
+			strings.push_back(sample);
+		}
+	}
+	// every single byte value once, so both writers are checked on all escapes
+	for (int c = 0; c < 256; c++) {
+		strings.push_back(std::string(1, static_cast<char>(c)) + "tail");
+	}
+	return strings;
+}
+
+static std::vector<Json::LargestInt> makeIntegers () {
+	std::vector<Json::LargestInt> values;
+	for (Json::LargestInt i = -5000; i < 50000; i++) {
+		values.push_back(i);
+	}
+	values.push_back(Json::Value::maxLargestInt);
+	values.push_back(Json::Value::minLargestInt + 1);
+	values.push_back(4294967295LL);
+	return values;
+}
+
+template <typename F>
+static double timeIt (size_t iterations, F fn) {
+	double best = 0;
+	for (int run = 0; run < 5; run++) {
+		auto start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < iterations; i++) {
+			fn();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		double ms = std::chrono::duration<double, std::milli>(end - start).count();
+		if (run == 0 || ms < best) {
+			best = ms;
+		}
+	}
+	return best;
+}
+
+static void report (const char *name, double legacyMs, double currentMs) {
+	std::cout << std::left << std::setw(24) << name
+		<< std::right << std::fixed << std::setprecision(2)
+		<< std::setw(12) << legacyMs << " ms"
+		<< std::setw(12) << currentMs << " ms"
+		<< std::setw(10) << (legacyMs / currentMs) << "x" << std::endl;
+}
+
+int main (int argc, char* argv[]) {
+	auto strings = makeStrings();
+	auto integers = makeIntegers();
+
+	for (auto &s : strings) {
+		auto expected = legacy::valueToQuotedStringN(s.data(), static_cast<unsigned>(s.length()));
+		// valueToQuotedString is the public entry point and stops at the first NUL
+		auto input = s.c_str();
+		auto actual = Json::valueToQuotedString(input);
+		auto expectedCStr = legacy::valueToQuotedStringN(input, static_cast<unsigned>(strlen(input)));
+		if (actual != expectedCStr) {
+			std::cerr << "mismatch escaping " << expected << ": " << actual << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	for (auto v : integers) {
+		if (Json::valueToString(v) != legacy::valueToString(v)) {
+			std::cerr << "mismatch formatting " << legacy::valueToString(v) << ": " << Json::valueToString(v) << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	size_t sink = 0;
+	std::cout << std::left << std::setw(24) << "benchmark" << std::right << std::setw(15) << "legacy" << std::setw(15) << "current" << std::setw(11) << "speedup" << std::endl;
+
+	auto legacyStrings = timeIt(20, [&]() {
+		for (auto &s : strings) {
+			sink += legacy::valueToQuotedStringN(s.c_str(), static_cast<unsigned>(strlen(s.c_str()))).length();
+		}
+	});
+	auto currentStrings = timeIt(20, [&]() {
+		for (auto &s : strings) {
+			sink += Json::valueToQuotedString(s.c_str()).length();
+		}
+	});
+	report("quoted strings", legacyStrings, currentStrings);
+
+	auto legacyInts = timeIt(20, [&]() {
+		for (auto v : integers) {
+			sink += legacy::valueToString(v).length();
+		}
+	});
+	auto currentInts = timeIt(20, [&]() {
+		for (auto v : integers) {
+			sink += Json::valueToString(v).length();
+		}
+	});
+	report("integers", legacyInts, currentInts);
+
+	// end to end: a metabase shaped document through the StreamWriter
+	Json::Value root;
+	for (int c = 0; c < 2000; c++) {
+		Json::Value cls;
+		cls["name"] = "Class" + std::to_string(c);
+		cls["framework"] = "UIKit";
+		cls["filename"] = strings[8];
+		cls["line"] = std::to_string(c);
+		cls["introducedIn"] = "9.0.0";
+		Json::Value enumValues;
+		for (int v = 0; v < 10; v++) {
+			enumValues["Value" + std::to_string(v)] = c * 10 + v;
+		}
+		cls["values"] = enumValues;
+		root["classes"]["Class" + std::to_string(c)] = cls;
+	}
+	Json::StreamWriterBuilder builder;
+	builder.settings_["indentation"] = "";
+	auto writeDocument = timeIt(5, [&]() {
+		sink += Json::writeString(builder, root).length();
+	});
+	std::cout << std::left << std::setw(24) << "document (compact)" << std::right << std::setw(30) << writeDocument << " ms" << std::endl;
+
+	return sink == 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,396 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ *
+ * Benchmark for the generator on a synthetic header corpus (see corpus.h).
+ * Every run parses the corpus from scratch and times parsing, traversal,
+ * class completion, resolution (toJSON) and serialization separately, then
+ * reports min, median, mean, standard deviation and max per phase.
+ *
+ * Built by CMakeLists.txt against a system libclang:
+ *
+ *   metabase-benchmark -classes 1000 -methods 12 -runs 10
+ *   metabase-benchmark -corpus /tmp/corpus -write-corpus
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ftw.h>
+#include <iomanip>
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "clang-c/Index.h"
+#include "corpus.h"
+#include "parallel.h"
+#include "parser.h"
+#include "stats.h"
+#include "util.h"
+#include "writer.h"
+
+/**
+ * return a std::map from command line args, flags followed by another flag
+ * or nothing are set to "true"
+ */
+static std::map<std::string, std::string> argvToMap (int argc, char* argv[]) {
+	std::map<std::string, std::string> args;
+	for (int i = 1; i < argc; i++) {
+		std::string arg(argv[i]);
+		if (hyperloop::startsWith(arg, '-')) {
+			args[arg] = i + 1 < argc && !hyperloop::startsWith(std::string(argv[i + 1]), '-') ? argv[i + 1] : "true";
+		}
+	}
+	return args;
+}
+
+static unsigned option (std::map<std::string, std::string> &args, const char *name, unsigned value) {
+	return args.count(name) ? static_cast<unsigned>(atoi(args[name].c_str())) : value;
+}
+
+static void showHelp () {
+	hyperloop::CorpusOptions defaults;
+	std::cout << "Usage: metabase-benchmark [option] <argument>" << std::endl << std::endl;
+	std::cout << "Corpus:" << std::endl;
+	std::cout << "  -frameworks N       frameworks to spread declarations over (" << defaults.frameworks << ")" << std::endl;
+	std::cout << "  -classes N          classes (" << defaults.classes << ")" << std::endl;
+	std::cout << "  -categories N       categories (" << defaults.categories << ")" << std::endl;
+	std::cout << "  -protocols N        protocols (" << defaults.protocols << ")" << std::endl;
+	std::cout << "  -methods N          methods per class, category and protocol (" << defaults.methods << ")" << std::endl;
+	std::cout << "  -properties N       properties per class, category and protocol (" << defaults.properties << ")" << std::endl;
+	std::cout << "  -blocks N           block typedefs (" << defaults.blocks << ")" << std::endl;
+	std::cout << "  -structs N          structs (" << defaults.structs << ")" << std::endl;
+	std::cout << "  -unions N           unions (" << defaults.unions << ")" << std::endl;
+	std::cout << "  -typedef-depth N    typedef chain length per struct (" << defaults.typedefDepth << ")" << std::endl;
+	std::cout << "  -seed N             seed for the choice of types (" << defaults.seed << ")" << std::endl;
+	std::cout << "  -module-maps        write a module map per framework and import frameworks by name" << std::endl;
+	std::cout << "  -corpus DIR         write the corpus to DIR and keep it, a temporary directory otherwise" << std::endl;
+	std::cout << "  -write-corpus       only write the corpus and print the umbrella header" << std::endl << std::endl;
+	std::cout << "Benchmark:" << std::endl;
+	std::cout << "  -runs N             measured runs (10)" << std::endl;
+	std::cout << "  -warmup N           runs before measuring (1)" << std::endl;
+	std::cout << "  -schema V           metabase api-version to serialize (1)" << std::endl;
+	std::cout << "  -threads N          threads resolving the definitions (" << hyperloop::defaultThreads() << ")" << std::endl;
+	std::cout << "  -pretty             serialize prettified JSON" << std::endl;
+	std::cout << "  -modules            parse the -module-maps corpus with clang modules, built by the" << std::endl;
+	std::cout << "                      first run into the corpus directory and reused by the others" << std::endl;
+	std::cout << "  -json FILE          also write the results as JSON" << std::endl;
+	std::cout << "  -check              fail unless the definitions found match the corpus, and the" << std::endl;
+	std::cout << "                      metabase resolved on -threads matches one resolved on one thread." << std::endl;
+	std::cout << "                      Also that the metabase writer, compact and pretty, gives the" << std::endl;
+	std::cout << "                      bytes of Json::writeString and index ranges of each definition" << std::endl;
+}
+
+static int removeEntry (const char *path, const struct stat *, int, struct FTW *) {
+	return remove(path);
+}
+
+static double elapsed (std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * true if the writer gives the same bytes as Json::writeString with the same
+ * settings, and each indexed range holds the JSON of its definition
+ */
+static bool writerMatches (const Json::Value &root, bool pretty) {
+	std::ostringstream out;
+	hyperloop::MetabaseWriter writer(out, pretty);
+	writer.write(root);
+	Json::StreamWriterBuilder builder;
+	if (pretty) {
+		builder.settings_["commentStyle"] = "None";
+		builder.settings_["indentation"] = "\t";
+	} else {
+		builder.settings_["indentation"] = "";
+	}
+	auto bytes = out.str();
+	if (bytes != Json::writeString(builder, root)) {
+		std::cerr << "metabase written " << (pretty ? "pretty" : "compact") << " differs from Json::writeString" << std::endl;
+		return false;
+	}
+	Json::CharReaderBuilder readerBuilder;
+	std::unique_ptr<Json::CharReader> reader(readerBuilder.newCharReader());
+	builder.settings_["indentation"] = "";
+	for (auto &entry : writer.getEntries()) {
+		Json::Value fragment;
+		auto begin = bytes.data() + entry.offset;
+		// tables are indexed whole under an empty name
+		auto &expected = entry.name.empty() ? root[entry.section] : root[entry.section][entry.name];
+		// compared as written, numbers read back signed whatever they were written as
+		if (!reader->parse(begin, begin + entry.length, &fragment, nullptr) ||
+			Json::writeString(builder, fragment) != Json::writeString(builder, expected)) {
+			std::cerr << "index range of " << entry.section << " " << entry.name << " written " << (pretty ? "pretty" : "compact") << " isn't its definition" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * timings of one phase over all measured runs
+ */
+struct Samples {
+	std::string phase;
+	std::vector<double> values;
+
+	double min () const { return *std::min_element(values.begin(), values.end()); }
+	double max () const { return *std::max_element(values.begin(), values.end()); }
+	double mean () const {
+		double sum = 0;
+		for (auto v : values) {
+			sum += v;
+		}
+		return sum / values.size();
+	}
+	double median () const {
+		auto sorted = values;
+		std::sort(sorted.begin(), sorted.end());
+		auto n = sorted.size();
+		return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+	}
+	double stddev () const {
+		if (values.size() < 2) {
+			return 0;
+		}
+		double m = mean(), sum = 0;
+		for (auto v : values) {
+			sum += (v - m) * (v - m);
+		}
+		return std::sqrt(sum / (values.size() - 1));
+	}
+};
+
+int main (int argc, char* argv[]) {
+	auto args = argvToMap(argc, argv);
+	if (args.count("-h")) {
+		showHelp();
+		return EXIT_FAILURE;
+	}
+
+	hyperloop::CorpusOptions options;
+	options.frameworks = option(args, "-frameworks", options.frameworks);
+	options.classes = option(args, "-classes", options.classes);
+	options.categories = option(args, "-categories", options.categories);
+	options.protocols = option(args, "-protocols", options.protocols);
+	options.methods = option(args, "-methods", options.methods);
+	options.properties = option(args, "-properties", options.properties);
+	options.blocks = option(args, "-blocks", options.blocks);
+	options.structs = option(args, "-structs", options.structs);
+	options.unions = option(args, "-unions", options.unions);
+	options.typedefDepth = option(args, "-typedef-depth", options.typedefDepth);
+	options.seed = option(args, "-seed", options.seed);
+	auto modules = args.count("-modules") > 0;
+	options.moduleMaps = modules || args.count("-module-maps") > 0;
+	auto runs = std::max(1u, option(args, "-runs", 10));
+	auto warmup = option(args, "-warmup", 1);
+	auto schema = args.count("-schema") ? args["-schema"] : "1";
+	auto prettify = args.count("-pretty") > 0;
+	auto threads = std::max(1u, option(args, "-threads", hyperloop::defaultThreads()));
+
+	if (!hyperloop::ParserTree::isSupportedAPIVersion(schema)) {
+		std::cerr << "unsupported schema version: " << schema << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::string dir = args.count("-corpus") ? args["-corpus"] : "";
+	bool temporary = dir.empty();
+	if (temporary) {
+		char path[] = "/tmp/hyperloop-corpus-XXXXXX";
+		if (!mkdtemp(path)) {
+			std::cerr << "couldn't create a temporary directory: " << strerror(errno) << std::endl;
+			return EXIT_FAILURE;
+		}
+		dir = path;
+	}
+	hyperloop::Corpus corpus(options);
+	if (!corpus.write(dir)) {
+		std::cerr << "couldn't write corpus to: " << dir << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (args.count("-write-corpus")) {
+		std::cout << corpus.getUmbrellaHeader() << std::endl;
+		return EXIT_SUCCESS;
+	}
+
+	// the SDK path only decides what counts as a system location, nothing in the corpus is
+	std::string sdkPath = "/Applications/Xcode.app/Contents/Developer/Platforms/iPhoneSimulator.platform/Developer/SDKs/iPhoneSimulator.sdk";
+	std::string minVersion = "9.0";
+	std::vector<const char *> clangArgs;
+	clangArgs.push_back("-x");
+	clangArgs.push_back("objective-c");
+	clangArgs.push_back("-fblocks");
+	clangArgs.push_back("-fobjc-abi-version=2");
+	auto moduleCache = "-fmodules-cache-path=" + dir + "/ModuleCache";
+	if (options.moduleMaps) {
+		clangArgs.push_back("-F");
+		clangArgs.push_back(dir.c_str());
+	}
+	if (modules) {
+		clangArgs.push_back("-fmodules");
+		clangArgs.push_back(moduleCache.c_str());
+	}
+	clangArgs.push_back(corpus.getUmbrellaHeader().c_str());
+
+	const char *phases[] = { "parse", "traverse", "complete", "resolve", "compact", "serialize", "total" };
+	std::vector<Samples> samples;
+	for (auto phase : phases) {
+		if (std::string(phase) == "compact" && schema == "1") {
+			continue;
+		}
+		Samples s;
+		s.phase = phase;
+		samples.push_back(s);
+	}
+
+	std::map<std::string, unsigned long long> counts;
+	size_t bytes = 0;
+	double coldParse = 0;
+	bool threadsMatch = true;
+	bool writerMatched = true;
+	for (unsigned run = 0; run < warmup + runs; run++) {
+		hyperloop::Stats stats;
+		auto start = std::chrono::steady_clock::now();
+		auto index = clang_createIndex(0, 0);
+		auto tu = clang_parseTranslationUnit(index, nullptr, &clangArgs[0], (int)clangArgs.size(), nullptr, 0, 0);
+		auto parse = elapsed(start);
+		if (!tu) {
+			std::cerr << "couldn't parse corpus: " << corpus.getUmbrellaHeader() << std::endl;
+			return EXIT_FAILURE;
+		}
+		auto ctx = hyperloop::parse(tu, sdkPath, minVersion, false, &stats);
+		ctx->setThreads(threads);
+		auto root = ctx->getParserTree()->toJSON(schema);
+		auto serializeStart = std::chrono::steady_clock::now();
+		std::ostringstream out;
+		hyperloop::MetabaseWriter writer(out, prettify);
+		writer.write(root);
+		auto serialize = elapsed(serializeStart);
+		auto total = elapsed(start);
+		bytes = writer.getBytesWritten();
+
+		if (run == 0 && args.count("-check")) {
+			writerMatched = writerMatches(root, false) && writerMatches(root, true);
+		}
+		if (run == 0 && threads > 1 && args.count("-check")) {
+			// a fresh model, so the serial resolve doesn't start from the threaded one's memos
+			auto serialCtx = hyperloop::parse(tu, sdkPath, minVersion, false);
+			auto serial = serialCtx->getParserTree()->toJSON(schema);
+			auto threaded = root;
+			serial["metadata"].removeMember("generated");
+			threaded["metadata"].removeMember("generated");
+			threadsMatch = serial == threaded;
+			delete serialCtx;
+		}
+		if (run == 0) {
+			// with -modules, the parse that builds the modules
+			coldParse = parse;
+			auto found = stats.toJSON()["counts"];
+			for (auto it = found.begin(); it != found.end(); it++) {
+				counts[it.name()] = it->asUInt64();
+			}
+		}
+		if (run >= warmup) {
+			for (auto &s : samples) {
+				if (s.phase == "parse") {
+					s.values.push_back(parse);
+				} else if (s.phase == "serialize") {
+					s.values.push_back(serialize);
+				} else if (s.phase == "total") {
+					s.values.push_back(total);
+				} else {
+					s.values.push_back(stats.getWallTime(s.phase));
+				}
+			}
+		}
+
+		delete ctx;
+		clang_disposeTranslationUnit(tu);
+		clang_disposeIndex(index);
+	}
+
+	if (temporary) {
+		nftw(dir.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+	}
+
+	std::cout << "corpus: " << options.classes << " classes, " << options.categories << " categories, "
+		<< options.protocols << " protocols, " << options.structs << " structs, " << options.unions << " unions, "
+		<< options.blocks << " blocks over " << options.frameworks << " frameworks" << std::endl;
+	std::cout << "found:";
+	for (auto it = counts.begin(); it != counts.end(); it++) {
+		std::cout << " " << it->first << "=" << it->second;
+	}
+	std::cout << std::endl;
+	std::cout << "metabase: " << bytes << " bytes, peak RSS " << hyperloop::Stats::peakRSS() / (1024 * 1024) << " MB, "
+		<< runs << " runs after " << warmup << " warmup, " << threads << " resolve threads" << std::endl;
+	if (modules) {
+		std::cout << "modules: first parse " << std::fixed << std::setprecision(2) << coldParse << " ms, building them" << std::endl;
+	}
+	std::cout << std::endl;
+
+	std::cout << std::left << std::setw(12) << "phase" << std::right
+		<< std::setw(12) << "min" << std::setw(12) << "median" << std::setw(12) << "mean"
+		<< std::setw(12) << "stddev" << std::setw(12) << "max" << std::endl;
+	Json::Value results;
+	for (auto &s : samples) {
+		std::cout << std::left << std::setw(12) << s.phase << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(12) << s.min() << std::setw(12) << s.median() << std::setw(12) << s.mean()
+			<< std::setw(12) << s.stddev() << std::setw(12) << s.max() << std::endl;
+		Json::Value phase;
+		phase["min"] = s.min();
+		phase["median"] = s.median();
+		phase["mean"] = s.mean();
+		phase["stddev"] = s.stddev();
+		phase["max"] = s.max();
+		results["phases"][s.phase] = phase;
+	}
+
+	if (args.count("-json")) {
+		for (auto it = counts.begin(); it != counts.end(); it++) {
+			results["counts"][it->first] = static_cast<Json::UInt64>(it->second);
+		}
+		results["bytes"] = static_cast<Json::UInt64>(bytes);
+		results["peakRSS"] = static_cast<Json::Int64>(hyperloop::Stats::peakRSS());
+		results["runs"] = runs;
+		if (modules) {
+			results["coldParse"] = coldParse;
+		}
+		std::ofstream json(args["-json"]);
+		json << results << std::endl;
+		if (json.fail()) {
+			std::cerr << "couldn't write results to: " << args["-json"] << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (args.count("-check")) {
+		auto expected = corpus.getExpectedCounts();
+		bool matches = true;
+		for (auto it = expected.begin(); it != expected.end(); it++) {
+			if (counts[it->first] != it->second) {
+				std::cerr << "expected " << it->second << " " << it->first << ", found " << counts[it->first] << std::endl;
+				matches = false;
+			}
+		}
+		if (!threadsMatch) {
+			std::cerr << "metabase resolved on " << threads << " threads differs from the one resolved on one thread" << std::endl;
+			matches = false;
+		}
+		if (!writerMatched) {
+			matches = false;
+		}
+		if (!matches) {
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
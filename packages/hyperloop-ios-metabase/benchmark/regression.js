@@ -0,0 +1,291 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ *
+ * Performance regression check for the generator. Runs the metabase binary
+ * over a pinned corpus, the test/fixtures headers plus two synthetic corpora
+ * written by metabase-benchmark, and compares wall time, peak RSS and output
+ * size against benchmark/baseline.json. Exits with 1 when any metric is worse
+ * than the baseline by more than its tolerance. Needs no SDK, so it runs on
+ * Linux from ctest (see CMakeLists.txt):
+ *
+ *   node benchmark/regression.js -metabase build/cmake/metabase -benchmark build/cmake/metabase-benchmark
+ *   node benchmark/regression.js ... -update
+ *
+ * Wall time is scaled by a short CPU calibration loop measured on both the
+ * baseline machine and this one, so the baseline can be checked in. The loop
+ * is timed again before every run of every case, and the fastest ratio of a
+ * run's wall time to the calibration before it is what gets compared, so a
+ * machine slowing down mid-check moves both. Even so wall time varies more
+ * than the other metrics, and ctest passes -wall-advisory to report it
+ * without failing on it. Output
+ * size is measured without the directories the output names, the checkout
+ * and the temporary directory, so it doesn't depend on where either is.
+ */
+'use strict';
+
+var spawnSync = require('child_process').spawnSync,
+	path = require('path'),
+	fs = require('fs'),
+	os = require('os'),
+	fixtures = path.join(__dirname, '..', 'test', 'fixtures'),
+	// fixtures that need the iOS SDK to mean anything
+	sdkFixtures = ['empty_class_with_systemheaders.h'],
+	defaultTolerance = {
+		wall: { ratio: 0.25, slack: 20 },
+		rss: { ratio: 0.15, slack: 8388608 },
+		bytes: { ratio: 0.01, slack: 0 }
+	},
+	cases = [
+		{ name: 'fixtures', fixtures: true },
+		{ name: 'synthetic-small', corpus: [] },
+		{ name: 'synthetic-large', corpus: [
+			'-classes', '1000', '-categories', '200', '-protocols', '200', '-methods', '12',
+			'-structs', '200', '-unions', '40', '-blocks', '100'
+		] }
+	];
+
+/**
+ * return an object from command line args, flags followed by another flag
+ * or nothing are set to true
+ */
+function argvToMap (argv) {
+	var args = {};
+	for (var i = 0; i < argv.length; i++) {
+		if (argv[i].charAt(0) === '-') {
+			args[argv[i]] = i + 1 < argv.length && argv[i + 1].charAt(0) !== '-' ? argv[i + 1] : true;
+		}
+	}
+	return args;
+}
+
+function showHelp () {
+	console.log('Usage: node regression.js -metabase <binary> -benchmark <binary> [option] <argument>');
+	console.log('');
+	console.log('  -metabase FILE      metabase binary to measure');
+	console.log('  -benchmark FILE     metabase-benchmark binary, writes the synthetic corpora');
+	console.log('  -baseline FILE      baseline to compare against (benchmark/baseline.json)');
+	console.log('  -runs N             runs per case, the fastest wall time and median RSS and size are compared (5)');
+	console.log('  -update             write the measurements as the new baseline');
+	console.log('  -no-calibrate       compare wall time without scaling it to this machine');
+	console.log('  -wall-advisory      report wall time regressions without failing on them');
+}
+
+function median (values) {
+	var sorted = values.slice().sort(function (a, b) { return a - b; });
+	return sorted[Math.floor(sorted.length / 2)];
+}
+
+/**
+ * milliseconds for a fixed amount of integer work, the fastest of tries.
+ * It allocates nothing, so garbage collection doesn't add noise.
+ */
+function calibrate (tries) {
+	var best = Infinity,
+		hash = 0;
+	for (var run = 0; run < tries; run++) {
+		var start = process.hrtime();
+		hash = 2166136261;
+		for (var i = 0; i < 20000000; i++) {
+			hash ^= i & 255;
+			hash = Math.imul(hash, 16777619);
+		}
+		var elapsed = process.hrtime(start);
+		best = Math.min(best, elapsed[0] * 1000 + elapsed[1] / 1e6);
+	}
+	// keep the loop from being optimized away
+	return hash === 0 ? best + 1e-9 : best;
+}
+
+function run (bin, args) {
+	var result = spawnSync(bin, args, { encoding: 'utf8' });
+	if (result.error) {
+		throw result.error;
+	}
+	if (result.status !== 0) {
+		throw new Error(path.basename(bin) + ' ' + args.join(' ') + ' failed with exit code ' + result.status);
+	}
+	return result.stdout;
+}
+
+/**
+ * bytes of the output once every directory in dirs is taken out of it,
+ * longest first as the corpora are written inside the temporary directory
+ */
+function pinnedSize (output, dirs) {
+	var text = fs.readFileSync(output, 'utf8');
+	dirs.slice().sort(function (a, b) { return b.length - a.length; }).forEach(function (dir) {
+		text = text.split(dir).join('');
+	});
+	return Buffer.byteLength(text);
+}
+
+/**
+ * run the generator on one header, returns its total wall time, peak RSS
+ * and output size
+ */
+function generate (bin, tmpdir, header, extraArgs) {
+	var output = path.join(tmpdir, 'metabase.json'),
+		statsfile = path.join(tmpdir, 'metabase.stats.json');
+	run(bin, [
+		'-i', header,
+		'-o', output,
+		'-sim-sdk-path', tmpdir,
+		'-min-ios-ver', '9.0',
+		'-stats', statsfile
+	].concat(extraArgs));
+	var stats = JSON.parse(fs.readFileSync(statsfile));
+	return {
+		wall: stats.total.wall,
+		rss: stats.peakRSS,
+		bytes: pinnedSize(output, [path.dirname(header), tmpdir])
+	};
+}
+
+/**
+ * each metric over the runs of one case, with the calibration timed before
+ * each run
+ */
+function measure (testCase, args, tmpdir, runs) {
+	var headers = [],
+		extraArgs = [],
+		samples = { wall: [], rss: [], bytes: [], ratio: [], calibration: [] };
+	if (testCase.fixtures) {
+		headers = fs.readdirSync(fixtures).filter(function (name) {
+			return /\.h$/.test(name) && sdkFixtures.indexOf(name) < 0;
+		}).sort().map(function (name) {
+			return path.join(fixtures, name);
+		});
+		extraArgs = ['-x'];
+	} else {
+		var dir = path.join(tmpdir, testCase.name);
+		headers = [run(args['-benchmark'], ['-corpus', dir, '-write-corpus'].concat(testCase.corpus)).trim()];
+		extraArgs = ['-hsp', dir];
+	}
+	for (var i = 0; i < runs; i++) {
+		var total = { wall: 0, rss: 0, bytes: 0, calibration: calibrate(3) };
+		headers.forEach(function (header) {
+			var result = generate(args['-metabase'], tmpdir, header, extraArgs);
+			total.wall += result.wall;
+			total.rss = Math.max(total.rss, result.rss);
+			total.bytes += result.bytes;
+		});
+		total.ratio = total.wall / total.calibration;
+		Object.keys(samples).forEach(function (metric) {
+			samples[metric].push(total[metric]);
+		});
+	}
+	// the fastest run is the least disturbed by whatever else the machine is doing
+	return {
+		wall: Math.min.apply(Math, samples.wall),
+		ratio: Math.min.apply(Math, samples.ratio),
+		calibration: Math.min.apply(Math, samples.calibration),
+		rss: median(samples.rss),
+		bytes: median(samples.bytes)
+	};
+}
+
+function pad (value, width) {
+	value = String(value);
+	while (value.length < width) {
+		value = ' ' + value;
+	}
+	return value;
+}
+
+/**
+ * compare the measurements with the baseline, returns the number of
+ * regressions. wall time is compared in milliseconds on this machine, scale
+ * times the baseline's
+ */
+function compare (baseline, results, scale, wallAdvisory) {
+	var regressions = 0,
+		tolerance = baseline.tolerance || defaultTolerance;
+	console.log(pad('case', 18) + pad('metric', 8) + pad('baseline', 14) + pad('current', 14) + pad('limit', 14) + '  status');
+	Object.keys(results).forEach(function (name) {
+		var expected = baseline.cases[name];
+		Object.keys(defaultTolerance).forEach(function (metric) {
+			var current = results[name][metric],
+				status = 'ok',
+				reference, limit;
+			if (!expected || expected[metric] === undefined) {
+				console.log(pad(name, 18) + pad(metric, 8) + pad('-', 14) + pad(current, 14) + pad('-', 14) + '  new');
+				return;
+			}
+			var range = tolerance[metric] || defaultTolerance[metric];
+			reference = metric === 'wall' ? expected[metric] * scale : expected[metric];
+			limit = reference * (1 + range.ratio) + range.slack;
+			if (current > limit && metric === 'wall' && wallAdvisory) {
+				status = 'slower';
+			} else if (current > limit) {
+				status = 'REGRESSED';
+				regressions++;
+			} else if (current < reference * (1 - range.ratio) - range.slack) {
+				status = 'improved';
+			}
+			console.log(pad(name, 18) + pad(metric, 8) + pad(Math.round(reference), 14) + pad(Math.round(current), 14) + pad(Math.round(limit), 14) + '  ' + status);
+		});
+	});
+	return regressions;
+}
+
+function main () {
+	var args = argvToMap(process.argv.slice(2));
+	if (args['-h'] || !args['-metabase'] || !args['-benchmark']) {
+		showHelp();
+		return args['-h'] ? 0 : 1;
+	}
+	var baselineFile = args['-baseline'] || path.join(__dirname, 'baseline.json'),
+		runs = parseInt(args['-runs'] || 5, 10),
+		baseline = fs.existsSync(baselineFile) ? JSON.parse(fs.readFileSync(baselineFile)) : null,
+		tmpdir = fs.mkdtempSync(path.join(os.tmpdir(), 'metabase-regression-')),
+		measured = {},
+		results = {},
+		calibration = Infinity;
+
+	try {
+		cases.forEach(function (testCase) {
+			measured[testCase.name] = measure(testCase, args, tmpdir, runs);
+			calibration = Math.min(calibration, measured[testCase.name].calibration);
+		});
+	} finally {
+		fs.rmSync(tmpdir, { recursive: true, force: true });
+	}
+
+	// wall time as the fastest ratio to the calibration, in milliseconds at
+	// the fastest calibration of the whole check
+	Object.keys(measured).forEach(function (name) {
+		var m = measured[name];
+		results[name] = {
+			wall: Math.round((args['-no-calibrate'] ? m.wall : m.ratio * calibration) * 1000) / 1000,
+			rss: m.rss,
+			bytes: m.bytes
+		};
+	});
+
+	if (args['-update']) {
+		var updated = {
+			calibration: Math.round(calibration * 1000) / 1000,
+			tolerance: baseline && baseline.tolerance || defaultTolerance,
+			cases: results
+		};
+		fs.writeFileSync(baselineFile, JSON.stringify(updated, null, '\t') + '\n');
+		console.log('wrote baseline ' + baselineFile);
+		return 0;
+	}
+	if (!baseline) {
+		console.error('no baseline at ' + baselineFile + ', create it with -update');
+		return 1;
+	}
+
+	var scale = args['-no-calibrate'] || !baseline.calibration ? 1 : calibration / baseline.calibration;
+	console.log('wall time scaled by ' + scale.toFixed(2) + ' for this machine');
+	var regressions = compare(baseline, results, scale, !!args['-wall-advisory']);
+	if (regressions > 0) {
+		console.error(regressions + ' metric(s) regressed beyond the baseline tolerance');
+		return 1;
+	}
+	return 0;
+}
+
+process.exitCode = main();
@@ -299,6 +299,84 @@ function collectFrameworkHeaders(frameworkPath) {
 	return headerFiles;
 }
 
+/**
+ * expand a compact (api-version 2) metabase into the legacy layout, metabases
+ * already in the legacy layout are returned unchanged
+ *
+ * @param {Object} json the parsed metabase
+ * @return {Object} the metabase with file, framework and type references resolved
+ */
+function expandMetabase (json) {
+	if (!json || !json.metadata || json.metadata['api-version'] !== '2') {
+		return json;
+	}
+	const files = json.files || [],
+		frameworks = json.frameworks || [],
+		types = json.types || [];
+
+	function expandType (index, into) {
+		into = into || {};
+		const type = types[index];
+		Object.keys(type).forEach(key => {
+			into[key] = type[key];
+		});
+		return into;
+	}
+
+	function expandArgument (arg) {
+		if (typeof arg.type === 'number') {
+			const index = arg.type;
+			delete arg.type;
+			expandType(index, arg);
+		}
+		arg.fields && arg.fields.forEach(expandArgument);
+		return arg;
+	}
+
+	function expandDefinition (def) {
+		if (typeof def.file === 'number') {
+			const file = files[def.file];
+			def.filename = file.filename;
+			def.framework = frameworks[file.framework];
+			def.thirdparty = file.thirdparty;
+			delete def.file;
+		}
+		if (typeof def.returns === 'number') {
+			def.returns = expandType(def.returns);
+		}
+		def.arguments && def.arguments.forEach(expandArgument);
+		def.fields && def.fields.forEach(expandArgument);
+		def.methods && Object.keys(def.methods).forEach(name => expandDefinition(def.methods[name]));
+		def.properties && Object.keys(def.properties).forEach(name => {
+			const property = def.properties[name];
+			if (typeof property.type === 'number') {
+				property.type = expandType(property.type);
+			}
+		});
+		return def;
+	}
+
+	Object.keys(json).forEach(section => {
+		if (section === 'metadata' || section === 'files' || section === 'frameworks' || section === 'types') {
+			return;
+		}
+		const definitions = json[section];
+		Object.keys(definitions).forEach(name => {
+			if (Array.isArray(definitions[name])) {
+				// blocks are grouped by framework
+				definitions[name].forEach(expandDefinition);
+			} else {
+				expandDefinition(definitions[name]);
+			}
+		});
+	});
+	delete json.files;
+	delete json.frameworks;
+	delete json.types;
+	json.metadata['api-version'] = '1';
+	return json;
+}
+
 /**
  * generate a metabase
  *
@@ -317,6 +395,8 @@ function generateMetabase (buildDir, sdk, sdkPath, iosMinVersion, includes, excl
 	var cacheToken = createHashFromString(sdkPath + iosMinVersion + excludeSystem + JSON.stringify(includes));
 	var header = path.join(buildDir, 'metabase-' + iosMinVersion + '-' + sdk + '-' + cacheToken + '.h');
 	var outfile = path.join(buildDir, 'metabase-' + iosMinVersion + '-' + sdk + '-' + cacheToken + '.json');
+	var statsfile = path.join(buildDir, 'metabase-' + iosMinVersion + '-' + sdk + '-' + cacheToken + '.stats.json');
+	var diagnosticsfile = path.join(buildDir, 'metabase-' + iosMinVersion + '-' + sdk + '-' + cacheToken + '.diagnostics.json');
 
 	// Foundation header always needs to be included
 	var absoluteFoundationHeaderRegex = /Foundation\.framework\/Headers\/Foundation\.h$/;
@@ -331,7 +411,7 @@ function generateMetabase (buildDir, sdk, sdkPath, iosMinVersion, includes, excl
 	// check for cached version and attempt to return if found
 	if (!force && fs.existsSync(header) && fs.existsSync(outfile)) {
 		try {
-			var json = JSON.parse(fs.readFileSync(outfile));
+			var json = expandMetabase(JSON.parse(fs.readFileSync(outfile)));
 			json.$includes = includes;
 			return callback(null, json, path.resolve(outfile), path.resolve(header), true);
 		}
@@ -361,7 +441,8 @@ function generateMetabase (buildDir, sdk, sdkPath, iosMinVersion, includes, excl
 		'-o', path.resolve(outfile),
 		'-sim-sdk-path', sdkPath,
 		'-min-ios-ver', iosMinVersion,
-		'-pretty'
+		'-stats', path.resolve(statsfile),
+		'-diagnostics', path.resolve(diagnosticsfile)
 	];
 	if (excludeSystem) {
 		args.push('-x');
@@ -397,21 +478,118 @@ function generateMetabase (buildDir, sdk, sdkPath, iosMinVersion, includes, excl
 			util.logger.debug(String(buf).replace(/\n$/,''));
 		});
 		child.stderr.on('data', function (buf) {
-			// Without this, for whatever reason, the metabase parser never returns
+			// diagnostics go to a file, but stderr still has to be drained or
+			// the child blocks once the pipe fills up
+			util.logger.debug(String(buf).replace(/\n$/,''));
 		});
 		child.on('error', callback);
 		child.on('exit', function (ex) {
 			util.logger.trace('metabase took', (Date.now()-ts), 'ms to generate');
+			logMetabaseStats(statsfile);
+			logMetabaseDiagnostics(diagnosticsfile);
 			if (ex) {
 				return callback(new Error('Metabase generation failed'));
 			}
-			var json = JSON.parse(fs.readFileSync(outfile));
+			var json = expandMetabase(JSON.parse(fs.readFileSync(outfile)));
 			json.$includes = includes;
 			return callback(null, json, path.resolve(outfile), path.resolve(header), false);
 		});
 	})(binary, args);
 }
 
+/**
+ * generate the per framework metabases of an SDK into a cache shared by
+ * builds, frameworks already in the cache are kept
+ *
+ * @param {String} cacheDir directory of the SDK cache, <sdk version>/<min version> is created below it
+ * @param {String} sdkPath the path to the SDK
+ * @param {String} iosMinVersion the min version such as 9.0
+ * @param {Function} callback function to receive the result which will be (err, index, dir)
+ * @param {Boolean} force if true, will generate every framework again
+ */
+function generateSDKMetabases (cacheDir, sdkPath, iosMinVersion, callback, force) {
+	var args = [
+		'sdk',
+		'-o', path.resolve(cacheDir),
+		'-sim-sdk-path', sdkPath,
+		'-min-ios-ver', iosMinVersion
+	];
+	if (force) {
+		args.push('-force');
+	}
+	util.logger.trace('running', binary, 'with', args.join(' '));
+	var ts = Date.now();
+	var child = spawn(binary, args),
+		output = '';
+	child.stdout.on('data', function (buf) {
+		output += String(buf);
+	});
+	child.stderr.on('data', function (buf) {
+		util.logger.debug(String(buf).replace(/\n$/,''));
+	});
+	child.on('error', callback);
+	child.on('exit', function (ex) {
+		util.logger.trace('SDK metabases took', (Date.now()-ts), 'ms to generate');
+		// the cache directory is printed, along with an index even if some frameworks failed
+		var dir = output.trim(),
+			index = path.join(dir, 'index.json');
+		if (!dir || !fs.existsSync(index)) {
+			return callback(new Error('SDK metabase generation failed'));
+		}
+		var json = JSON.parse(fs.readFileSync(index));
+		if (ex) {
+			util.logger.warn('SDK metabases failed for', Object.keys(json.frameworks).filter(function (name) {
+				return json.frameworks[name].status !== 'ok';
+			}).join(', '));
+		}
+		return callback(null, json, dir);
+	});
+}
+
+/**
+ * log the phase timings and counters written by the metabase generator with -stats
+ * @param {String} statsfile path to the stats JSON file
+ */
+function logMetabaseStats (statsfile) {
+	var stats;
+	try {
+		stats = JSON.parse(fs.readFileSync(statsfile));
+	} catch (e) {
+		// older binaries don't write stats
+		return;
+	}
+	(stats.phases || []).forEach(function (phase) {
+		util.logger.trace('metabase ' + phase.name + ' took ' + Math.round(phase.wall) + ' ms (' + Math.round(phase.cpu) + ' ms cpu)');
+	});
+	var counts = stats.counts || {};
+	util.logger.trace('metabase ' + Object.keys(counts).map(function (key) {
+		return key + ': ' + counts[key];
+	}).join(', '));
+	util.logger.trace('metabase wrote ' + stats.bytesWritten + ' bytes, peak memory ' + Math.round(stats.peakRSS / 1048576) + ' MB');
+}
+
+/**
+ * log the diagnostics written by the metabase generator with -diagnostics,
+ * clang errors as warnings and everything else at trace level
+ * @param {String} diagnosticsfile path to the diagnostics JSON file
+ */
+function logMetabaseDiagnostics (diagnosticsfile) {
+	var diagnostics;
+	try {
+		diagnostics = JSON.parse(fs.readFileSync(diagnosticsfile));
+	} catch (e) {
+		// older binaries don't write diagnostics
+		return;
+	}
+	(diagnostics.kinds || []).forEach(function (kind) {
+		var level = /^clang\.(error|fatal)$/.test(kind.kind) ? 'warn' : 'trace';
+		util.logger[level]('metabase ' + kind.kind + ': ' + kind.count + ' time(s)');
+		kind.examples.forEach(function (example) {
+			util.logger[level]('  ' + (example.filename ? example.filename + ':' + example.line + ': ' : '') + example.message);
+		});
+	});
+}
+
 /**
  * return the system frameworks mappings as JSON for a given sdkType and minVersion
  */
@@ -1320,6 +1498,8 @@ exports.getSystemFrameworks = getSystemFrameworks;
 exports.generateUserSourceMappings = generateUserSourceMappings;
 exports.generateUserFrameworksMetadata = generateUserFrameworksMetadata;
 exports.generateMetabase = generateMetabase;
+exports.generateSDKMetabases = generateSDKMetabases;
+exports.expandMetabase = expandMetabase;
 exports.generateCocoaPods = generateCocoaPods;
 exports.compileResources = compileResources;
 exports.recursiveReadDir = recursiveReadDir;
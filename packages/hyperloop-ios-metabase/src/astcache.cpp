@@ -0,0 +1,173 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "astcache.h"
+#include "diagnostics.h"
+#include "util.h"
+#include "json/json.h"
+
+#define ASTCACHE_VERSION "1"
+
+namespace hyperloop {
+
+	/**
+	 * 64-bit FNV-1a hash of data as hex
+	 */
+	static std::string hashString (const std::string &data) {
+		unsigned long long hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < data.size(); i++) {
+			hash ^= static_cast<unsigned char>(data[i]);
+			hash *= 1099511628211ULL;
+		}
+		char buf[17];
+		snprintf(buf, sizeof(buf), "%016llx", hash);
+		return buf;
+	}
+
+	/**
+	 * hash of the contents of a file, returns false if it can't be read
+	 */
+	static bool hashFile (const std::string &path, std::string &hash) {
+		std::ifstream in(path, std::ios::in | std::ios::binary);
+		if (!in) {
+			return false;
+		}
+		std::ostringstream buffer;
+		buffer << in.rdbuf();
+		hash = hashString(buffer.str());
+		return true;
+	}
+
+	static bool readJSON (const std::string &path, Json::Value &json) {
+		std::ifstream in(path);
+		Json::CharReaderBuilder builder;
+		std::string errors;
+		return !in.fail() && Json::parseFromStream(builder, in, &json, &errors) && json.isObject();
+	}
+
+	static void visitInclusion (CXFile file, CXSourceLocation *stack, unsigned depth, CXClientData clientData) {
+		static_cast<std::vector<std::string> *>(clientData)->push_back(CXStringToString(clang_getFileName(file)));
+	}
+
+	/**
+	 * true if the manifest was written for args and every file it lists
+	 * still has the same contents
+	 */
+	static bool isCurrent (const Json::Value &manifest, const Json::Value &arguments) {
+		if (manifest["version"] != ASTCACHE_VERSION || manifest["arguments"] != arguments) {
+			return false;
+		}
+		auto &files = manifest["files"];
+		for (auto it = files.begin(); it != files.end(); it++) {
+			std::string hash;
+			if (!hashFile(it.name(), hash) || hash != it->asString()) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * save tu with a manifest of the files it read, both are written to
+	 * temporary files and renamed so a concurrent run never loads half of one.
+	 * The temporary names are unique per save, as batch groups parsing the
+	 * same arguments may save to the same path from several threads at once
+	 */
+	static void save (CXTranslationUnit tu, const std::string &cacheDir, const std::string &path, const Json::Value &arguments, const Json::Value &diagnostics) {
+		if (mkdir(cacheDir.c_str(), 0755) != 0 && errno != EEXIST) {
+			return;
+		}
+		std::vector<std::string> included;
+		clang_getInclusions(tu, visitInclusion, &included);
+		Json::Value manifest;
+		manifest["version"] = ASTCACHE_VERSION;
+		manifest["arguments"] = arguments;
+		manifest["files"] = Json::Value(Json::objectValue);
+		for (auto it = included.begin(); it != included.end(); it++) {
+			std::string hash;
+			if (!hashFile(*it, hash)) {
+				return;
+			}
+			manifest["files"][*it] = hash;
+		}
+		manifest["diagnostics"] = diagnostics;
+
+		static std::atomic<unsigned> saves(0);
+		auto suffix = ".tmp" + std::to_string(getpid()) + "-" + std::to_string(saves++);
+		if (clang_saveTranslationUnit(tu, (path + ".ast" + suffix).c_str(), clang_defaultSaveOptions(tu)) != CXSaveError_None) {
+			remove((path + ".ast" + suffix).c_str());
+			return;
+		}
+		std::ofstream out(path + ".json" + suffix);
+		Json::StreamWriterBuilder builder;
+		builder.settings_["indentation"] = "";
+		out << Json::writeString(builder, manifest) << std::endl;
+		out.close();
+		if (out.fail() || rename((path + ".ast" + suffix).c_str(), (path + ".ast").c_str()) != 0) {
+			remove((path + ".ast" + suffix).c_str());
+			remove((path + ".json" + suffix).c_str());
+			return;
+		}
+		rename((path + ".json" + suffix).c_str(), (path + ".json").c_str());
+	}
+
+	CXTranslationUnit parseTranslationUnit (CXIndex index, const std::vector<std::string> &args, const std::string &cacheDir, Diagnostics &diagnostics, bool *reused) {
+		if (reused) {
+			*reused = false;
+		}
+		std::vector<const char *> argv;
+		for (auto it = args.begin(); it != args.end(); it++) {
+			argv.push_back(it->c_str());
+		}
+		if (cacheDir.empty()) {
+			auto tu = clang_parseTranslationUnit(index, nullptr, &argv[0], (int)argv.size(), nullptr, 0, 0);
+			if (tu) {
+				diagnostics.addTranslationUnit(tu);
+			}
+			return tu;
+		}
+
+		// an AST can only be read by the libclang that wrote it
+		Json::Value arguments(Json::arrayValue);
+		arguments.append(CXStringToString(clang_getClangVersion()));
+		for (auto it = args.begin(); it != args.end(); it++) {
+			arguments.append(*it);
+		}
+		std::string key;
+		for (auto it = arguments.begin(); it != arguments.end(); it++) {
+			key += it->asString() + '\n';
+		}
+		auto path = cacheDir + "/" + hashString(key);
+
+		Json::Value manifest;
+		if (readJSON(path + ".json", manifest) && isCurrent(manifest, arguments)) {
+			CXTranslationUnit tu;
+			if (clang_createTranslationUnit2(index, (path + ".ast").c_str(), &tu) == CXError_Success) {
+				// a loaded AST has none of the diagnostics of its parse
+				diagnostics.merge(manifest["diagnostics"]);
+				if (reused) {
+					*reused = true;
+				}
+				return tu;
+			}
+		}
+
+		auto tu = clang_parseTranslationUnit(index, nullptr, &argv[0], (int)argv.size(), nullptr, 0, 0);
+		if (tu) {
+			Diagnostics parsed(static_cast<unsigned>(-1));
+			parsed.addTranslationUnit(tu);
+			auto json = parsed.toJSON();
+			diagnostics.merge(json);
+			save(tu, cacheDir, path, arguments, json);
+		}
+		return tu;
+	}
+}
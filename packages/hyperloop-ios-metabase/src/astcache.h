@@ -0,0 +1,31 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_ASTCACHE_H
+#define HYPERLOOP_ASTCACHE_H
+
+#include <string>
+#include <vector>
+
+#include "clang-c/Index.h"
+
+namespace hyperloop {
+
+	class Diagnostics;
+
+	/**
+	 * parse the translation unit of the compiler arguments args and record
+	 * clang's diagnostics for it. With a cacheDir, the parsed translation
+	 * unit is saved there as <key>.ast, keyed by a hash of the arguments and
+	 * the libclang version, with a <key>.json listing the content hash of
+	 * every file it read and its diagnostics. A later parse of the same
+	 * arguments loads it with clang_createTranslationUnit instead, skipping
+	 * the preprocessor and semantic analysis, as long as none of those files
+	 * changed. reused, if given, tells whether it was loaded from the cache.
+	 * Returns nullptr if the header can't be parsed
+	 */
+	CXTranslationUnit parseTranslationUnit (CXIndex index, const std::vector<std::string> &args, const std::string &cacheDir, Diagnostics &diagnostics, bool *reused = nullptr);
+}
+
+#endif
@@ -0,0 +1,483 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "batch.h"
+#include "astcache.h"
+#include "diagnostics.h"
+#include "index.h"
+#include "parallel.h"
+#include "parser.h"
+#include "util.h"
+#include "writer.h"
+#include "json/json.h"
+
+namespace hyperloop {
+
+	/**
+	 * one metabase of the manifest and what became of it
+	 */
+	struct Job {
+		Job () : excludeSys(false), pretty(false), writeIndex(false), ok(false), astReused(false), reparsed(false), group(0), parse(0), write(0), bytes(0), diagnostics(0) {}
+		std::string name;
+		std::string header;
+		std::string output;
+		std::string sdkPath;
+		std::string minVersion;
+		std::string schema;
+		std::string moduleCache;
+		std::string astCache;
+		std::vector<std::string> includes;
+		std::vector<std::string> frameworks;
+		bool excludeSys;
+		bool pretty;
+		bool writeIndex;
+
+		bool ok;
+		bool astReused;
+		bool reparsed;
+		std::string error;
+		size_t group;
+		double parse;
+		double write;
+		size_t bytes;
+		unsigned long long diagnostics;
+	};
+
+	static double millisSince (std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	/**
+	 * a string option, flags may also be given as true
+	 */
+	static std::string stringOption (const Json::Value &options, const char *key) {
+		auto &value = options[key];
+		if (value.isBool()) {
+			return value.asBool() ? "true" : "";
+		}
+		return value.isNull() ? "" : value.asString();
+	}
+
+	/**
+	 * search paths as an array or comma separated like -hsp
+	 */
+	static std::vector<std::string> pathsOption (const Json::Value &options, const char *key) {
+		auto &value = options[key];
+		if (value.isArray()) {
+			std::vector<std::string> paths;
+			for (auto it = value.begin(); it != value.end(); it++) {
+				paths.push_back(it->asString());
+			}
+			return paths;
+		}
+		return value.isNull() ? std::vector<std::string>() : tokenize(value.asString(), ",");
+	}
+
+	/**
+	 * a job from the options of the manifest, named like the command line
+	 * options without the dash. Leaves error set if the job can't run.
+	 */
+	static Job readJob (const Json::Value &defaults, const Json::Value &value, size_t number) {
+		Json::Value options = defaults.isObject() ? defaults : Json::Value(Json::objectValue);
+		Job job;
+		if (!value.isObject()) {
+			job.name = toString(static_cast<unsigned>(number));
+			job.error = "job is not an object";
+			return job;
+		}
+		for (auto it = value.begin(); it != value.end(); it++) {
+			options[it.name()] = *it;
+		}
+		try {
+			job.name = options.isMember("name") ? stringOption(options, "name") : toString(static_cast<unsigned>(number));
+			job.header = stringOption(options, "i");
+			job.output = stringOption(options, "o");
+			job.sdkPath = stringOption(options, "sim-sdk-path");
+			job.minVersion = stringOption(options, "min-ios-ver");
+			trim(job.minVersion);
+			job.schema = options.isMember("schema") ? stringOption(options, "schema") : "1";
+			job.includes = pathsOption(options, "hsp");
+			job.frameworks = pathsOption(options, "fsp");
+			job.moduleCache = stringOption(options, "modules");
+			job.astCache = stringOption(options, "ast-cache");
+			job.excludeSys = !stringOption(options, "x").empty();
+			job.pretty = !stringOption(options, "pretty").empty();
+			job.writeIndex = !stringOption(options, "index").empty();
+		} catch (const std::exception &e) {
+			job.error = std::string("invalid option: ") + e.what();
+			return job;
+		}
+		if (job.header.empty() || job.output.empty() || job.sdkPath.empty() || job.minVersion.empty()) {
+			job.error = "a job needs i, o, sim-sdk-path and min-ios-ver";
+		} else if (job.minVersion.find(',') != std::string::npos) {
+			job.error = "a job takes one min-ios-ver, add a job per version";
+		} else if (!ParserTree::isSupportedAPIVersion(job.schema)) {
+			job.error = "unsupported schema version: " + job.schema;
+		}
+		return job;
+	}
+
+	/**
+	 * jobs with the same key are generated from the same translation unit
+	 */
+	static std::string parseKey (const Job &job) {
+		auto key = job.header + '\n' + job.sdkPath + '\n' + (job.excludeSys ? "x" : "") + '\n' + job.moduleCache + '\n' + job.astCache + '\n';
+		for (auto it = job.includes.begin(); it != job.includes.end(); it++) {
+			key += "-I" + *it + '\n';
+		}
+		for (auto it = job.frameworks.begin(); it != job.frameworks.end(); it++) {
+			key += "-F" + *it + '\n';
+		}
+		return key;
+	}
+
+	/**
+	 * write the metabase of one job, resolving each schema and version once
+	 * per group
+	 */
+	static void writeJob (Job &job, ParserTree *tree, std::map<std::pair<std::string, std::string>, Json::Value> &resolved) {
+		auto start = std::chrono::steady_clock::now();
+		auto key = std::make_pair(job.schema, job.minVersion);
+		auto found = resolved.find(key);
+		if (found == resolved.end()) {
+			found = resolved.insert(std::make_pair(key, tree->toJSON(job.schema, job.minVersion))).first;
+		}
+		std::ofstream out(job.output);
+		if (out.fail()) {
+			job.error = "open failed for file: " + job.output;
+			return;
+		}
+		MetabaseWriter writer(out, job.pretty);
+		writer.write(found->second);
+		out << std::endl;
+		out.close();
+		if (out.fail()) {
+			job.error = "couldn't write file: " + job.output;
+			return;
+		}
+		if (job.writeIndex && !MetabaseIndex::write(job.output, writer.getEntries())) {
+			job.error = "couldn't write index for file: " + job.output;
+			return;
+		}
+		job.bytes = writer.getBytesWritten();
+		job.write = millisSince(start);
+		job.ok = true;
+	}
+
+	/**
+	 * parse once for the jobs of a group and write each of them
+	 */
+	static void runGroup (std::vector<Job> &jobs, const std::vector<size_t> &members, unsigned threads) {
+		auto &first = jobs[members.front()];
+		// availability is filtered per job, so parse at the lowest version
+		auto minVersion = first.minVersion;
+		for (auto it = members.begin(); it != members.end(); it++) {
+			if (compareVersions(parseVersion(jobs[*it].minVersion), parseVersion(minVersion)) < 0) {
+				minVersion = jobs[*it].minVersion;
+			}
+		}
+		auto sdkPath = first.sdkPath;
+		auto compilerArgs = compilerArguments(first.header, sdkPath, minVersion, first.includes, first.frameworks, first.moduleCache);
+
+		auto start = std::chrono::steady_clock::now();
+		auto index = clang_createIndex(first.moduleCache.empty() ? 1 : 0, 0);
+		Diagnostics diagnostics;
+		bool reused;
+		auto tu = parseTranslationUnit(index, compilerArgs, first.astCache, diagnostics, &reused);
+		if (!tu) {
+			clang_disposeIndex(index);
+			for (auto it = members.begin(); it != members.end(); it++) {
+				jobs[*it].error = "couldn't parse header: " + first.header;
+			}
+			return;
+		}
+		std::unique_ptr<ParserContext> ctx(parse(tu, sdkPath, minVersion, first.excludeSys, nullptr, nullptr, nullptr, &diagnostics));
+		ctx->setThreads(threads);
+		auto parsed = millisSince(start);
+
+		// resolving rewrites types in place, highest version first as main does
+		auto ordered = members;
+		std::stable_sort(ordered.begin(), ordered.end(), [&jobs](size_t a, size_t b) {
+			return compareVersions(parseVersion(jobs[a].minVersion), parseVersion(jobs[b].minVersion)) > 0;
+		});
+		std::map<std::pair<std::string, std::string>, Json::Value> resolved;
+		for (auto it = ordered.begin(); it != ordered.end(); it++) {
+			auto &job = jobs[*it];
+			job.parse = parsed;
+			job.diagnostics = diagnostics.getCount();
+			job.astReused = reused;
+			try {
+				writeJob(job, ctx->getParserTree(), resolved);
+			} catch (const std::exception &e) {
+				job.error = e.what();
+			}
+		}
+		ctx.reset();
+		clang_disposeTranslationUnit(tu);
+		clang_disposeIndex(index);
+	}
+
+	static Json::Value jobToJSON (const Job &job) {
+		Json::Value kv;
+		kv["name"] = job.name;
+		kv["output"] = job.output;
+		kv["status"] = job.ok ? "ok" : "failed";
+		if (!job.ok) {
+			kv["error"] = job.error;
+			return kv;
+		}
+		kv["parse"] = job.parse;
+		kv["write"] = job.write;
+		kv["bytes"] = static_cast<Json::UInt64>(job.bytes);
+		kv["diagnostics"] = static_cast<Json::UInt64>(job.diagnostics);
+		if (job.astReused) {
+			kv["ast-reused"] = true;
+		}
+		if (job.reparsed) {
+			kv["reparsed"] = true;
+		}
+		return kv;
+	}
+
+	static Json::Value resultsToJSON (const std::vector<Job> &jobs, size_t groups, double wall) {
+		Json::Value kv;
+		Json::Value list(Json::arrayValue);
+		size_t failed = 0;
+		for (auto it = jobs.begin(); it != jobs.end(); it++) {
+			auto job = jobToJSON(*it);
+			if (!it->ok) {
+				failed++;
+			} else {
+				job["group"] = static_cast<Json::UInt64>(it->group);
+			}
+			list.append(job);
+		}
+		kv["jobs"] = list;
+		kv["parses"] = static_cast<Json::UInt64>(groups);
+		kv["failed"] = static_cast<Json::UInt64>(failed);
+		kv["wall"] = wall;
+		return kv;
+	}
+
+	int batch (std::map<std::string, std::string> &arguments) {
+		if (!arguments.count("-m")) {
+			std::cerr << "batch requires the manifest of jobs, use -m <manifest.json>" << std::endl;
+			return EXIT_FAILURE;
+		}
+		std::ifstream in(arguments["-m"]);
+		Json::Value manifest;
+		Json::CharReaderBuilder builder;
+		std::string errors;
+		if (in.fail() || !Json::parseFromStream(builder, in, &manifest, &errors) || !manifest["jobs"].isArray()) {
+			std::cerr << "couldn't read manifest: " << arguments["-m"] << " " << errors << std::endl;
+			return EXIT_FAILURE;
+		}
+		auto threads = arguments.count("-threads") ? atoi(arguments["-threads"].c_str()) : static_cast<int>(defaultThreads());
+		auto start = std::chrono::steady_clock::now();
+
+		std::vector<Job> jobs;
+		auto &list = manifest["jobs"];
+		for (Json::ArrayIndex i = 0; i < list.size(); i++) {
+			jobs.push_back(readJob(manifest["defaults"], list[i], i));
+		}
+
+		// group in manifest order so the results don't depend on the threads
+		std::vector<std::vector<size_t>> groups;
+		std::map<std::string, size_t> groupOf;
+		for (size_t i = 0; i < jobs.size(); i++) {
+			if (!jobs[i].error.empty()) {
+				continue;
+			}
+			auto key = parseKey(jobs[i]);
+			auto found = groupOf.find(key);
+			if (found == groupOf.end()) {
+				found = groupOf.insert(std::make_pair(key, groups.size())).first;
+				groups.push_back(std::vector<size_t>());
+			}
+			jobs[i].group = found->second;
+			groups[found->second].push_back(i);
+		}
+
+		// groups run side by side, a group resolves on the threads left over
+		unsigned workers = threads < 1 ? 1 : threads;
+		unsigned resolvers = groups.empty() || workers <= groups.size() ? 1 : workers / static_cast<unsigned>(groups.size());
+		parallelFor(groups.size(), workers, [&](size_t i) {
+			try {
+				runGroup(jobs, groups[i], resolvers);
+			} catch (const std::exception &e) {
+				for (auto it = groups[i].begin(); it != groups[i].end(); it++) {
+					if (!jobs[*it].ok && jobs[*it].error.empty()) {
+						jobs[*it].error = e.what();
+					}
+				}
+			}
+		}, 1);
+
+		auto results = resultsToJSON(jobs, groups.size(), millisSince(start));
+		Json::StreamWriterBuilder writer;
+		writer.settings_["commentStyle"] = "None";
+		writer.settings_["indentation"] = "\t";
+		if (arguments.count("-results")) {
+			std::ofstream out(arguments["-results"]);
+			out << Json::writeString(writer, results) << std::endl;
+			out.close();
+			if (out.fail()) {
+				std::cerr << "couldn't write results to file: " << arguments["-results"] << std::endl;
+				return EXIT_FAILURE;
+			}
+		} else {
+			std::cout << Json::writeString(writer, results) << std::endl;
+		}
+		return results["failed"].asUInt64() > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	/**
+	 * a translation unit kept by serve for later requests of the same parse
+	 */
+	struct Session {
+		CXIndex index;
+		CXTranslationUnit tu;
+	};
+
+	static void disposeSession (Session &session) {
+		clang_disposeTranslationUnit(session.tu);
+		clang_disposeIndex(session.index);
+	}
+
+	/**
+	 * the contents of files not saved yet, as an object of file names to
+	 * their contents
+	 */
+	static std::vector<std::pair<std::string, std::string>> unsavedOption (const Json::Value &options) {
+		std::vector<std::pair<std::string, std::string>> files;
+		auto &value = options["unsaved"];
+		for (auto it = value.begin(); it != value.end(); it++) {
+			files.push_back(std::make_pair(it.name(), it->asString()));
+		}
+		return files;
+	}
+
+	/**
+	 * generate the metabase of a request, reparsing the translation unit of an
+	 * earlier request of the same parse or parsing a new one. Only what follows
+	 * the precompiled preamble of the imports at the top of the header is
+	 * parsed again, unless one of the files of the preamble changed
+	 */
+	static void runRequest (Job &job, const std::vector<std::pair<std::string, std::string>> &unsaved, std::map<std::string, Session> &sessions, std::list<std::string> &recent, size_t limit, unsigned threads) {
+		std::vector<CXUnsavedFile> files;
+		for (auto it = unsaved.begin(); it != unsaved.end(); it++) {
+			CXUnsavedFile file = { it->first.c_str(), it->second.c_str(), static_cast<unsigned long>(it->second.size()) };
+			files.push_back(file);
+		}
+		auto key = parseKey(job) + job.minVersion + '\n';
+		auto start = std::chrono::steady_clock::now();
+		auto found = sessions.find(key);
+		if (found != sessions.end()) {
+			recent.remove(key);
+			if (clang_reparseTranslationUnit(found->second.tu, (unsigned)files.size(), files.empty() ? nullptr : &files[0], clang_defaultReparseOptions(found->second.tu)) == 0) {
+				job.reparsed = true;
+			} else {
+				// a translation unit that failed to reparse can only be disposed
+				disposeSession(found->second);
+				sessions.erase(found);
+				found = sessions.end();
+			}
+		}
+		if (found == sessions.end()) {
+			auto compilerArgs = compilerArguments(job.header, job.sdkPath, job.minVersion, job.includes, job.frameworks, job.moduleCache);
+			std::vector<const char *> args;
+			for (auto it = compilerArgs.begin(); it != compilerArgs.end(); it++) {
+				args.push_back(it->c_str());
+			}
+			Session session;
+			// declarations of the preamble are only visited if not excluded
+			session.index = clang_createIndex(0, 0);
+			session.tu = clang_parseTranslationUnit(session.index, nullptr, &args[0], (int)args.size(), files.empty() ? nullptr : &files[0], (unsigned)files.size(), CXTranslationUnit_PrecompiledPreamble | CXTranslationUnit_CreatePreambleOnFirstParse);
+			if (!session.tu) {
+				clang_disposeIndex(session.index);
+				job.error = "couldn't parse header: " + job.header;
+				return;
+			}
+			// the least recently used sessions go past the limit
+			while (sessions.size() >= limit && !recent.empty()) {
+				auto oldest = sessions.find(recent.front());
+				disposeSession(oldest->second);
+				sessions.erase(oldest);
+				recent.pop_front();
+			}
+			found = sessions.insert(std::make_pair(key, session)).first;
+		}
+		recent.push_back(key);
+
+		Diagnostics diagnostics;
+		diagnostics.addTranslationUnit(found->second.tu);
+		auto sdkPath = job.sdkPath;
+		auto minVersion = job.minVersion;
+		std::unique_ptr<ParserContext> ctx(parse(found->second.tu, sdkPath, minVersion, job.excludeSys, nullptr, nullptr, nullptr, &diagnostics));
+		ctx->setThreads(threads);
+		job.parse = millisSince(start);
+		job.diagnostics = diagnostics.getCount();
+		std::map<std::pair<std::string, std::string>, Json::Value> resolved;
+		writeJob(job, ctx->getParserTree(), resolved);
+	}
+
+	int serve (std::map<std::string, std::string> &arguments) {
+		auto threads = arguments.count("-threads") ? atoi(arguments["-threads"].c_str()) : static_cast<int>(defaultThreads());
+		auto limit = arguments.count("-sessions") ? atoi(arguments["-sessions"].c_str()) : 4;
+		// the other options of the command line are defaults of every request
+		Json::Value defaults(Json::objectValue);
+		for (auto it = arguments.begin(); it != arguments.end(); it++) {
+			if (it->first.size() > 1 && it->first[0] == '-' && it->first != "-threads" && it->first != "-sessions") {
+				defaults[it->first.substr(1)] = it->second;
+			}
+		}
+
+		std::map<std::string, Session> sessions;
+		std::list<std::string> recent;
+		Json::CharReaderBuilder builder;
+		Json::StreamWriterBuilder writer;
+		writer.settings_["indentation"] = "";
+		std::string line;
+		size_t number = 0;
+		while (std::getline(std::cin, line)) {
+			trim(line);
+			if (line.empty()) {
+				continue;
+			}
+			Json::Value request;
+			std::string errors;
+			std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+			Job job;
+			if (!reader->parse(line.data(), line.data() + line.size(), &request, &errors)) {
+				job.name = toString(static_cast<unsigned>(number));
+				job.error = "couldn't read request: " + errors;
+			} else {
+				job = readJob(defaults, request, number);
+			}
+			if (job.error.empty()) {
+				try {
+					runRequest(job, unsavedOption(request), sessions, recent, limit < 1 ? 1 : static_cast<size_t>(limit), threads < 1 ? 1 : threads);
+				} catch (const std::exception &e) {
+					job.ok = false;
+					job.error = e.what();
+				}
+			}
+			// one line per request, flushed so the client can read it right away
+			std::cout << Json::writeString(writer, jobToJSON(job)) << std::endl;
+			number++;
+		}
+		for (auto it = sessions.begin(); it != sessions.end(); it++) {
+			disposeSession(it->second);
+		}
+		return EXIT_SUCCESS;
+	}
+}
@@ -0,0 +1,36 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_BATCH_H
+#define HYPERLOOP_BATCH_H
+
+#include <map>
+#include <string>
+
+namespace hyperloop {
+
+	/**
+	 * generate every metabase of a manifest in one process. Jobs parsing the
+	 * same header with the same SDK and search paths share one parse at the
+	 * lowest of their minimum versions, and each schema and version is
+	 * resolved once for them. Those groups run concurrently on up to -threads
+	 * threads, and a job that fails doesn't stop the others. Prints the result
+	 * of every job as JSON, returns the process exit code
+	 */
+	int batch (std::map<std::string, std::string> &arguments);
+
+	/**
+	 * generate metabases on request until stdin is closed, each line a JSON
+	 * job like those of a batch manifest, with the command line options as
+	 * defaults, and an optional unsaved object of file names to contents
+	 * overriding the files on disk. The translation unit of a request is
+	 * kept, with a precompiled preamble of the imports at the top of its
+	 * header, and reparsed by later requests of the same header, SDK, search
+	 * paths and minimum version. Up to -sessions of them are kept. Prints the
+	 * result of each request as a line of JSON, returns the process exit code
+	 */
+	int serve (std::map<std::string, std::string> &arguments);
+}
+
+#endif
@@ -37,7 +37,7 @@ namespace hyperloop {
 				break;
 			}
 			default: {
-				std::cerr << "not handled, block: " << displayName << " kind: " << kind << std::endl;
+				blockDef->getContext()->diagnose("unhandled.block", displayName + " kind: " + std::to_string(kind));
 				break;
 			}
 		}
@@ -64,11 +64,11 @@ namespace hyperloop {
 		auto tree = this->context->getParserTree();
 		Json::Value kv;
 		toJSONBase(kv);
-		kv["signature"] = this->signature;
-		kv["arguments"] = arguments.toJSON();
-		resolveEncoding(tree, kv["returns"], "type", "value");
-		for (auto c = 0; c < kv["arguments"].size(); c++) {
-			resolveEncoding(tree, kv["arguments"][c], "type", "value");
+		kv[keys::signature] = this->signature;
+		kv[keys::arguments] = arguments.toJSON();
+		resolveEncoding(tree, kv[keys::returns], "type", "value");
+		for (auto c = 0; c < kv[keys::arguments].size(); c++) {
+			resolveEncoding(tree, kv[keys::arguments][c], "type", "value");
 		}
 		return kv;
 	}
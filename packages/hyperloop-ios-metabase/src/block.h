@@ -14,11 +14,12 @@
 
 namespace hyperloop {
 
-	class BlockDefinition : public Definition {
+	class BlockDefinition : public Definition, private Counted<BlockDefinition> {
 	public:
 		BlockDefinition (CXCursor cursor, ParserContext *ctx);
 		~BlockDefinition();
 		Json::Value toJSON () const;
+		inline const char* getKind () const { return "block"; }
 		std::string getSignature() { return signature; };
 		void addArgument(const std::string &argName, CXCursor cursor);
 	private:
@@ -8,14 +8,10 @@
 #include "property.h"
 #include "parser.h"
 #include "util.h"
+#include "shards.h"
 
 namespace hyperloop {
 
-	static bool isCategory = false;
-	static bool isProtocol = false;
-	static ClassDefinition *currentClass = nullptr;
-	static std::map<std::string, std::vector<ClassDefinition *>> pendingClasses;
-
 	static CXChildVisitResult parseClassMember (CXCursor cursor, CXCursor parent, CXClientData clientData) {
 		if (!isAvailableInIos(cursor)) {
 			return CXChildVisit_Continue;
@@ -45,7 +41,7 @@ namespace hyperloop {
 				// @interface Foo (Bar)
 				// whereby initially displayName on the class will be Bar and then
 				// the class reference will be Foo.  in this case, we want to use Foo
-				if (isCategory) {
+				if (classDef->isClassCategory()) {
 					classDef->addCategory(classDef->getName());
 					classDef->setName(displayName);
 				}
@@ -55,13 +51,13 @@ namespace hyperloop {
 				break;
 			}
 			case CXCursor_ObjCSuperClassRef: {
-//				std::cout << "super class: " << displayName << " <- " << currentClass->getName () << std::endl;
-				currentClass->setSuperclass(displayName);
+//				std::cout << "super class: " << displayName << " <- " << classDef->getName () << std::endl;
+				classDef->setSuperclass(displayName);
 				break;
 			}
 			case CXCursor_ObjCProtocolRef: {
-//				std::cout << "protocol class: " << displayName << " <- " << currentClass->getName () << std::endl;
-				currentClass->addProtocol(displayName);
+//				std::cout << "protocol class: " << displayName << " <- " << classDef->getName () << std::endl;
+				classDef->addProtocol(displayName);
 				break;
 			}
 			case CXCursor_TemplateTypeParameter: {
@@ -76,7 +72,7 @@ namespace hyperloop {
 				break;
 			}
 			default: {
-				std::cerr << "Not handling currently " << classDef->getName() << ":" << displayName << ", type: " << kind << std::endl;
+				classDef->getContext()->diagnose("unhandled.class", classDef->getName() + ":" + displayName + ", type: " + std::to_string(kind));
 				break;
 			}
 		}
@@ -99,6 +95,7 @@ namespace hyperloop {
 	}
 
 	bool ClassDefinition::merge () const {
+		auto &pendingClasses = this->getContext()->getPendingClasses();
 		if (pendingClasses.find(this->getName()) != pendingClasses.end()) {
 			std::vector<ClassDefinition *> vector = pendingClasses[this->getName()];
 			for (std::vector<ClassDefinition *>::iterator it = vector.begin(); it != vector.end(); it++) {
@@ -123,7 +120,7 @@ namespace hyperloop {
 				mkv[name] = md->toJSON();
 			}
 			if (!mkv.empty()) {
-				kv["methods"] = mkv;
+				kv[keys::methods] = mkv;
 			}
 		}
 		if (!this->properties.empty()) {
@@ -134,17 +131,38 @@ namespace hyperloop {
 				pkv[name] = pd->toJSON();
 			}
 			if (!pkv.empty()) {
-				kv["properties"] = pkv;
+				kv[keys::properties] = pkv;
 			}
 		}
 		if (!protocols.empty()) {
-			kv["protocols"] = hyperloop::toJSON(protocols);
+			kv[keys::protocols] = hyperloop::toJSON(protocols);
 		}
 		if (!categories.empty()) {
-			kv["categories"] = hyperloop::toJSON(categories);
+			kv[keys::categories] = hyperloop::toJSON(categories);
 		}
 		if (!superClass.empty()) {
-			kv["superclass"] = superClass;
+			kv[keys::superclass] = superClass;
+		}
+		return kv;
+	}
+
+	Json::Value ClassDefinition::extensionToJSON (const std::string &framework) const {
+		Json::Value kv;
+		for (auto it = this->methods.begin(); it != this->methods.end(); it++) {
+			if (it->second->getFramework() == framework) {
+				kv[keys::methods][it->first] = it->second->toJSON();
+			}
+		}
+		for (auto it = this->properties.begin(); it != this->properties.end(); it++) {
+			if (it->second->getFramework() == framework) {
+				kv[keys::properties][it->first] = it->second->toJSON();
+			}
+		}
+		for (auto category : categories) {
+			auto found = categoryFrameworks.find(category);
+			if (found != categoryFrameworks.end() && found->second == framework) {
+				kv[keys::categories].append(category);
+			}
 		}
 		return kv;
 	}
@@ -180,16 +198,32 @@ namespace hyperloop {
 		}
 		for (auto category : from->categories) {
 			to->addCategory(category);
+			// a category names itself, so it's declared in the framework of from
+			auto found = from->categoryFrameworks.find(category);
+			to->categoryFrameworks[category] = found != from->categoryFrameworks.end() ? found->second : from->getFramework();
 		}
 		if (!from->superClass.empty() && to->superClass.empty()) {
 			to->setSuperclass(from->superClass);
 		}
 	}
 
+	bool ClassDefinition::hasPendingClasses (ParserContext *ctx, const std::string &framework) {
+		auto &pendingClasses = ctx->getPendingClasses();
+		for (auto it = pendingClasses.begin(); it != pendingClasses.end(); it++) {
+			for (auto iit = it->second.begin(); iit != it->second.end(); iit++) {
+				if ((*iit)->getFramework() == framework) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
 	void ClassDefinition::complete (ParserContext *ctx) {
 		// in case we got to the end of parsing and we still have pending classes
 		// we need to merge them into the parser tree
 		auto tree = ctx->getParserTree();
+		auto &pendingClasses = ctx->getPendingClasses();
 		std::vector<ClassDefinition *> mergers;
 		std::vector<ClassDefinition *> pending;
 		for (auto it = pendingClasses.begin(); it != pendingClasses.end(); it++) {
@@ -222,6 +256,9 @@ namespace hyperloop {
 		for (auto it = mergers.begin(); it != mergers.end(); it++) {
 			auto found = *it;
 			found->merge();
+			if (ctx->getShards()) {
+				ctx->getShards()->changed(found->getFramework());
+			}
 		}
 		for (auto it = pending.begin(); it != pending.end(); it++) {
 			auto found = *it;
@@ -236,9 +273,8 @@ namespace hyperloop {
 
 	CXChildVisitResult ClassDefinition::executeParse (CXCursor cursor, ParserContext *context) {
 		auto tree = context->getParserTree();
-		currentClass = this;
-		isCategory = clang_getCursorKind(cursor) == CXCursor_ObjCCategoryDecl;
-		isProtocol = clang_getCursorKind(cursor) == CXCursor_ObjCProtocolDecl;
+		auto isCategory = clang_getCursorKind(cursor) == CXCursor_ObjCCategoryDecl;
+		auto isProtocol = clang_getCursorKind(cursor) == CXCursor_ObjCProtocolDecl;
 		auto name = this->getName();
 		this->setIsCategory(isCategory);
 		// std::cout << "---before visit: " << this->getName() << ", category: " << isCategory << ", protocol: " << isProtocol << std::endl;
@@ -253,16 +289,19 @@ namespace hyperloop {
 					// we need to migrate into our existing class
 					auto classDef = tree->getClass(this->getName());
 					ClassDefinition::copy(this, classDef);
+					if (context->getShards()) {
+						context->getShards()->changed(classDef->getFramework());
+					}
 				}
 				merge();
 			} else {
 				auto key = this->getName();
+				auto &pendingClasses = context->getPendingClasses();
 				std::vector<ClassDefinition *> pending = pendingClasses[key];
 				pending.push_back(this);
 				pendingClasses[key] = pending;
 			}
 		}
-		currentClass = nullptr;
 		// std::cout << "---after visit: " << this->getName() << ", category: " << isCategory << std::endl;
 		return CXChildVisit_Continue;
 	}
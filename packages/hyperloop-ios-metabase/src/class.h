@@ -17,11 +17,18 @@ namespace hyperloop {
 	/**
 	 * Class definition
 	 */
-	class ClassDefinition : public Definition {
+	class ClassDefinition : public Definition, private Counted<ClassDefinition> {
 		public:
 			ClassDefinition (CXCursor cursor, const std::string &name, ParserContext *ctx);
 			~ClassDefinition ();
 			Json::Value toJSON () const;
+
+			/**
+			 * the methods, properties and categories declared in framework, which
+			 * its categories add to this class of another framework, null if none
+			 */
+			Json::Value extensionToJSON (const std::string &framework) const;
+			inline const char* getKind () const { return "class"; }
 			void addMethod (MethodDefinition *method);
 			void addProtocol (const std::string &name);
 			void addCategory (const std::string &name);
@@ -31,11 +38,17 @@ namespace hyperloop {
 			void setIsCategory(bool v) { this->category = v; }
 			bool isClassCategory() { return this->category; }
 			static void complete (ParserContext *);
+
+			/**
+			 * true if a class or category of framework is waiting to be merged
+			 */
+			static bool hasPendingClasses (ParserContext *ctx, const std::string &framework);
 		private:
 			std::map<std::string, MethodDefinition *> methods;
 			std::map<std::string, Property *> properties;
 			std::vector<std::string> protocols;
 			std::vector<std::string> categories;
+			std::map<std::string, std::string> categoryFrameworks;
 			std::string superClass;
 			bool category;
 
@@ -7,6 +7,7 @@
 #include "parser.h"
 #include "util.h"
 #include "typedef.h"
+#include "trace.h"
 #include <iostream>
 
 namespace hyperloop {
@@ -21,10 +22,62 @@ namespace hyperloop {
 
 	Json::Value Argument::toJSON() const {
 		Json::Value kv;
-		kv["name"] = this->name;
-		kv["type"] = type->getType();
-		kv["value"] = cleanString(type->getValue());
-		kv["encoding"] = type->getEncoding();
+		kv[keys::name] = this->name;
+		kv[keys::type] = type->getType();
+		kv[keys::value] = cleanString(type->getValue());
+		kv[keys::encoding] = type->getEncoding();
+		return kv;
+	}
+
+	static CXVisitorResult addNestedField (CXCursor cursor, CXClientData clientData) {
+		auto args = static_cast<std::pair<std::vector<Field *> *, ParserContext *> *>(clientData);
+		auto name = CXStringToString(clang_getCursorDisplayName(cursor));
+		args->first->push_back(new Field(cursor, name, new Type(cursor, args->second), args->second));
+		return CXVisit_Continue;
+	}
+
+	Field::Field(CXCursor cursor, const std::string &_name, Type *_type, ParserContext *ctx) : Argument(_name, _type), width(-1) {
+		auto record = clang_getCursorType(clang_getCursorSemanticParent(cursor));
+		if (!_name.empty()) {
+			this->offset = clang_Type_getOffsetOf(record, _name.c_str());
+		} else {
+			this->offset = clang_Cursor_getOffsetOfField(cursor);
+		}
+		if (clang_Cursor_isBitField(cursor)) {
+			this->width = clang_getFieldDeclBitWidth(cursor);
+		}
+		// named records have a layout of their own, anonymous ones only have this field
+		auto type = clang_getCanonicalType(clang_getCursorType(cursor));
+		if (type.kind == CXType_Record && clang_Cursor_isAnonymous(clang_getTypeDeclaration(type))) {
+			auto args = std::make_pair(&fields, ctx);
+			clang_Type_visitFields(type, addNestedField, &args);
+		}
+	}
+
+	Field::~Field() {
+		for (auto it = fields.begin(); it != fields.end(); it++) {
+			delete *it;
+		}
+	}
+
+	Json::Value Field::toJSON() const {
+		auto kv = Argument::toJSON();
+		if (offset >= 0) {
+			kv[keys::offset] = static_cast<Json::UInt64>(offset / 8);
+			if (width >= 0) {
+				kv[keys::bitOffset] = static_cast<Json::UInt>(offset % 8);
+				kv[keys::bitWidth] = width;
+			}
+		}
+		if (fields.size() > 0) {
+			Json::Value fkv;
+			for (auto it = fields.begin(); it != fields.end(); it++) {
+				auto v = (*it)->toJSON();
+				v.removeMember(keys::value);
+				fkv.append(v);
+			}
+			kv[keys::fields] = fkv;
+		}
 		return kv;
 	}
 
@@ -102,8 +155,7 @@ namespace hyperloop {
 			auto structName = replace(this->value, "struct ", "");
 			structName = ltrim(structName, "_");
 			if (this->context->getParserTree()->hasStruct(structName)) {
-				this->type = "struct";
-				this->value = structName;
+				resolveRecord(structName);
 			}
 		}
 	}
@@ -116,26 +168,24 @@ namespace hyperloop {
 			// so convert all record types that actually have those to struct
 			auto typeDefName = cleanString(CXStringToString(clang_getTypeSpelling(type)));
 			if (tree->hasStruct(typeDefName)) {
-				this->type = "struct";
-				this->value = typeDefName;
+				resolveRecord(typeDefName);
 			} if (this->value.find("struct ") != std::string::npos) {
 				// special case for struct typedef to existing struct typedef, stick to the first one
 				// for consistency
 				auto structName = replace(this->value, "struct ", "");
 				if (tree->hasStruct(structName)) {
-					this->type = "struct";
-					this->value = structName;
+					resolveRecord(structName);
 				}
 			}
 		}
 	}
 
-	Type::Type (const Type &type) : context(type.context), encoding(type.encoding) {
+	Type::Type (const Type &type) : context(type.context), encoding(type.encoding), record(type.record) {
 		setType(type.type);
 		setValue(type.value);
 	}
 
-	Type::Type (Type &&type) : context(type.context), type(std::move(type.type)), value(std::move(type.value)), encoding(std::move(type.encoding)) {
+	Type::Type (Type &&type) : context(type.context), type(std::move(type.type)), value(std::move(type.value)), encoding(std::move(type.encoding)), record(std::move(type.record)) {
 	}
 
 	Type::Type (ParserContext *ctx, const std::string &_type, const std::string &_value, const std::string &encoding) : context(ctx), encoding(encoding) {
@@ -152,6 +202,31 @@ namespace hyperloop {
 		swap(value, other.value);
 		swap(type, other.type);
 		swap(context, other.context);
+		swap(record, other.record);
+	}
+
+	void Type::resolveRecord (const std::string &structName) {
+		if (record.empty()) {
+			record = value;
+		}
+		type = "struct";
+		value = structName;
+	}
+
+	/**
+	 * true if the struct this record was resolved to is unavailable in the
+	 * version the tree is serialized for, where a parse wouldn't have found it
+	 */
+	bool Type::isRecord () const {
+		return !record.empty() && type == "struct" && !context->getParserTree()->hasStruct(value);
+	}
+
+	std::string Type::getType () const {
+		return isRecord() ? "record" : type;
+	}
+
+	std::string Type::getValue () const {
+		return isRecord() ? record : value;
 	}
 
 	void Type::setType (const std::string &_type) {
@@ -164,12 +239,30 @@ namespace hyperloop {
 
 	Json::Value Type::toJSON() const {
 		Json::Value kv;
-		kv["type"] = type;
-		kv["value"] = value;
-		kv["encoding"] = encoding;
+		kv[keys::type] = getType();
+		kv[keys::value] = getValue();
+		kv[keys::encoding] = encoding;
 		return kv;
 	}
 
+	Availability::Availability () : unavailable(false) {
+		introduced.Major = introduced.Minor = introduced.Subminor = -1;
+		deprecated = obsoleted = introduced;
+	}
+
+	bool Availability::isAvailableIn (const CXVersion &target) const {
+		if (unavailable) {
+			return false;
+		}
+		if (deprecated.Major >= 0 && compareVersions(deprecated, target) <= 0) {
+			return false;
+		}
+		if (obsoleted.Major >= 0 && compareVersions(obsoleted, target) <= 0) {
+			return false;
+		}
+		return true;
+	}
+
 	Definition::Definition(CXCursor _cursor, const std::string &_name, ParserContext *ctx) :
 		cursor(_cursor), name(_name), filename(ctx->getCurrentFilename()), line(ctx->getCurrentLine()), context(ctx) {
 	}
@@ -184,26 +277,36 @@ namespace hyperloop {
 	}
 
 	std::string Definition::getFramework () const {
-		size_t frameworkPosition = filename.find(".framework");
-		if (frameworkPosition != std::string::npos) {
-			size_t slashBeforeFrameworkPosition = filename.find_last_of("/", frameworkPosition);
-			return filename.substr(slashBeforeFrameworkPosition + 1, frameworkPosition - (slashBeforeFrameworkPosition + 1));
-		}
-
-		return filename;
+		return getFrameworkName(filename);
 	}
 
 	void Definition::toJSONBase (Json::Value &kv) const {
-		kv["name"] = name;
-		kv["framework"] = getFramework();
-		kv["thirdparty"] = !getContext()->isSystemLocation(filename);
-		kv["filename"] = filename;
-		kv["line"] = line;
-		kv["introducedIn"] = introducedIn;
+		kv[keys::name] = name;
+		kv[keys::framework] = getFramework();
+		kv[keys::thirdparty] = !getContext()->isSystemLocation(filename);
+		kv[keys::filename] = filename;
+		kv[keys::line] = line;
+		kv[keys::introducedIn] = introducedIn;
 	}
 
 	CXChildVisitResult Definition::parse(CXCursor cursor, CXCursor parent, CXClientData clientData) {
-		return this->executeParse(cursor, static_cast<ParserContext *>(clientData));
+		// clientData isn't always the context (class members pass their class)
+		ClangSite site(getKind());
+		auto trace = context ? context->getTrace() : nullptr;
+		if (!trace) {
+			return this->executeParse(cursor, static_cast<ParserContext *>(clientData));
+		}
+		auto start = trace->now();
+		auto result = this->executeParse(cursor, static_cast<ParserContext *>(clientData));
+		auto end = trace->now();
+		if (end - start >= trace->getThreshold()) {
+			Json::Value args;
+			args["kind"] = CXStringToString(clang_getCursorKindSpelling(clang_getCursorKind(cursor)));
+			args["filename"] = filename;
+			args["line"] = line;
+			trace->span(name.empty() ? "(anonymous)" : name, "parse", start, end, args);
+		}
+		return result;
 	}
 
 }
@@ -13,6 +13,7 @@
 
 #include "clang-c/Index.h"
 #include "json/json.h"
+#include "instances.h"
 
 
 namespace hyperloop {
@@ -27,7 +28,7 @@ namespace hyperloop {
 			virtual Json::Value toJSON() const = 0;
 	};
 
-	class Type : public Serializable {
+	class Type : public Serializable, private Counted<Type> {
 		public:
 			Type (CXType type, ParserContext *ctx);
 			Type (CXCursor cursor, ParserContext *ctx);
@@ -36,8 +37,8 @@ namespace hyperloop {
 			Type (ParserContext *ctx, const std::string &type, const std::string &value = "", const std::string &encoding = "");
 			virtual ~Type();
 			virtual Json::Value toJSON() const;
-			inline std::string getType() { return type; }
-			inline std::string getValue() { return value; }
+			std::string getType() const;
+			std::string getValue() const;
 			inline std::string getEncoding() { return encoding; }
 
 			void setType (const std::string &_type);
@@ -48,9 +49,15 @@ namespace hyperloop {
 			std::string type;
 			std::string value;
 			std::string encoding;
+			// the spelling of a record the parse found a struct for, which is
+			// the type again where that struct isn't available
+			std::string record;
+
+			void resolveRecord (const std::string &structName);
+			bool isRecord () const;
 	};
 
-	class Argument : public Serializable {
+	class Argument : public Serializable, private Counted<Argument> {
 		public:
 			Argument(const std::string &name, Type *type);
 			virtual ~Argument();
@@ -61,7 +68,25 @@ namespace hyperloop {
 			Type *type;
 	};
 
-	class Arguments : public Serializable {
+	/**
+	 * a field of a struct or union with where clang lays it out for the
+	 * target, so generated code needn't work it out from the encoding. The
+	 * fields of an anonymous struct or union are kept with the field holding it
+	 */
+	class Field : public Argument, private Counted<Field> {
+		public:
+			Field(CXCursor cursor, const std::string &name, Type *type, ParserContext *ctx);
+			virtual ~Field();
+			virtual Json::Value toJSON() const;
+		private:
+			// in bits from the start of the record, negative if clang can't tell
+			long long offset;
+			// of a bitfield, otherwise negative
+			int width;
+			std::vector<Field *> fields;
+	};
+
+	class Arguments : public Serializable, private Counted<Arguments> {
 		public:
 			Arguments();
 			virtual ~Arguments();
@@ -73,6 +98,25 @@ namespace hyperloop {
 			std::vector<Argument *> arguments;
 	};
 
+	/**
+	 * availability of a declaration on iOS, recorded during the one parse so
+	 * metabases for several minimum versions can be written from it. Versions
+	 * that aren't given have a negative major version
+	 */
+	struct Availability {
+		Availability ();
+		CXVersion introduced;
+		CXVersion deprecated;
+		CXVersion obsoleted;
+		bool unavailable;
+		std::string message;
+
+		/**
+		 * false if unavailable, or deprecated or obsoleted at or before target
+		 */
+		bool isAvailableIn (const CXVersion &target) const;
+	};
+
 	/**
 	 * Abstract Base Class for a generation definition
 	 */
@@ -80,6 +124,10 @@ namespace hyperloop {
 		public:
 			Definition (CXCursor cursor, const std::string &name, ParserContext *ctx);
 			virtual Json::Value toJSON () const = 0;
+			/**
+			 * short name of the kind of definition, used to attribute profiled libclang calls
+			 */
+			virtual const char* getKind () const = 0;
 			CXChildVisitResult parse(CXCursor cursor, CXCursor parent, CXClientData clientData);
 			void setName (const std::string &_name) { name = _name; }
 			inline const std::string getName() const { return name; }
@@ -87,6 +135,8 @@ namespace hyperloop {
 			inline const std::string getLine() const { return line; }
 			inline const std::string getIntroducedIn() const { return introducedIn; }
 			void setIntroducedIn(const CXVersion version);
+			inline const Availability& getAvailability() const { return availability; }
+			inline void setAvailability(const Availability &_availability) { availability = _availability; }
 			inline ParserContext* getContext() const { return context; }
 			inline CXCursor getCursor() { return cursor; }
 			std::string getFramework() const;
@@ -98,6 +148,7 @@ namespace hyperloop {
 			std::string filename;
 			std::string line;
 			std::string introducedIn;
+			Availability availability;
 
 			virtual void toJSONBase (Json::Value &kv) const;
 
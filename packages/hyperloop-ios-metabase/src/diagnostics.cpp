@@ -0,0 +1,115 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <algorithm>
+#include <fstream>
+#include "diagnostics.h"
+#include "util.h"
+
+namespace hyperloop {
+
+	Diagnostics::Diagnostics (unsigned _limit) : limit(_limit) {
+	}
+
+	void Diagnostics::add (const std::string &kind, const std::string &message, const std::string &filename, const std::string &line) {
+		auto &entry = kinds[kind];
+		entry.count++;
+		if (entry.examples.size() >= limit) {
+			return;
+		}
+		Json::Value example;
+		example["message"] = message;
+		if (!filename.empty()) {
+			example["filename"] = filename;
+		}
+		if (!line.empty()) {
+			example["line"] = line;
+		}
+		entry.examples.append(example);
+	}
+
+	static const char* severityKind (CXDiagnosticSeverity severity) {
+		switch (severity) {
+			case CXDiagnostic_Warning: return "clang.warning";
+			case CXDiagnostic_Error: return "clang.error";
+			case CXDiagnostic_Fatal: return "clang.fatal";
+			default: return nullptr;
+		}
+	}
+
+	void Diagnostics::addTranslationUnit (CXTranslationUnit tu) {
+		auto count = clang_getNumDiagnostics(tu);
+		for (unsigned i = 0; i < count; i++) {
+			auto diagnostic = clang_getDiagnostic(tu, i);
+			auto kind = severityKind(clang_getDiagnosticSeverity(diagnostic));
+			if (kind) {
+				CXFile file;
+				unsigned line, column, offset;
+				clang_getFileLocation(clang_getDiagnosticLocation(diagnostic), &file, &line, &column, &offset);
+				add(kind, CXStringToString(clang_getDiagnosticSpelling(diagnostic)),
+					file ? CXStringToString(clang_getFileName(file)) : "", file ? std::to_string(line) : "");
+			}
+			clang_disposeDiagnostic(diagnostic);
+		}
+	}
+
+	void Diagnostics::merge (const Json::Value &json) {
+		auto &list = json["kinds"];
+		for (auto it = list.begin(); it != list.end(); it++) {
+			auto &entry = kinds[(*it)["kind"].asString()];
+			entry.count += (*it)["count"].asUInt64();
+			auto &examples = (*it)["examples"];
+			for (auto eit = examples.begin(); eit != examples.end() && entry.examples.size() < limit; eit++) {
+				entry.examples.append(*eit);
+			}
+		}
+	}
+
+	unsigned long long Diagnostics::getCount (const std::string &kind) const {
+		if (!kind.empty()) {
+			auto it = kinds.find(kind);
+			return it == kinds.end() ? 0 : it->second.count;
+		}
+		unsigned long long total = 0;
+		for (auto it = kinds.begin(); it != kinds.end(); it++) {
+			total += it->second.count;
+		}
+		return total;
+	}
+
+	Json::Value Diagnostics::toJSON () const {
+		std::vector<std::pair<std::string, const Kind *>> sorted;
+		for (auto it = kinds.begin(); it != kinds.end(); it++) {
+			sorted.push_back(std::make_pair(it->first, &it->second));
+		}
+		std::stable_sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, const Kind *> &a, const std::pair<std::string, const Kind *> &b) {
+			return a.second->count > b.second->count;
+		});
+		Json::Value kv;
+		kv["total"] = static_cast<Json::UInt64>(getCount());
+		Json::Value list(Json::arrayValue);
+		for (auto it = sorted.begin(); it != sorted.end(); it++) {
+			Json::Value kind;
+			kind["kind"] = it->first;
+			kind["count"] = static_cast<Json::UInt64>(it->second->count);
+			kind["examples"] = it->second->examples.isNull() ? Json::Value(Json::arrayValue) : it->second->examples;
+			list.append(kind);
+		}
+		kv["kinds"] = list;
+		return kv;
+	}
+
+	bool Diagnostics::write (const std::string &file) const {
+		std::ofstream out(file, std::ios::out | std::ios::trunc);
+		if (out.fail()) {
+			return false;
+		}
+		Json::StreamWriterBuilder builder;
+		builder.settings_["commentStyle"] = "None";
+		builder.settings_["indentation"] = "\t";
+		out << Json::writeString(builder, toJSON()) << std::endl;
+		out.close();
+		return !out.fail();
+	}
+}
@@ -0,0 +1,71 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_DIAGNOSTICS_H
+#define HYPERLOOP_DIAGNOSTICS_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "clang-c/Index.h"
+#include "json/json.h"
+
+namespace hyperloop {
+
+	/**
+	 * Collects the generator's warnings and clang's diagnostics instead of
+	 * writing each one to stderr, which on SDK wide runs is megabytes of
+	 * output the caller has to drain. Messages are counted per kind with the
+	 * first few kept as examples, and written once at the end.
+	 */
+	class Diagnostics {
+		public:
+			Diagnostics (unsigned limit = 10);
+
+			/**
+			 * record a message of kind, filename and line are optional
+			 */
+			void add (const std::string &kind, const std::string &message, const std::string &filename = "", const std::string &line = "");
+
+			/**
+			 * record the diagnostics clang reported for the translation unit,
+			 * as kinds clang.warning, clang.error and clang.fatal
+			 */
+			void addTranslationUnit (CXTranslationUnit tu);
+
+			/**
+			 * record the messages of another collector's toJSON, counts are kept
+			 * while examples are kept up to the limit
+			 */
+			void merge (const Json::Value &json);
+
+			/**
+			 * number of messages of kind, every kind if empty
+			 */
+			unsigned long long getCount (const std::string &kind = "") const;
+
+			/**
+			 * kinds sorted by count, most frequent first
+			 */
+			Json::Value toJSON () const;
+
+			/**
+			 * write the diagnostics to file, returns false if it can't be written
+			 */
+			bool write (const std::string &file) const;
+
+		private:
+			struct Kind {
+				Kind () : count(0) {}
+				unsigned long long count;
+				Json::Value examples;
+			};
+
+			unsigned limit;
+			std::map<std::string, Kind> kinds;
+	};
+}
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include "encoding.h"
+
+namespace hyperloop {
+
+	/**
+	 * encoding and EncodingToType type of each primitive, in the order of the enum
+	 */
+	static const struct {
+		const char *encoding;
+		const char *type;
+	} primitives[] = {
+		{ "?", "unknown" },
+		{ "c", "c" },
+		{ "C", "unsigned char" },
+		{ "s", "short" },
+		{ "S", "unsigned short" },
+		{ "i", "int" },
+		{ "I", "unsigned int" },
+		{ "l", "long" },
+		{ "L", "unsigned long" },
+		{ "q", "long long" },
+		{ "Q", "unsigned long long" },
+		{ "f", "float" },
+		{ "d", "double" },
+		{ "D", "long double" },
+		{ "B", "bool" },
+		{ "v", "void" },
+		{ "*", "char *" },
+		{ "@", "id" },
+		{ "#", "Class" },
+		{ ":", "SEL" },
+		{ "@?", "block" }
+	};
+
+	/**
+	 * the hash only picks the case, the name still has to match
+	 */
+	static inline Primitive ifNamed (const std::string &type, const char *name, Primitive primitive) {
+		return type.compare(name) == 0 ? primitive : Primitive::None;
+	}
+
+	Primitive primitiveForType (const std::string &type) {
+		switch (hashName(type.data(), type.size())) {
+			case hashName("char"): return ifNamed(type, "char", Primitive::Char);
+			case hashName("char16"): return ifNamed(type, "char16", Primitive::Char);
+			case hashName("char32"): return ifNamed(type, "char32", Primitive::Char);
+			case hashName("s_char"): return ifNamed(type, "s_char", Primitive::Char);
+			case hashName("char_s"): return ifNamed(type, "char_s", Primitive::Char);
+			case hashName("char_u"): return ifNamed(type, "char_u", Primitive::UChar);
+			case hashName("uchar"): return ifNamed(type, "uchar", Primitive::UChar);
+			case hashName("unsigned char"): return ifNamed(type, "unsigned char", Primitive::UChar);
+			case hashName("short"): return ifNamed(type, "short", Primitive::Short);
+			case hashName("ushort"): return ifNamed(type, "ushort", Primitive::UShort);
+			case hashName("unsigned short"): return ifNamed(type, "unsigned short", Primitive::UShort);
+			case hashName("int"): return ifNamed(type, "int", Primitive::Int);
+			case hashName("enum"): return ifNamed(type, "enum", Primitive::Int);
+			case hashName("uint"): return ifNamed(type, "uint", Primitive::UInt);
+			case hashName("unsigned int"): return ifNamed(type, "unsigned int", Primitive::UInt);
+			case hashName("long"): return ifNamed(type, "long", Primitive::Long);
+			case hashName("ulong"): return ifNamed(type, "ulong", Primitive::ULong);
+			case hashName("unsigned long"): return ifNamed(type, "unsigned long", Primitive::ULong);
+			case hashName("long_long"): return ifNamed(type, "long_long", Primitive::LongLong);
+			case hashName("long long"): return ifNamed(type, "long long", Primitive::LongLong);
+			case hashName("ulonglong"): return ifNamed(type, "ulonglong", Primitive::ULongLong);
+			case hashName("unsigned long long"): return ifNamed(type, "unsigned long long", Primitive::ULongLong);
+			case hashName("float"): return ifNamed(type, "float", Primitive::Float);
+			case hashName("double"): return ifNamed(type, "double", Primitive::Double);
+			case hashName("long_double"): return ifNamed(type, "long_double", Primitive::LongDouble);
+			case hashName("long double"): return ifNamed(type, "long double", Primitive::LongDouble);
+			case hashName("bool"): return ifNamed(type, "bool", Primitive::Bool);
+			case hashName("_Bool"): return ifNamed(type, "_Bool", Primitive::Bool);
+			case hashName("void"): return ifNamed(type, "void", Primitive::Void);
+			case hashName("char *"): return ifNamed(type, "char *", Primitive::CString);
+			case hashName("obj_interface"): return ifNamed(type, "obj_interface", Primitive::Object);
+			case hashName("objc_pointer"): return ifNamed(type, "objc_pointer", Primitive::Object);
+			case hashName("id"): return ifNamed(type, "id", Primitive::Object);
+			case hashName("Class"): return ifNamed(type, "Class", Primitive::ClassObject);
+			case hashName("SEL"): return ifNamed(type, "SEL", Primitive::Selector);
+			case hashName("block"): return ifNamed(type, "block", Primitive::Block);
+		}
+		return Primitive::None;
+	}
+
+	Primitive primitiveForEncoding (const std::string &encoding) {
+		if (encoding.size() == 2) {
+			return encoding == "@?" ? Primitive::Block : Primitive::None;
+		}
+		if (encoding.size() != 1) {
+			return Primitive::None;
+		}
+		switch (encoding[0]) {
+			case 'c': return Primitive::Char;
+			case 'C': return Primitive::UChar;
+			case 's': return Primitive::Short;
+			case 'S': return Primitive::UShort;
+			case 'i': return Primitive::Int;
+			case 'I': return Primitive::UInt;
+			case 'l': return Primitive::Long;
+			case 'L': return Primitive::ULong;
+			case 'q': return Primitive::LongLong;
+			case 'Q': return Primitive::ULongLong;
+			case 'f': return Primitive::Float;
+			case 'd': return Primitive::Double;
+			case 'D': return Primitive::LongDouble;
+			case 'B': return Primitive::Bool;
+			case 'v': return Primitive::Void;
+			case '*': return Primitive::CString;
+			case '@': return Primitive::Object;
+			case '#': return Primitive::ClassObject;
+			case ':': return Primitive::Selector;
+		}
+		return Primitive::None;
+	}
+
+	const char *encodingOf (Primitive primitive) {
+		return primitives[static_cast<size_t>(primitive)].encoding;
+	}
+
+	const char *typeOf (Primitive primitive) {
+		return primitives[static_cast<size_t>(primitive)].type;
+	}
+}
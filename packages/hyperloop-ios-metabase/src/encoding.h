@@ -0,0 +1,77 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_ENCODING_H
+#define HYPERLOOP_ENCODING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace hyperloop {
+
+	/**
+	 * the types with an Objective-C encoding of their own
+	 */
+	enum class Primitive {
+		None,
+		Char,
+		UChar,
+		Short,
+		UShort,
+		Int,
+		UInt,
+		Long,
+		ULong,
+		LongLong,
+		ULongLong,
+		Float,
+		Double,
+		LongDouble,
+		Bool,
+		Void,
+		CString,
+		Object,
+		ClassObject,
+		Selector,
+		Block
+	};
+
+	/**
+	 * FNV-1a hash of the first length characters of str. It is constexpr so
+	 * names can be switched on, and two names with the same hash are
+	 * rejected by the compiler as duplicate case labels
+	 */
+	constexpr uint32_t hashName (const char *str, size_t length, uint32_t hash = 2166136261u) {
+		return length == 0 ? hash : hashName(str + 1, length - 1, (hash ^ static_cast<unsigned char>(*str)) * 16777619u);
+	}
+
+	template <size_t N>
+	constexpr uint32_t hashName (const char (&str)[N]) {
+		return hashName(str, N - 1);
+	}
+
+	/**
+	 * the primitive a type is, by the type written to the metabase such as
+	 * "uint" or by its C spelling such as "unsigned int"
+	 */
+	Primitive primitiveForType (const std::string &type);
+
+	/**
+	 * the primitive with exactly this encoding
+	 */
+	Primitive primitiveForEncoding (const std::string &encoding);
+
+	/**
+	 * the encoding of a primitive, "?" for None
+	 */
+	const char *encodingOf (Primitive primitive);
+
+	/**
+	 * the type EncodingToType gives a primitive, "unknown" for None
+	 */
+	const char *typeOf (Primitive primitive);
+}
+
+#endif
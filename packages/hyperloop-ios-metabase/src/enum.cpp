@@ -9,8 +9,6 @@
 
 namespace hyperloop {
 
-	static size_t anonEnumCount = 0;
-
 	static CXChildVisitResult parseEnum (CXCursor cursor, CXCursor parent, CXClientData clientData) {
 		auto def = static_cast<EnumDefinition *>(clientData);
 		auto kind = clang_getCursorKind(cursor);
@@ -34,7 +32,7 @@ namespace hyperloop {
 			// this is an nameless enum, in which case we need to generate a enum name so that we
 			// have a valid key
 			char str[10];
-			sprintf(str, "enum_%zu", anonEnumCount++);
+			sprintf(str, "enum_%zu", ctx->nextAnonymousEnum());
 			this->name = std::string(str);
 		}
 	}
@@ -54,7 +52,7 @@ namespace hyperloop {
 		for (auto it = values.begin(); it != values.end(); it++) {
 			v[it->first] = it->second;
 		}
-		kv["values"] = v;
+		kv[keys::values] = v;
 		return kv;
 	}
 
@@ -11,11 +11,12 @@ namespace hyperloop {
 	/**
 	 * Enum definition
 	 */
-	class EnumDefinition : public Definition {
+	class EnumDefinition : public Definition, private Counted<EnumDefinition> {
 	public:
 		EnumDefinition (CXCursor cursor, const std::string &name, ParserContext *ctx);
 		~EnumDefinition ();
 		Json::Value toJSON () const;
+		inline const char* getKind () const { return "enum"; }
 		void setValue (const std::string &name, long long value);
 	private:
 		std::map<std::string, long long> values;
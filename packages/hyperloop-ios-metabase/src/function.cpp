@@ -38,7 +38,7 @@ namespace hyperloop {
 				break;
 			}
 			default: {
-				std::cerr << "not handled, function: " << displayName << " kind: " << kind << std::endl;
+				functionDef->getContext()->diagnose("unhandled.function", displayName + " kind: " + std::to_string(kind));
 				break;
 			}
 		}
@@ -65,15 +65,15 @@ namespace hyperloop {
 		auto tree = this->context->getParserTree();
 		Json::Value kv;
 		toJSONBase(kv);
-		kv["name"] = this->getName();
-		kv["returns"] = returnType->toJSON();
-		kv["arguments"] = arguments.toJSON();
+		kv[keys::name] = this->getName();
+		kv[keys::returns] = returnType->toJSON();
+		kv[keys::arguments] = arguments.toJSON();
 		if (this->variadic && arguments.count()) {
-			kv["variadic"] = true;
+			kv[keys::variadic] = true;
 		}
-		resolveEncoding(tree, kv["returns"], "type", "value");
-		for (auto c = 0; c < kv["arguments"].size(); c++) {
-			resolveEncoding(tree, kv["arguments"][c], "type", "value");
+		resolveEncoding(tree, kv[keys::returns], "type", "value");
+		for (auto c = 0; c < kv[keys::arguments].size(); c++) {
+			resolveEncoding(tree, kv[keys::arguments][c], "type", "value");
 		}
 		return kv;
 	}
@@ -10,11 +10,12 @@
 
 namespace hyperloop {
 
-	class FunctionDefinition : public Definition {
+	class FunctionDefinition : public Definition, private Counted<FunctionDefinition> {
 	public:
 		FunctionDefinition (CXCursor cursor, const std::string &name, ParserContext *ctx);
 		~FunctionDefinition();
 		Json::Value toJSON () const;
+		inline const char* getKind () const { return "function"; }
 		void addArgument(const std::string &argName, const CXCursor &cursor);
 	private:
 		Type *returnType;
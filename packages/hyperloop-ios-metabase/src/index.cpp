@@ -0,0 +1,312 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include "index.h"
+#include "util.h"
+
+#define INDEX_SIGNATURE "hyperloop-metabase-index"
+#define INDEX_VERSION "2"
+
+namespace hyperloop {
+
+	/**
+	 * read a whole file into a string
+	 */
+	static bool readFile (const std::string &path, std::string &contents) {
+		std::ifstream in(path, std::ios::in | std::ios::binary);
+		if (!in) {
+			return false;
+		}
+		std::ostringstream buffer;
+		buffer << in.rdbuf();
+		contents = buffer.str();
+		return true;
+	}
+
+	static std::string headerLine (size_t fileSize, long long fileTime) {
+		std::ostringstream header;
+		header << INDEX_SIGNATURE << "\t" << INDEX_VERSION << "\t" << fileSize << "\t" << fileTime << "\n";
+		return header.str();
+	}
+
+	/**
+	 * decode a JSON string token including its quotes
+	 */
+	static std::string decodeKey (const std::string &json, size_t begin, size_t end) {
+		if (std::find(json.begin() + begin, json.begin() + end, '\\') == json.begin() + end) {
+			return json.substr(begin + 1, end - begin - 2);
+		}
+		Json::Value value;
+		Json::Reader reader;
+		if (reader.parse(json.substr(begin, end - begin), value, false) && value.isString()) {
+			return value.asString();
+		}
+		return json.substr(begin + 1, end - begin - 2);
+	}
+
+	MetabaseIndex::MetabaseIndex (const std::string &_metabaseFile) : metabaseFile(_metabaseFile), bodyOffset(0) {
+	}
+
+	std::string MetabaseIndex::sidecarPath (const std::string &metabaseFile) {
+		return metabaseFile + ".idx";
+	}
+
+	bool MetabaseIndex::scan (const std::string &json, std::vector<IndexEntry> &entries) {
+		// only the root object (depth 1) and the section objects (depth 2) are
+		// interesting, everything below is skipped over as part of a fragment
+		std::vector<char> containers;
+		std::vector<bool> expectKey;
+		std::string section, name;
+		bool pendingValue = false, inValue = false, pendingTable = false, inTable = false;
+		size_t valueStart = 0, lastValueChar = 0, tableStart = 0;
+		const size_t n = json.size();
+
+		auto closeValue = [&](size_t end) {
+			IndexEntry entry;
+			entry.section = section;
+			entry.name = name;
+			entry.offset = valueStart;
+			entry.length = end - valueStart;
+			entries.push_back(entry);
+			inValue = false;
+		};
+
+		// a section that is an array, such as a table of the compact layout,
+		// is one fragment with an empty name
+		auto closeTable = [&](size_t end) {
+			IndexEntry entry;
+			entry.section = section;
+			entry.offset = tableStart;
+			entry.length = end - tableStart;
+			entries.push_back(entry);
+			inTable = false;
+		};
+
+		for (size_t i = 0; i < n; i++) {
+			const char c = json[i];
+			if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+				continue;
+			}
+			const size_t depth = containers.size();
+			if (pendingValue && depth == 2) {
+				pendingValue = false;
+				inValue = true;
+				valueStart = i;
+			}
+			if (pendingTable && depth == 1) {
+				pendingTable = false;
+				inTable = c == '[';
+				tableStart = i;
+			}
+			switch (c) {
+				case '"': {
+					const size_t begin = i++;
+					while (i < n && json[i] != '"') {
+						i += json[i] == '\\' ? 2 : 1;
+					}
+					if (i >= n) {
+						return false;
+					}
+					if (depth > 0 && containers.back() == '{' && expectKey.back()) {
+						expectKey.back() = false;
+						if (depth == 1) {
+							section = decodeKey(json, begin, i + 1);
+						} else if (depth == 2) {
+							name = decodeKey(json, begin, i + 1);
+						}
+					} else if (inValue && depth == 2) {
+						closeValue(i + 1);
+					}
+					lastValueChar = i;
+					break;
+				}
+				case ':': {
+					if (depth == 2) {
+						pendingValue = true;
+					} else if (depth == 1) {
+						pendingTable = true;
+					}
+					break;
+				}
+				case '{':
+				case '[': {
+					containers.push_back(c);
+					expectKey.push_back(c == '{');
+					break;
+				}
+				case '}':
+				case ']': {
+					if (containers.empty()) {
+						return false;
+					}
+					if (inValue && depth == 2) {
+						// scalar value directly before the end of a section
+						closeValue(lastValueChar + 1);
+					}
+					containers.pop_back();
+					expectKey.pop_back();
+					if (inValue && containers.size() == 2) {
+						closeValue(i + 1);
+					} else if (inTable && containers.size() == 1) {
+						closeTable(i + 1);
+					}
+					lastValueChar = i;
+					break;
+				}
+				case ',': {
+					if (inValue && depth == 2) {
+						closeValue(lastValueChar + 1);
+					}
+					if (depth > 0 && containers.back() == '{') {
+						expectKey.back() = true;
+					}
+					break;
+				}
+				default: {
+					lastValueChar = i;
+					break;
+				}
+			}
+		}
+		return containers.empty();
+	}
+
+	std::string MetabaseIndex::serialize (std::vector<IndexEntry> &entries, size_t fileSize, long long fileTime) {
+		std::sort(entries.begin(), entries.end(), [](const IndexEntry &a, const IndexEntry &b) {
+			int c = a.section.compare(b.section);
+			return c == 0 ? a.name < b.name : c < 0;
+		});
+		std::ostringstream out;
+		out << headerLine(fileSize, fileTime);
+		for (auto it = entries.begin(); it != entries.end(); it++) {
+			// names can't contain the separators, but guard against odd input anyway
+			if (it->name.find_first_of("\t\n") != std::string::npos || it->section.find_first_of("\t\n") != std::string::npos) {
+				continue;
+			}
+			out << it->section << "\t" << it->name << "\t" << it->offset << "\t" << it->length << "\n";
+		}
+		return out.str();
+	}
+
+	bool MetabaseIndex::write (const std::string &metabaseFile, std::vector<IndexEntry> &entries) {
+		long long size;
+		long long time;
+		if (!statFile(metabaseFile, size, time)) {
+			return false;
+		}
+		std::ofstream out(sidecarPath(metabaseFile), std::ios::out | std::ios::binary | std::ios::trunc);
+		if (out.fail()) {
+			return false;
+		}
+		out << serialize(entries, static_cast<size_t>(size), time);
+		out.close();
+		return !out.fail();
+	}
+
+	bool MetabaseIndex::load () {
+		long long size;
+		long long time;
+		if (!statFile(metabaseFile, size, time)) {
+			return false;
+		}
+		auto header = headerLine(static_cast<size_t>(size), time);
+		if (!readFile(sidecarPath(metabaseFile), data) || data.compare(0, header.size(), header) != 0) {
+			// missing or stale, rebuild it from the metabase itself
+			std::string json;
+			std::vector<IndexEntry> entries;
+			if (!readFile(metabaseFile, json) || !scan(json, entries)) {
+				return false;
+			}
+			data = serialize(entries, static_cast<size_t>(size), time);
+			std::ofstream out(sidecarPath(metabaseFile), std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!out.fail()) {
+				out << data;
+			}
+		}
+		bodyOffset = header.size();
+		return true;
+	}
+
+	/**
+	 * compare the "section\tname" key of the index line starting at line with key
+	 */
+	static int compareLine (const std::string &data, size_t line, const std::string &key) {
+		size_t end = data.find('\t', line);
+		end = end == std::string::npos ? data.size() : data.find('\t', end + 1);
+		if (end == std::string::npos) {
+			end = data.size();
+		}
+		return data.compare(line, end - line, key);
+	}
+
+	bool MetabaseIndex::find (const std::string &section, const std::string &name, size_t &offset, size_t &length) const {
+		const std::string key = section + "\t" + name;
+		// binary search on byte positions, lo and hi always sit on line starts and
+		// each probe snaps back to the start of the line it falls in
+		size_t lo = bodyOffset, hi = data.size();
+		while (lo < hi) {
+			size_t mid = lo + (hi - lo) / 2;
+			size_t line = mid == lo ? lo : data.rfind('\n', mid - 1) + 1;
+			int c = compareLine(data, line, key);
+			if (c == 0) {
+				const char *fields = data.c_str() + line + key.size() + 1;
+				char *next = nullptr;
+				offset = static_cast<size_t>(strtoull(fields, &next, 10));
+				length = static_cast<size_t>(strtoull(next, nullptr, 10));
+				return true;
+			}
+			if (c < 0) {
+				size_t nextLine = data.find('\n', line);
+				lo = nextLine == std::string::npos ? hi : nextLine + 1;
+			} else {
+				hi = line;
+			}
+		}
+		return false;
+	}
+
+	bool MetabaseIndex::read (const std::string &section, const std::string &name, Json::Value &fragment) const {
+		size_t offset, length;
+		if (!find(section, name, offset, length)) {
+			return false;
+		}
+		std::ifstream in(metabaseFile, std::ios::in | std::ios::binary);
+		if (!in) {
+			return false;
+		}
+		std::string buffer(length, '\0');
+		in.seekg(static_cast<std::streamoff>(offset));
+		if (!in.read(&buffer[0], static_cast<std::streamsize>(length))) {
+			return false;
+		}
+		Json::CharReaderBuilder builder;
+		std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+		std::string errors;
+		return reader->parse(buffer.data(), buffer.data() + buffer.size(), &fragment, &errors);
+	}
+
+	std::vector<std::string> MetabaseIndex::getSections () const {
+		std::vector<std::string> sections;
+		size_t line = bodyOffset;
+		while (line < data.size()) {
+			auto tab = data.find('\t', line);
+			if (tab == std::string::npos) {
+				break;
+			}
+			auto section = data.substr(line, tab - line);
+			if (sections.empty() || sections.back() != section) {
+				sections.push_back(section);
+			}
+			auto next = data.find('\n', line);
+			line = next == std::string::npos ? data.size() : next + 1;
+		}
+		return sections;
+	}
+}
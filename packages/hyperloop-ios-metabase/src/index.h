@@ -0,0 +1,91 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_INDEX_H
+#define HYPERLOOP_INDEX_H
+
+#include <string>
+#include <vector>
+
+#include "json/json.h"
+
+namespace hyperloop {
+
+	/**
+	 * byte range of one symbol's JSON fragment inside a metabase file
+	 */
+	struct IndexEntry {
+		std::string section;
+		std::string name;
+		size_t offset;
+		size_t length;
+	};
+
+	/**
+	 * Index over a metabase JSON file, mapping each section/symbol pair to the
+	 * location of its JSON fragment so a single symbol can be read and parsed
+	 * without loading the whole file.
+	 *
+	 * The index is stored next to the metabase as <file>.idx, a text file
+	 * with a header line followed by one sorted "section\tname\toffset\tlength"
+	 * line per symbol, which lets lookups binary search the raw buffer.
+	 * Sections that are arrays, the files, frameworks and types tables of the
+	 * compact layout, are indexed whole under an empty name.
+	 */
+	class MetabaseIndex {
+		public:
+			MetabaseIndex (const std::string &metabaseFile);
+
+			/**
+			 * load the sidecar index, rebuilding it by scanning the metabase if it
+			 * is missing or out of date. returns false if the metabase can't be read
+			 */
+			bool load ();
+
+			/**
+			 * find the byte range of a symbol, returns false if not indexed
+			 */
+			bool find (const std::string &section, const std::string &name, size_t &offset, size_t &length) const;
+
+			/**
+			 * read and parse the JSON fragment of a symbol
+			 */
+			bool read (const std::string &section, const std::string &name, Json::Value &fragment) const;
+
+			/**
+			 * returns the names of all indexed sections
+			 */
+			std::vector<std::string> getSections () const;
+
+			inline const std::string& getMetabaseFile() const { return metabaseFile; }
+
+			/**
+			 * returns the path of the sidecar index for a metabase file
+			 */
+			static std::string sidecarPath (const std::string &metabaseFile);
+
+			/**
+			 * scan a metabase JSON buffer for the fragments of every section member
+			 */
+			static bool scan (const std::string &json, std::vector<IndexEntry> &entries);
+
+			/**
+			 * serialize entries (in any order) into the sidecar format for a metabase
+			 * file of the given size and modification time
+			 */
+			static std::string serialize (std::vector<IndexEntry> &entries, size_t fileSize, long long fileTime);
+
+			/**
+			 * write entries as the sidecar index of metabaseFile
+			 */
+			static bool write (const std::string &metabaseFile, std::vector<IndexEntry> &entries);
+
+		private:
+			std::string metabaseFile;
+			std::string data;
+			size_t bodyOffset;
+	};
+}
+
+#endif
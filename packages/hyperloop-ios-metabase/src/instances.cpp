@@ -0,0 +1,93 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+#include "instances.h"
+
+namespace hyperloop {
+
+	/**
+	 * every counter created so far, counters are function statics so they
+	 * live as long as the registry
+	 */
+	static std::vector<InstanceCounter *>& registry () {
+		static std::vector<InstanceCounter *> counters;
+		return counters;
+	}
+
+	static std::mutex& registryMutex () {
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	/**
+	 * readable type name without the namespace
+	 */
+	static std::string typeName (const char *mangled) {
+		std::string name = mangled;
+#if defined(__GNUG__)
+		int status = 0;
+		char *demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+		if (status == 0 && demangled) {
+			name = demangled;
+		}
+		free(demangled);
+#endif
+		auto pos = name.rfind("::");
+		return pos == std::string::npos ? name : name.substr(pos + 2);
+	}
+
+	InstanceCounter::InstanceCounter (const char *_name, size_t _size) : name(typeName(_name)), size(_size), live(0), peak(0), total(0) {
+		std::lock_guard<std::mutex> lock(registryMutex());
+		registry().push_back(this);
+	}
+
+	Json::Value InstanceCounter::toJSON () {
+		std::lock_guard<std::mutex> lock(registryMutex());
+		Json::Value kv(Json::objectValue);
+		for (auto it = registry().begin(); it != registry().end(); it++) {
+			auto counter = *it;
+			long long live = counter->live.load(std::memory_order_relaxed);
+			long long peak = counter->peak.load(std::memory_order_relaxed);
+			Json::Value type;
+			type["live"] = static_cast<Json::Int64>(live);
+			type["peak"] = static_cast<Json::Int64>(peak);
+			type["total"] = static_cast<Json::Int64>(counter->total.load(std::memory_order_relaxed));
+			type["size"] = static_cast<Json::UInt64>(counter->size);
+			type["bytes"] = static_cast<Json::Int64>(live * counter->size);
+			type["peakBytes"] = static_cast<Json::Int64>(peak * counter->size);
+			kv[counter->name] = type;
+		}
+		return kv;
+	}
+
+	void measureDocument (const Json::Value &root, unsigned long long &values, unsigned long long &bytes) {
+		values++;
+		bytes += sizeof(Json::Value);
+		if (root.isString()) {
+			char const *begin, *end;
+			if (root.getString(&begin, &end)) {
+				bytes += end - begin;
+			}
+		} else if (root.isObject()) {
+			for (auto it = root.begin(); it != root.end(); it++) {
+				char const *end;
+				char const *begin = it.memberName(&end);
+				if (begin) {
+					bytes += end - begin;
+				}
+				measureDocument(*it, values, bytes);
+			}
+		} else if (root.isArray()) {
+			for (auto it = root.begin(); it != root.end(); it++) {
+				measureDocument(*it, values, bytes);
+			}
+		}
+	}
+}
@@ -0,0 +1,75 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_INSTANCES_H
+#define HYPERLOOP_INSTANCES_H
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <typeinfo>
+
+#include "json/json.h"
+
+namespace hyperloop {
+
+	/**
+	 * live, peak and total instances of one model type. Counting is a couple
+	 * of relaxed atomic operations per construction, so it is always on and
+	 * reported with -stats
+	 */
+	class InstanceCounter {
+		public:
+			InstanceCounter (const char *name, size_t size);
+
+			inline void created () {
+				auto count = live.fetch_add(1, std::memory_order_relaxed) + 1;
+				total.fetch_add(1, std::memory_order_relaxed);
+				auto highest = peak.load(std::memory_order_relaxed);
+				while (count > highest && !peak.compare_exchange_weak(highest, count, std::memory_order_relaxed)) {
+				}
+			}
+
+			inline void destroyed () {
+				live.fetch_sub(1, std::memory_order_relaxed);
+			}
+
+			/**
+			 * every counter by type name with its instances and approximate bytes,
+			 * which only counts the objects themselves and not what they point to
+			 */
+			static Json::Value toJSON ();
+
+		private:
+			std::string name;
+			size_t size;
+			std::atomic<long long> live;
+			std::atomic<long long> peak;
+			std::atomic<long long> total;
+	};
+
+	/**
+	 * counts the instances of T, added as a private base of each model type
+	 */
+	template <typename T>
+	class Counted {
+		protected:
+			Counted () { counter().created(); }
+			Counted (const Counted &) { counter().created(); }
+			~Counted () { counter().destroyed(); }
+
+		private:
+			static InstanceCounter& counter () {
+				static InstanceCounter instance(typeid(T).name(), sizeof(T));
+				return instance;
+			}
+	};
+
+	/**
+	 * number of values in a JSON document and their approximate heap bytes
+	 */
+	void measureDocument (const Json::Value &root, unsigned long long &values, unsigned long long &bytes);
+}
+
+#endif
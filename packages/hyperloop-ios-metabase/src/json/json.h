@@ -126,6 +126,9 @@ license you like.
 /// std::map
 /// as Value container.
 //#  define JSON_USE_CPPTL_SMALLMAP 1
+/// If defined, objects are stored in a std::map as jsoncpp did before
+/// Value::ObjectValues, for comparing against in benchmark/jsondom.cpp.
+//#  define JSON_USE_STD_MAP 1
 
 // If non-zero, the library uses exceptions to report bad input instead of C
 // assertion macros. The default is to use exceptions.
@@ -370,7 +373,10 @@ public:
 #include <exception>
 
 #ifndef JSON_USE_CPPTL_SMALLMAP
+#include <atomic>
+#include <iterator>
 #include <map>
+#include <utility>
 #else
 #include <cpptl/smallmap.h>
 #endif
@@ -568,6 +574,7 @@ private:
     CZString(ArrayIndex index);
     CZString(char const* str, unsigned length, DuplicationPolicy allocate);
     CZString(CZString const& other);
+    CZString(CZString&& other) noexcept;
     ~CZString();
     CZString& operator=(CZString other);
     bool operator<(CZString const& other) const;
@@ -595,7 +602,7 @@ private:
 
 public:
 #ifndef JSON_USE_CPPTL_SMALLMAP
-  typedef std::map<CZString, Value> ObjectValues;
+  class ObjectValues;
 #else
   typedef CppTL::SmallMap<CZString, Value> ObjectValues;
 #endif // ifndef JSON_USE_CPPTL_SMALLMAP
@@ -650,6 +657,8 @@ Json::Value obj_value(Json::objectValue); // {}
   Value(bool value);
   /// Deep copy.
   Value(const Value& other);
+  /// Take over the payload, comments and offsets of other, leaving it null.
+  Value(Value&& other) noexcept;
   ~Value();
 
   /// Deep copy, then swap(other).
@@ -951,6 +960,136 @@ private:
   size_t limit_;
 };
 
+#if !defined(JSONCPP_DOC_EXCLUDE_IMPLEMENTATION) && !defined(JSON_USE_CPPTL_SMALLMAP) && defined(JSON_USE_STD_MAP)
+/** \brief Members of an object, or elements of an array, in a std::map.
+ *
+ * The storage jsoncpp used before the vector based ObjectValues below, with
+ * the same interface. Only built with JSON_USE_STD_MAP, to measure against.
+ */
+class JSON_API Value::ObjectValues : public std::map<CZString, Value> {
+public:
+  typedef std::map<CZString, Value> Map;
+
+  value_type* find(CZString const& key) {
+    Map::iterator it = Map::find(key);
+    return it == Map::end() ? 0 : &*it;
+  }
+  value_type const* find(CZString const& key) const {
+    Map::const_iterator it = Map::find(key);
+    return it == Map::end() ? 0 : &*it;
+  }
+  value_type& insert(CZString&& key) {
+    value_type defaultValue(key, Value());
+    return *Map::insert(defaultValue).first;
+  }
+  bool erase(CZString const& key) { return Map::erase(key) != 0; }
+  value_type const& last() const { return *Map::rbegin(); }
+};
+#elif !defined(JSONCPP_DOC_EXCLUDE_IMPLEMENTATION) && !defined(JSON_USE_CPPTL_SMALLMAP)
+/** \brief Members of an object, or elements of an array, keyed by CZString.
+ *
+ * Replaces the std::map that used to hold them so that building a document
+ * doesn't allocate a node per member. Members are stored in insertion order in
+ * a single vector. Small objects are searched linearly, larger ones through an
+ * open addressing hash table of positions in that vector.
+ *
+ * Iteration is still in key (or index) order, as the rest of the library and
+ * its users expect. Members added in key order, as for arrays, parsed
+ * documents and objects filled from sorted containers, iterate in place, and
+ * so do small objects, which are kept sorted as members are added. For larger
+ * objects filled in any other order, the positions of new members are
+ * appended to a vector that is sorted into key order on the next iteration.
+ * That sort is done under a lock and published through an atomic count, so a
+ * document can still be read from several threads at once.
+ *
+ * \note Unlike std::map, adding a member may move the others, so references
+ * to the members of an object don't survive adding to that object.
+ */
+class JSON_API Value::ObjectValues {
+public:
+  typedef std::pair<CZString, Value> value_type;
+  typedef std::vector<value_type>::size_type size_type;
+
+  /// Bidirectional iterator in key order.
+  template <typename Container, typename Entry>
+  class Iterator {
+  public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef std::pair<CZString, Value> value_type;
+    typedef int difference_type;
+    typedef Entry* pointer;
+    typedef Entry& reference;
+
+    Iterator() : container_(0), position_(0) {}
+    Iterator(Container* container, ArrayIndex position)
+        : container_(container), position_(position) {}
+    template <typename OtherContainer, typename OtherEntry>
+    Iterator(Iterator<OtherContainer, OtherEntry> const& other)
+        : container_(other.container_), position_(other.position_) {}
+
+    Entry& operator*() const { return container_->entryAt(position_); }
+    Entry* operator->() const { return &container_->entryAt(position_); }
+    Iterator& operator++() { ++position_; return *this; }
+    Iterator& operator--() { --position_; return *this; }
+    Iterator operator++(int) { Iterator it(*this); ++position_; return it; }
+    Iterator operator--(int) { Iterator it(*this); --position_; return it; }
+    bool operator==(Iterator const& other) const {
+      return container_ == other.container_ && position_ == other.position_;
+    }
+    bool operator!=(Iterator const& other) const { return !(*this == other); }
+
+  private:
+    template <typename, typename> friend class Iterator;
+    Container* container_;
+    ArrayIndex position_;
+  };
+  typedef Iterator<ObjectValues, value_type> iterator;
+  typedef Iterator<ObjectValues const, value_type const> const_iterator;
+
+  ObjectValues();
+  ObjectValues(ObjectValues const& other);
+
+  iterator begin();
+  iterator end();
+  const_iterator begin() const;
+  const_iterator end() const;
+  size_type size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+  void clear();
+
+  /// Member with the given key, or NULL.
+  value_type* find(CZString const& key);
+  value_type const* find(CZString const& key) const;
+  /// Add a null member, the key must not be present yet.
+  value_type& insert(CZString&& key);
+  /// Remove the member with the given key, returns false if not present.
+  bool erase(CZString const& key);
+  /// Member with the highest key, the container must not be empty.
+  value_type const& last() const;
+
+  bool operator<(ObjectValues const& other) const;
+  bool operator==(ObjectValues const& other) const;
+
+private:
+  value_type& entryAt(ArrayIndex position);
+  value_type const& entryAt(ArrayIndex position) const;
+  ArrayIndex findPosition(CZString const& key) const;
+  void indexEntry(ArrayIndex position);
+  void rebuildIndex();
+  void sortOrder() const;
+
+  std::vector<value_type> entries_;
+  // positions + 1 of entries_, 0 for an empty slot. only used above
+  // linearSearchLimit members, the size is a power of two
+  std::vector<ArrayIndex> slots_;
+  // key order of entries_ when they weren't added in key order. the first
+  // sorted_ positions are in key order, the rest were appended since
+  mutable std::vector<ArrayIndex> order_;
+  mutable std::atomic<ArrayIndex> sorted_;
+  bool inKeyOrder_;
+};
+#endif
+
 /** \brief Experimental and untested: represents an element of the "path" to
  * access a node.
  */
@@ -147,11 +147,33 @@ typedef char UIntToStringBuffer[uintToStringBufferSize];
  *        Must have at least uintToStringBufferSize chars free.
  */
 static inline void uintToString(LargestUInt value, char*& current) {
+  // Emit two digits per division (to_chars style), most values written by
+  // the metabase (enum constants, line numbers) are only a few digits long.
+  static const char digitPairs[201] =
+      "00010203040506070809"
+      "10111213141516171819"
+      "20212223242526272829"
+      "30313233343536373839"
+      "40414243444546474849"
+      "50515253545556575859"
+      "60616263646566676869"
+      "70717273747576777879"
+      "80818283848586878889"
+      "90919293949596979899";
   *--current = 0;
-  do {
-    *--current = static_cast<signed char>(value % 10U + static_cast<unsigned>('0'));
-    value /= 10;
-  } while (value != 0);
+  while (value >= 100) {
+    unsigned const pair = static_cast<unsigned>(value % 100U) * 2U;
+    value /= 100;
+    *--current = digitPairs[pair + 1];
+    *--current = digitPairs[pair];
+  }
+  if (value >= 10) {
+    unsigned const pair = static_cast<unsigned>(value) * 2U;
+    *--current = digitPairs[pair + 1];
+    *--current = digitPairs[pair];
+  } else {
+    *--current = static_cast<char>(value + static_cast<unsigned>('0'));
+  }
 }
 
 /** Change ',' to '.' everywhere in buffer.
@@ -2430,6 +2452,7 @@ ValueIterator& ValueIterator::operator=(const SelfType& other) {
 #endif
 #include <cstddef> // size_t
 #include <algorithm> // min()
+#include <mutex>
 
 #define JSON_ASSERT_UNREACHABLE assert(false)
 
@@ -2649,6 +2672,13 @@ Value::CZString::CZString(const CZString& other)
   storage_.length_ = other.storage_.length_;
 }
 
+Value::CZString::CZString(CZString&& other) noexcept
+    : cstr_(other.cstr_), index_(other.index_)
+{
+  // index_ shares storage with the policy and length of string keys
+  other.cstr_ = 0;
+}
+
 Value::CZString::~CZString() {
   if (cstr_ && storage_.policy_ == duplicate)
     releaseStringValue(const_cast<char*>(cstr_));
@@ -2695,6 +2725,255 @@ const char* Value::CZString::data() const { return cstr_; }
 unsigned Value::CZString::length() const { return storage_.length_; }
 bool Value::CZString::isStaticString() const { return storage_.policy_ == noDuplication; }
 
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class Value::ObjectValues
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+#if !defined(JSON_USE_CPPTL_SMALLMAP) && !defined(JSON_USE_STD_MAP)
+// objects up to this size are searched linearly, larger ones are hashed
+static const ArrayIndex linearSearchLimit = 8;
+
+// held while an object's key order is sorted, which a const read may do
+static std::mutex orderMutex;
+
+static ArrayIndex hashKey(Value::ObjectValues::value_type::first_type const& key) {
+  if (!key.data())
+    return key.index() * 2654435761U;
+  // FNV-1a
+  ArrayIndex hash = 2166136261U;
+  char const* data = key.data();
+  for (unsigned i = 0, length = key.length(); i < length; ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 16777619U;
+  }
+  return hash;
+}
+
+Value::ObjectValues::ObjectValues() : sorted_(0), inKeyOrder_(true) {}
+
+Value::ObjectValues::ObjectValues(ObjectValues const& other)
+    : sorted_(0), inKeyOrder_(other.inKeyOrder_) {
+  // sorted before copying, another thread reading other may be sorting it
+  other.sortOrder();
+  entries_ = other.entries_;
+  slots_ = other.slots_;
+  order_ = other.order_;
+  sorted_.store(ArrayIndex(order_.size()), std::memory_order_relaxed);
+}
+
+Value::ObjectValues::iterator Value::ObjectValues::begin() {
+  sortOrder();
+  return iterator(this, 0);
+}
+
+Value::ObjectValues::iterator Value::ObjectValues::end() {
+  sortOrder();
+  return iterator(this, ArrayIndex(entries_.size()));
+}
+
+Value::ObjectValues::const_iterator Value::ObjectValues::begin() const {
+  sortOrder();
+  return const_iterator(this, 0);
+}
+
+Value::ObjectValues::const_iterator Value::ObjectValues::end() const {
+  sortOrder();
+  return const_iterator(this, ArrayIndex(entries_.size()));
+}
+
+void Value::ObjectValues::clear() {
+  entries_.clear();
+  slots_.clear();
+  order_.clear();
+  sorted_.store(0, std::memory_order_relaxed);
+  inKeyOrder_ = true;
+}
+
+Value::ObjectValues::value_type& Value::ObjectValues::entryAt(ArrayIndex position) {
+  return entries_[inKeyOrder_ ? position : order_[position]];
+}
+
+Value::ObjectValues::value_type const& Value::ObjectValues::entryAt(ArrayIndex position) const {
+  return entries_[inKeyOrder_ ? position : order_[position]];
+}
+
+namespace {
+struct EntryOrder {
+  std::vector<Value::ObjectValues::value_type> const& entries;
+  bool operator()(ArrayIndex a, ArrayIndex b) const {
+    return entries[a].first < entries[b].first;
+  }
+};
+
+struct KeyPosition {
+  char const* data;
+  unsigned length;
+  ArrayIndex position;
+  // the same order as CZString::operator<
+  bool operator<(KeyPosition const& other) const {
+    int comp = memcmp(data, other.data, std::min(length, other.length));
+    return comp < 0 || (comp == 0 && length < other.length);
+  }
+};
+
+struct KeyOrder {
+  bool operator()(Value::ObjectValues::value_type::first_type const& key,
+                  Value::ObjectValues::value_type const& entry) const {
+    return key < entry.first;
+  }
+};
+}
+
+void Value::ObjectValues::sortOrder() const {
+  if (inKeyOrder_ || sorted_.load(std::memory_order_acquire) == order_.size())
+    return;
+  std::lock_guard<std::mutex> lock(orderMutex);
+  const ArrayIndex sorted = sorted_.load(std::memory_order_relaxed);
+  if (sorted == order_.size())
+    return;
+  // only the positions appended since the last sort need sorting. string keys
+  // are sorted from a copy of their data pointers and lengths, so comparing
+  // doesn't also have to load each member
+  EntryOrder compare = { entries_ };
+  if (entries_[order_.back()].first.data()) {
+    std::vector<KeyPosition> keys;
+    keys.reserve(order_.size() - sorted);
+    for (std::vector<ArrayIndex>::iterator it = order_.begin() + sorted; it != order_.end(); ++it) {
+      CZString const& key = entries_[*it].first;
+      KeyPosition entry = { key.data(), key.length(), *it };
+      keys.push_back(entry);
+    }
+    std::sort(keys.begin(), keys.end());
+    for (ArrayIndex i = 0; i < keys.size(); ++i)
+      order_[sorted + i] = keys[i].position;
+  } else {
+    std::sort(order_.begin() + sorted, order_.end(), compare);
+  }
+  std::inplace_merge(order_.begin(), order_.begin() + sorted, order_.end(), compare);
+  sorted_.store(ArrayIndex(order_.size()), std::memory_order_release);
+}
+
+ArrayIndex Value::ObjectValues::findPosition(CZString const& key) const {
+  const ArrayIndex notFound = ArrayIndex(entries_.size());
+  if (slots_.empty()) {
+    for (ArrayIndex i = 0; i < entries_.size(); ++i) {
+      if (entries_[i].first == key)
+        return i;
+    }
+    return notFound;
+  }
+  const ArrayIndex mask = ArrayIndex(slots_.size() - 1);
+  for (ArrayIndex slot = hashKey(key) & mask;; slot = (slot + 1) & mask) {
+    ArrayIndex entry = slots_[slot];
+    if (entry == 0)
+      return notFound;
+    if (entries_[entry - 1].first == key)
+      return entry - 1;
+  }
+}
+
+void Value::ObjectValues::indexEntry(ArrayIndex position) {
+  const ArrayIndex mask = ArrayIndex(slots_.size() - 1);
+  ArrayIndex slot = hashKey(entries_[position].first) & mask;
+  while (slots_[slot] != 0)
+    slot = (slot + 1) & mask;
+  slots_[slot] = position + 1;
+}
+
+void Value::ObjectValues::rebuildIndex() {
+  slots_.clear();
+  if (entries_.size() <= linearSearchLimit)
+    return;
+  // keep the load factor at or below one half
+  size_type capacity = 16;
+  while (capacity < entries_.size() * 2)
+    capacity *= 2;
+  slots_.assign(capacity, 0);
+  for (ArrayIndex i = 0; i < entries_.size(); ++i)
+    indexEntry(i);
+}
+
+Value::ObjectValues::value_type* Value::ObjectValues::find(CZString const& key) {
+  ArrayIndex position = findPosition(key);
+  return position < entries_.size() ? &entries_[position] : 0;
+}
+
+Value::ObjectValues::value_type const* Value::ObjectValues::find(CZString const& key) const {
+  ArrayIndex position = findPosition(key);
+  return position < entries_.size() ? &entries_[position] : 0;
+}
+
+Value::ObjectValues::value_type& Value::ObjectValues::insert(CZString&& key) {
+  const ArrayIndex position = ArrayIndex(entries_.size());
+  if (inKeyOrder_ && !entries_.empty() && !(entries_.back().first < key)) {
+    if (position < linearSearchLimit) {
+      // small objects are kept sorted, moving at most a few members
+      std::vector<value_type>::iterator at =
+          std::upper_bound(entries_.begin(), entries_.end(), key, KeyOrder());
+      return *entries_.insert(at, value_type(std::move(key), Value()));
+    }
+    inKeyOrder_ = false;
+    order_.resize(entries_.size());
+    for (ArrayIndex i = 0; i < position; ++i)
+      order_[i] = i;
+    sorted_.store(position, std::memory_order_relaxed);
+  }
+  entries_.push_back(value_type(std::move(key), Value()));
+  if (!inKeyOrder_)
+    order_.push_back(position);
+  if (entries_.size() * 2 > slots_.size()) {
+    rebuildIndex();
+  } else {
+    indexEntry(ArrayIndex(entries_.size() - 1));
+  }
+  return entries_.back();
+}
+
+bool Value::ObjectValues::erase(CZString const& key) {
+  ArrayIndex position = findPosition(key);
+  if (position == entries_.size())
+    return false;
+  entries_.erase(entries_.begin() + position);
+  if (!inKeyOrder_) {
+    std::vector<ArrayIndex>::iterator at = std::find(order_.begin(), order_.end(), position);
+    const ArrayIndex sorted = sorted_.load(std::memory_order_relaxed);
+    if (ArrayIndex(at - order_.begin()) < sorted)
+      sorted_.store(sorted - 1, std::memory_order_relaxed);
+    order_.erase(at);
+    for (ArrayIndex i = 0; i < order_.size(); ++i) {
+      if (order_[i] > position)
+        --order_[i];
+    }
+  }
+  rebuildIndex();
+  return true;
+}
+
+Value::ObjectValues::value_type const& Value::ObjectValues::last() const {
+  sortOrder();
+  return entries_[inKeyOrder_ ? entries_.size() - 1 : order_.back()];
+}
+
+bool Value::ObjectValues::operator<(ObjectValues const& other) const {
+  return std::lexicographical_compare(begin(), end(), other.begin(), other.end());
+}
+
+bool Value::ObjectValues::operator==(ObjectValues const& other) const {
+  if (entries_.size() != other.entries_.size())
+    return false;
+  for (ArrayIndex i = 0; i < entries_.size(); ++i) {
+    value_type const* match = other.find(entries_[i].first);
+    if (!match || !(match->second == entries_[i].second))
+      return false;
+  }
+  return true;
+}
+#endif
+
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
@@ -2711,6 +2990,7 @@ Value::Value(ValueType vtype) {
   initBasic(vtype);
   switch (vtype) {
   case nullValue:
+    value_.uint_ = 0;
     break;
   case intValue:
   case uintValue:
@@ -2837,6 +3117,12 @@ Value::Value(Value const& other)
   }
 }
 
+Value::Value(Value&& other) noexcept {
+  initBasic(nullValue);
+  value_.uint_ = 0;
+  swap(other);
+}
+
 Value::~Value() {
   switch (type_) {
   case nullValue:
@@ -3258,9 +3544,7 @@ ArrayIndex Value::size() const {
     return 0;
   case arrayValue: // size of the array is highest index + 1
     if (!value_.map_->empty()) {
-      ObjectValues::const_iterator itLast = value_.map_->end();
-      --itLast;
-      return (*itLast).first.index() + 1;
+      return value_.map_->last().first.index() + 1;
     }
     return 0;
   case objectValue:
@@ -3320,13 +3604,11 @@ Value& Value::operator[](ArrayIndex index) {
   if (type_ == nullValue)
     *this = Value(arrayValue);
   CZString key(index);
-  ObjectValues::iterator it = value_.map_->lower_bound(key);
-  if (it != value_.map_->end() && (*it).first == key)
-    return (*it).second;
+  ObjectValues::value_type* found = value_.map_->find(key);
+  if (found)
+    return found->second;
 
-  ObjectValues::value_type defaultValue(key, nullRef);
-  it = value_.map_->insert(it, defaultValue);
-  return (*it).second;
+  return value_.map_->insert(std::move(key)).second;
 }
 
 Value& Value::operator[](int index) {
@@ -3343,10 +3625,10 @@ const Value& Value::operator[](ArrayIndex index) const {
   if (type_ == nullValue)
     return nullRef;
   CZString key(index);
-  ObjectValues::const_iterator it = value_.map_->find(key);
-  if (it == value_.map_->end())
+  ObjectValues::value_type const* found = value_.map_->find(key);
+  if (!found)
     return nullRef;
-  return (*it).second;
+  return found->second;
 }
 
 const Value& Value::operator[](int index) const {
@@ -3375,13 +3657,11 @@ Value& Value::resolveReference(const char* key) {
     *this = Value(objectValue);
   CZString actualKey(
       key, static_cast<unsigned>(strlen(key)), CZString::noDuplication); // NOTE!
-  ObjectValues::iterator it = value_.map_->lower_bound(actualKey);
-  if (it != value_.map_->end() && (*it).first == actualKey)
-    return (*it).second;
+  ObjectValues::value_type* found = value_.map_->find(actualKey);
+  if (found)
+    return found->second;
 
-  ObjectValues::value_type defaultValue(actualKey, nullRef);
-  it = value_.map_->insert(it, defaultValue);
-  Value& value = (*it).second;
+  Value& value = value_.map_->insert(std::move(actualKey)).second;
   return value;
 }
 
@@ -3395,13 +3675,12 @@ Value& Value::resolveReference(char const* key, char const* cend)
     *this = Value(objectValue);
   CZString actualKey(
       key, static_cast<unsigned>(cend-key), CZString::duplicateOnCopy);
-  ObjectValues::iterator it = value_.map_->lower_bound(actualKey);
-  if (it != value_.map_->end() && (*it).first == actualKey)
-    return (*it).second;
+  ObjectValues::value_type* found = value_.map_->find(actualKey);
+  if (found)
+    return found->second;
 
-  ObjectValues::value_type defaultValue(actualKey, nullRef);
-  it = value_.map_->insert(it, defaultValue);
-  Value& value = (*it).second;
+  // copying duplicates the key once, the copy is then moved into place
+  Value& value = value_.map_->insert(CZString(actualKey)).second;
   return value;
 }
 
@@ -3419,9 +3698,9 @@ Value const* Value::find(char const* key, char const* cend) const
       "in Json::Value::find(key, end, found): requires objectValue or nullValue");
   if (type_ == nullValue) return NULL;
   CZString actualKey(key, static_cast<unsigned>(cend-key), CZString::noDuplication);
-  ObjectValues::const_iterator it = value_.map_->find(actualKey);
-  if (it == value_.map_->end()) return NULL;
-  return &(*it).second;
+  ObjectValues::value_type const* found = value_.map_->find(actualKey);
+  if (!found) return NULL;
+  return &found->second;
 }
 const Value& Value::operator[](const char* key) const
 {
@@ -3483,11 +3762,11 @@ bool Value::removeMember(const char* key, const char* cend, Value* removed)
     return false;
   }
   CZString actualKey(key, static_cast<unsigned>(cend-key), CZString::noDuplication);
-  ObjectValues::iterator it = value_.map_->find(actualKey);
-  if (it == value_.map_->end())
+  ObjectValues::value_type* found = value_.map_->find(actualKey);
+  if (!found)
     return false;
-  *removed = it->second;
-  value_.map_->erase(it);
+  *removed = found->second;
+  value_.map_->erase(actualKey);
   return true;
 }
 bool Value::removeMember(const char* key, Value* removed)
@@ -3519,21 +3798,21 @@ bool Value::removeIndex(ArrayIndex index, Value* removed) {
     return false;
   }
   CZString key(index);
-  ObjectValues::iterator it = value_.map_->find(key);
-  if (it == value_.map_->end()) {
+  ObjectValues::value_type* found = value_.map_->find(key);
+  if (!found) {
     return false;
   }
-  *removed = it->second;
+  *removed = found->second;
   ArrayIndex oldSize = size();
   // shift left all items left, into the place of the "removed"
   for (ArrayIndex i = index; i < (oldSize - 1); ++i){
-    CZString keey(i);
-    (*value_.map_)[keey] = (*this)[i + 1];
+    // copy first, taking either element may add it and move the other
+    Value next((*this)[i + 1]);
+    (*this)[i].swap(next);
   }
   // erase the last one ("leftover")
   CZString keyLast(oldSize - 1);
-  ObjectValues::iterator itLast = value_.map_->find(keyLast);
-  value_.map_->erase(itLast);
+  value_.map_->erase(keyLast);
   return true;
 }
 
@@ -3572,8 +3851,9 @@ Value::Members Value::getMemberNames() const {
     return Value::Members();
   Members members;
   members.reserve(value_.map_->size());
-  ObjectValues::const_iterator it = value_.map_->begin();
-  ObjectValues::const_iterator itEnd = value_.map_->end();
+  ObjectValues const& map = *value_.map_;
+  ObjectValues::const_iterator it = map.begin();
+  ObjectValues::const_iterator itEnd = map.end();
   for (; it != itEnd; ++it) {
     members.push_back(std::string((*it).first.data(),
                                   (*it).first.length()));
@@ -4006,6 +4286,18 @@ Value& Path::make(Value& root) const {
 #pragma warning(disable : 4996)
 #endif
 
+// Vectorised scanning for characters that need escaping, see
+// findEscapeCharacter(). Builds without these instruction sets use the
+// scalar loop.
+#if defined(__GNUC__) && defined(__AVX2__)
+#include <immintrin.h>
+#define JSON_USE_AVX2
+#define JSON_USE_SSE2
+#elif defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>
+#define JSON_USE_SSE2
+#endif
+
 namespace Json {
 
 #if __cplusplus >= 201103L
@@ -4014,24 +4306,6 @@ typedef std::unique_ptr<StreamWriter> StreamWriterPtr;
 typedef std::auto_ptr<StreamWriter>   StreamWriterPtr;
 #endif
 
-static bool containsControlCharacter(const char* str) {
-  while (*str) {
-    if (isControlCharacter(*(str++)))
-      return true;
-  }
-  return false;
-}
-
-static bool containsControlCharacter0(const char* str, unsigned len) {
-  char const* end = str + len;
-  while (end != str) {
-    if (isControlCharacter(*str) || 0==*str)
-      return true;
-    ++str;
-  }
-  return false;
-}
-
 std::string valueToString(LargestInt value) {
   UIntToStringBuffer buffer;
   char* current = buffer + sizeof(buffer);
@@ -4099,146 +4373,140 @@ std::string valueToString(double value) { return valueToString(value, false); }
 
 std::string valueToString(bool value) { return value ? "true" : "false"; }
 
-std::string valueToQuotedString(const char* value) {
-  if (value == NULL)
-    return "";
-  // Not sure how to handle unicode...
-  if (strpbrk(value, "\"\\\b\f\n\r\t") == NULL &&
-      !containsControlCharacter(value))
-    return std::string("\"") + value + "\"";
-  // We have to walk value and escape any special characters.
-  // Appending to std::string is not efficient, but this should be rare.
-  // (Note: forward slashes are *not* rare, but I am not escaping them.)
-  std::string::size_type maxsize =
-      strlen(value) * 2 + 3; // allescaped+quotes+NULL
-  std::string result;
-  result.reserve(maxsize); // to avoid lots of mallocs
-  result += "\"";
-  for (const char* c = value; *c != 0; ++c) {
-    switch (*c) {
-    case '\"':
-      result += "\\\"";
-      break;
-    case '\\':
-      result += "\\\\";
-      break;
-    case '\b':
-      result += "\\b";
-      break;
-    case '\f':
-      result += "\\f";
-      break;
-    case '\n':
-      result += "\\n";
-      break;
-    case '\r':
-      result += "\\r";
-      break;
-    case '\t':
-      result += "\\t";
-      break;
-    // case '/':
-    // Even though \/ is considered a legal escape in JSON, a bare
-    // slash is also legal, so I see no reason to escape it.
-    // (I hope I am not misunderstanding something.
-    // blep notes: actually escaping \/ may be useful in javascript to avoid </
-    // sequence.
-    // Should add a flag to allow this compatibility mode and prevent this
-    // sequence from occurring.
-    default:
-      if (isControlCharacter(*c)) {
-        std::ostringstream oss;
-        oss << "\\u" << std::hex << std::uppercase << std::setfill('0')
-            << std::setw(4) << static_cast<int>(*c);
-        result += oss.str();
-      } else {
-        result += *c;
-      }
-      break;
+/// Returns true if ch must be escaped inside a JSON string: '"', '\\' and
+/// the control characters [0, 31].
+static inline bool needsEscaping(char ch) {
+  return static_cast<unsigned char>(ch) < 0x20 || ch == '\"' || ch == '\\';
+}
+
+/// Returns the first character in [begin, end) that needs escaping, or end
+/// if the whole run can be copied verbatim. Metabase output is almost
+/// entirely short ASCII, so scan 32 (AVX2) or 16 (SSE2) bytes at a time and
+/// finish the tail with the scalar check.
+static inline char const* findEscapeCharacter(char const* begin,
+                                              char const* end) {
+  char const* cur = begin;
+#if defined(JSON_USE_AVX2)
+  const __m256i quote32 = _mm256_set1_epi8('\"');
+  const __m256i backslash32 = _mm256_set1_epi8('\\');
+  const __m256i control32 = _mm256_set1_epi8(0x1F);
+  while (end - cur >= 32) {
+    const __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(cur));
+    const __m256i special = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote32),
+                        _mm256_cmpeq_epi8(chunk, backslash32)),
+        // unsigned chunk <= 0x1F
+        _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, control32), chunk));
+    const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(special));
+    if (mask) {
+      return cur + __builtin_ctz(mask);
     }
+    cur += 32;
   }
-  result += "\"";
-  return result;
+#endif
+#if defined(JSON_USE_SSE2)
+  const __m128i quote16 = _mm_set1_epi8('\"');
+  const __m128i backslash16 = _mm_set1_epi8('\\');
+  const __m128i control16 = _mm_set1_epi8(0x1F);
+  while (end - cur >= 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(cur));
+    const __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote16),
+                     _mm_cmpeq_epi8(chunk, backslash16)),
+        // unsigned chunk <= 0x1F
+        _mm_cmpeq_epi8(_mm_min_epu8(chunk, control16), chunk));
+    const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+    if (mask) {
+      return cur + __builtin_ctz(mask);
+    }
+    cur += 16;
+  }
+#endif
+  while (cur != end && !needsEscaping(*cur)) {
+    ++cur;
+  }
+  return cur;
 }
 
-// https://github.com/upcaste/upcaste/blob/master/src/upcore/src/cstring/strnpbrk.cpp
-static char const* strnpbrk(char const* s, char const* accept, size_t n) {
-  assert((s || !n) && accept);
-
-  char const* const end = s + n;
-  for (char const* cur = s; cur < end; ++cur) {
-    int const c = *cur;
-    for (char const* a = accept; *a; ++a) {
-      if (*a == c) {
-        return cur;
-      }
-    }
+/// Appends the JSON escape sequence for ch, which must satisfy needsEscaping().
+static inline void appendEscapedCharacter(std::string& result, char ch) {
+  switch (ch) {
+  case '\"':
+    result += "\\\"";
+    break;
+  case '\\':
+    result += "\\\\";
+    break;
+  case '\b':
+    result += "\\b";
+    break;
+  case '\f':
+    result += "\\f";
+    break;
+  case '\n':
+    result += "\\n";
+    break;
+  case '\r':
+    result += "\\r";
+    break;
+  case '\t':
+    result += "\\t";
+    break;
+  // case '/':
+  // Even though \/ is considered a legal escape in JSON, a bare
+  // slash is also legal, so I see no reason to escape it.
+  // (I hope I am not misunderstanding something.)
+  // blep notes: actually escaping \/ may be useful in javascript to avoid </
+  // sequence.
+  // Should add a flag to allow this compatibility mode and prevent this
+  // sequence from occurring.
+  default: {
+    static const char hexDigits[] = "0123456789ABCDEF";
+    const unsigned char code = static_cast<unsigned char>(ch);
+    const char escaped[6] = { '\\', 'u', '0', '0', hexDigits[code >> 4],
+                              hexDigits[code & 0xF] };
+    result.append(escaped, sizeof(escaped));
+    break;
+  }
   }
-  return NULL;
 }
+
 static std::string valueToQuotedStringN(const char* value, unsigned length) {
   if (value == NULL)
     return "";
-  // Not sure how to handle unicode...
-  if (strnpbrk(value, "\"\\\b\f\n\r\t", length) == NULL &&
-      !containsControlCharacter0(value, length))
-    return std::string("\"") + value + "\"";
-  // We have to walk value and escape any special characters.
-  // Appending to std::string is not efficient, but this should be rare.
-  // (Note: forward slashes are *not* rare, but I am not escaping them.)
-  std::string::size_type maxsize =
-      length * 2 + 3; // allescaped+quotes+NULL
+  char const* const end = value + length;
+  char const* special = findEscapeCharacter(value, end);
   std::string result;
-  result.reserve(maxsize); // to avoid lots of mallocs
-  result += "\"";
-  char const* end = value + length;
-  for (const char* c = value; c != end; ++c) {
-    switch (*c) {
-    case '\"':
-      result += "\\\"";
-      break;
-    case '\\':
-      result += "\\\\";
-      break;
-    case '\b':
-      result += "\\b";
-      break;
-    case '\f':
-      result += "\\f";
-      break;
-    case '\n':
-      result += "\\n";
-      break;
-    case '\r':
-      result += "\\r";
-      break;
-    case '\t':
-      result += "\\t";
-      break;
-    // case '/':
-    // Even though \/ is considered a legal escape in JSON, a bare
-    // slash is also legal, so I see no reason to escape it.
-    // (I hope I am not misunderstanding something.)
-    // blep notes: actually escaping \/ may be useful in javascript to avoid </
-    // sequence.
-    // Should add a flag to allow this compatibility mode and prevent this
-    // sequence from occurring.
-    default:
-      if ((isControlCharacter(*c)) || (*c == 0)) {
-        std::ostringstream oss;
-        oss << "\\u" << std::hex << std::uppercase << std::setfill('0')
-            << std::setw(4) << static_cast<int>(*c);
-        result += oss.str();
-      } else {
-        result += *c;
-      }
-      break;
-    }
-  }
-  result += "\"";
+  if (special == end) {
+    result.reserve(length + 2);
+    result += '\"';
+    result.append(value, length);
+    result += '\"';
+    return result;
+  }
+  // Copy the clean runs in bulk and only escape the special characters.
+  result.reserve(length + (length >> 2) + 8);
+  result += '\"';
+  char const* run = value;
+  while (special != end) {
+    result.append(run, static_cast<size_t>(special - run));
+    appendEscapedCharacter(result, *special);
+    run = special + 1;
+    special = findEscapeCharacter(run, end);
+  }
+  result.append(run, static_cast<size_t>(end - run));
+  result += '\"';
   return result;
 }
 
+std::string valueToQuotedString(const char* value) {
+  if (value == NULL)
+    return "";
+  return valueToQuotedStringN(value, static_cast<unsigned>(strlen(value)));
+}
+
 // Class Writer
 // //////////////////////////////////////////////////////////////////
 Writer::~Writer() {}
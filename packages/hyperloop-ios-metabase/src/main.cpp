@@ -5,14 +5,32 @@
 
 #include "clang-c/Index.h"
 
+#include <algorithm>
+#include <cstring>
 #include <map>
 #include <string>
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <cerrno>
+#include <sys/stat.h>
 
 #include "util.h"
 #include "parser.h"
+#include "query.h"
+#include "batch.h"
+#include "sdk.h"
+#include "merge.h"
+#include "stats.h"
+#include "trace.h"
+#include "report.h"
+#include "diagnostics.h"
+#include "writer.h"
+#include "parallel.h"
+#include "shards.h"
+#include "astcache.h"
+#include "watch.h"
 #include "json/json.h"
 
 /**
@@ -55,27 +73,182 @@ static void showHelp (const std::string& programName) {
     std::cout << "  -o                  full path to output JSON file, will be created or overwritten " << std::endl;
     std::cout << "  -sim-sdk-path       full path to the iPhone simulator SDK, run:                   " << std::endl;
     std::cout << "                        xcrun --sdk iphonesimulator --show-sdk-path                 " << std::endl;
-    std::cout << "  -min-ios-ver        minimum iOS version to use                                    " << std::endl;
+    std::cout << "  -min-ios-ver        minimum iOS version to use, comma separated to parse once and " << std::endl;
+    std::cout << "                        write a <output>-<version>.json for each version            " << std::endl;
     std::cout << "  -hsp                full path to header search paths, comma separated             " << std::endl;
     std::cout << "  -pretty             output should be prettified JSON (false by default)           " << std::endl;
     std::cout << "  -x                  exclude system APIs (false by default)                        " << std::endl;
+    std::cout << "  -modules            full path to a clang module cache directory, frameworks with a" << std::endl;
+    std::cout << "                        module map are built into it as modules once and reused     " << std::endl;
+    std::cout << "  -ast-cache          full path to a directory keeping the parsed translation unit, " << std::endl;
+    std::cout << "                        loaded instead of parsed while none of its headers changed  " << std::endl;
+    std::cout << "  -watch              keep running and write the metabase again when a header it    " << std::endl;
+    std::cout << "                        includes or a search path changes, printing a line of JSON  " << std::endl;
+    std::cout << "                        with the definitions added, changed and removed each time   " << std::endl;
+    std::cout << "  -debounce           milliseconds without changes before -watch generates again,   " << std::endl;
+    std::cout << "                        100 by default                                              " << std::endl;
+    std::cout << "  -schema             metabase api-version to write, 1 (default) or 2 for the       " << std::endl;
+    std::cout << "                        compact layout with shared file, framework and type tables  " << std::endl;
+    std::cout << "  -threads            threads resolving the definitions, the number of cores by     " << std::endl;
+    std::cout << "                        default, 1 resolves them on the main thread                 " << std::endl;
+    std::cout << "  -index              also write a <output>.idx index of symbol byte offsets        " << std::endl;
+    std::cout << "  -shards             full path to a directory to write a metabase per framework to," << std::endl;
+    std::cout << "                        each as soon as the parse is done with its headers, -o is   " << std::endl;
+    std::cout << "                        optional then                                               " << std::endl;
+    std::cout << "  -stats              full path to a JSON file to write phase timings, definition   " << std::endl;
+    std::cout << "                        counts, bytes written, memory and model instances to        " << std::endl;
+    std::cout << "  -trace              full path to a Chrome trace event JSON file to write, opens   " << std::endl;
+    std::cout << "                        in chrome://tracing or Perfetto                             " << std::endl;
+    std::cout << "  -trace-threshold    milliseconds parsing a definition takes before it is traced   " << std::endl;
+    std::cout << "                        (1 by default)                                              " << std::endl;
+    std::cout << "  -report             full path to a JSON file to write the definitions, traversal  " << std::endl;
+    std::cout << "                        time and output bytes of every header, framework and import " << std::endl;
+    std::cout << "  -report-sort        order of the report, time (default), bytes or definitions     " << std::endl;
+    std::cout << "  -profile-clang      full path to a JSON file to write the calls and time of every " << std::endl;
+    std::cout << "                        libclang function, per function and per definition kind     " << std::endl;
+    std::cout << "  -diagnostics        full path to a JSON file to write clang's and the generator's " << std::endl;
+    std::cout << "                        warnings to, counted by kind, stderr by default             " << std::endl;
+    std::cout << "  -diagnostics-limit  examples kept per kind of diagnostic (10 by default)          " << std::endl;
+    std::cout << "                                                                                    " << std::endl;
+    std::cout << "Usage: " << name << " query -m <metabase> [option] <argument>                       " << std::endl;
+    std::cout << "                                                                                    " << std::endl;
+    std::cout << "Answers lookups against an existing metabase using a <metabase>.idx index, which    " << std::endl;
+    std::cout << "is created next to the metabase on first use                                       " << std::endl;
+    std::cout << "                                                                                    " << std::endl;
+    std::cout << "Query Options:                                                                      " << std::endl;
+    std::cout << "  -m                  full path to the metabase JSON file to query                  " << std::endl;
+    std::cout << "  -class              class with its superclass chain and inherited members         " << std::endl;
+    std::cout << "  -symbol             sections and frameworks that define a symbol                  " << std::endl;
+    std::cout << "  -struct             encoding and fields of a struct, following typedefs           " << std::endl;
+    std::cout << "  -section, -name     raw JSON of one symbol in a section                           " << std::endl;
+    std::cout << "  -pretty             output should be prettified JSON (false by default)           " << std::endl;
+    std::cout << "                                                                                    " << std::endl;
+    std::cout << "Usage: " << name << " batch -m <manifest> [option] <argument>                       " << std::endl;
+    std::cout << "                                                                                    " << std::endl;
+    std::cout << "Generates every metabase of a JSON manifest in one process. The manifest has a jobs " << std::endl;
+    std::cout << "array and optional defaults, each job takes the generator options without the dash, " << std::endl;
+    std::cout << "like i, o, sim-sdk-path, min-ios-ver, hsp, fsp, x, pretty, schema, index, modules   " << std::endl;
+    std::cout << "and ast-cache. Jobs of the same header, SDK and search paths share one parse, the   " << std::endl;
+    std::cout << "rest run side by side                                                               " << std::endl;
+    std::cout << "                                                                                    " << std::endl;
+    std::cout << "Batch Options:                                                                      " << std::endl;
+    std::cout << "  -m                  full path to the manifest JSON file                           " << std::endl;
+    std::cout << "  -threads            jobs parsed at the same time, the number of cores by default  " << std::endl;
+    std::cout << "  -results            full path to a JSON file to write the result of every job to, " << std::endl;
+    std::cout << "                        stdout by default                                           " << std::endl;
+    std::cout << "                                                                                    " << std::endl;
+    std::cout << "Usage: " << name << " serve [option] <argument>                                     " << std::endl;
+    std::cout << "                                                                                    " << std::endl;
+    std::cout << "Generates a metabase for every line of JSON read from stdin, a job like those of a  " << std::endl;
+    std::cout << "batch manifest with the options given on the command line as its defaults, and an   " << std::endl;
+    std::cout << "optional unsaved object of file names to contents used instead of those files. The  " << std::endl;
+    std::cout << "imports at the top of a header are precompiled once, a later request of the same    " << std::endl;
+    std::cout << "header, SDK, search paths and min version only reparses what follows them. Prints   " << std::endl;
+    std::cout << "the result of each request as a line of JSON                                        " << std::endl;
+    std::cout << "                                                                                    " << std::endl;
+    std::cout << "Serve Options:                                                                      " << std::endl;
+    std::cout << "  -threads            threads resolving the definitions, the number of cores by     " << std::endl;
+    std::cout << "                        default                                                     " << std::endl;
+    std::cout << "  -sessions           translation units kept for later requests, 4 by default       " << std::endl;
+    std::cout << "                                                                                    " << std::endl;
+    std::cout << "Usage: " << name << " sdk -sim-sdk-path <sdk> -min-ios-ver <version> -o <dir> [option]" << std::endl;
+    std::cout << "                                                                                    " << std::endl;
+    std::cout << "Writes a metabase per framework of an SDK to <dir>/<sdk version>/<min version>, with" << std::endl;
+    std::cout << "an index.json of their files and dependencies. Each framework umbrella is parsed on " << std::endl;
+    std::cout << "its own, side by side, and frameworks already in the cache are kept                 " << std::endl;
+    std::cout << "                                                                                    " << std::endl;
+    std::cout << "SDK Options:                                                                        " << std::endl;
+    std::cout << "  -threads            frameworks parsed at the same time, the number of cores by    " << std::endl;
+    std::cout << "                        default                                                     " << std::endl;
+    std::cout << "  -frameworks         comma separated frameworks to write, all of them by default   " << std::endl;
+    std::cout << "  -force              write frameworks again that are already in the cache          " << std::endl;
+    std::cout << "  -schema, -pretty    as for a metabase, also -hsp, -fsp, -index and -modules       " << std::endl;
+    std::cout << "  -ast-cache          as for a metabase, keeping a translation unit per framework   " << std::endl;
+    std::cout << "                                                                                    " << std::endl;
+    std::cout << "Usage: " << name << " merge -i <metabases> -o <output> [option]                     " << std::endl;
+    std::cout << "                                                                                    " << std::endl;
+    std::cout << "Merges metabases into one, reading one at a time. Classes and protocols of the same " << std::endl;
+    std::cout << "name are merged, a later method or property replacing an earlier one like a         " << std::endl;
+    std::cout << "category does, extensions go into their class and blocks are kept once per          " << std::endl;
+    std::cout << "signature. Other definitions keep the first input that has them                     " << std::endl;
+    std::cout << "                                                                                    " << std::endl;
+    std::cout << "Merge Options:                                                                      " << std::endl;
+    std::cout << "  -i                  comma separated metabases, shards directories or SDK cache    " << std::endl;
+    std::cout << "                        directories, in the order to merge them                     " << std::endl;
+    std::cout << "  -o                  full path to output JSON file, will be created or overwritten " << std::endl;
+    std::cout << "  -schema, -pretty    as for a metabase, also -index                                " << std::endl;
     std::cout << "                                                                                    " << std::endl;
     std::cout << "Example                                                                             " << std::endl;
     std::cout << "  " << name << " -i objc.h -o metabase.json -sim-sdk-path /Applications/Xcode.app/Contents/Developer/Platforms/iPhoneSimulator.platform/Developer/SDKs/iPhoneSimulator9.0.sdk -min-ios-ver 9.0" << std::endl;
+    std::cout << "  " << name << " query -m metabase.json -class UIButton" << std::endl;
     std::cout << std::endl << std::endl;
 }
 
+/**
+ * the output file of one of several minimum versions, metabase.json becomes
+ * metabase-9.0.json
+ */
+static std::string targetOutputFile (const std::string &output, const std::string &version) {
+	auto slash = output.find_last_of('/');
+	auto dot = output.find_last_of('.');
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+		return output + "-" + version;
+	}
+	return output.substr(0, dot) + "-" + version + output.substr(dot);
+}
+
 /**
  * main entry points
  */
 int main(int argc, char* argv[]) {
+	if (argc > 1 && std::string(argv[1]) == "query") {
+		auto arguments = argvToMap(argc - 1, argv + 1);
+		if (arguments.count("-h")) {
+			showHelp(std::string(argv[0]));
+			return EXIT_FAILURE;
+		}
+		return hyperloop::query(arguments);
+	}
+	if (argc > 1 && std::string(argv[1]) == "batch") {
+		auto arguments = argvToMap(argc - 1, argv + 1);
+		if (arguments.count("-h")) {
+			showHelp(std::string(argv[0]));
+			return EXIT_FAILURE;
+		}
+		return hyperloop::batch(arguments);
+	}
+	if (argc > 1 && std::string(argv[1]) == "serve") {
+		auto arguments = argvToMap(argc - 1, argv + 1);
+		if (arguments.count("-h")) {
+			showHelp(std::string(argv[0]));
+			return EXIT_FAILURE;
+		}
+		return hyperloop::serve(arguments);
+	}
+	if (argc > 1 && std::string(argv[1]) == "sdk") {
+		auto arguments = argvToMap(argc - 1, argv + 1);
+		if (arguments.count("-h")) {
+			showHelp(std::string(argv[0]));
+			return EXIT_FAILURE;
+		}
+		return hyperloop::sdk(arguments);
+	}
+	if (argc > 1 && std::string(argv[1]) == "merge") {
+		auto arguments = argvToMap(argc - 1, argv + 1);
+		if (arguments.count("-h")) {
+			showHelp(std::string(argv[0]));
+			return EXIT_FAILURE;
+		}
+		return hyperloop::merge(arguments);
+	}
+
 	auto arguments = argvToMap(argc, argv);
 	bool showsHelp = false;
 
 	if (arguments.count("-h")){
 		showsHelp = true;
 	}
-	if (!arguments.count("-o")) {
+	if (!arguments.count("-o") && !arguments.count("-shards")) {
 		showsHelp = true;
 	}
 	if (!arguments.count("-i")) {
@@ -91,6 +264,17 @@ int main(int argc, char* argv[]) {
 		showHelp(std::string(argv[0]));
 		return EXIT_FAILURE;
 	}
+	if (arguments.count("-schema") && !hyperloop::ParserTree::isSupportedAPIVersion(arguments["-schema"])) {
+		std::cerr << "unsupported schema version: " << arguments["-schema"] << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (arguments.count("-report-sort") && !hyperloop::HeaderReport::isSupportedSortKey(arguments["-report-sort"])) {
+		std::cerr << "unsupported report sort: " << arguments["-report-sort"] << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (arguments.count("-watch")) {
+		return hyperloop::watch(arguments);
+	}
 
 	auto output_file = arguments["-o"];
 	auto input_header = arguments["-i"];;
@@ -99,87 +283,178 @@ int main(int argc, char* argv[]) {
 	auto iphone_sim_root = arguments["-sim-sdk-path"];
 	auto prettify = arguments.count("-pretty") > 0;
 	auto excludeSys = arguments.count("-x") > 0;
+	auto writeIndex = arguments.count("-index") > 0;
+	auto shardsDir = arguments.count("-shards") ? arguments["-shards"] : "";
+	auto statsFile = arguments.count("-stats") ? arguments["-stats"] : "";
+	auto traceFile = arguments.count("-trace") ? arguments["-trace"] : "";
+	auto traceThreshold = arguments.count("-trace-threshold") ? atof(arguments["-trace-threshold"].c_str()) : 1.0;
+	auto reportFile = arguments.count("-report") ? arguments["-report"] : "";
+	auto reportSort = arguments.count("-report-sort") ? arguments["-report-sort"] : "time";
+	auto profileFile = arguments.count("-profile-clang") ? arguments["-profile-clang"] : "";
+	auto diagnosticsFile = arguments.count("-diagnostics") ? arguments["-diagnostics"] : "";
+	auto diagnosticsLimit = arguments.count("-diagnostics-limit") ? atoi(arguments["-diagnostics-limit"].c_str()) : 10;
+	auto schema = arguments.count("-schema") ? arguments["-schema"] : "1";
+	auto threads = arguments.count("-threads") ? atoi(arguments["-threads"].c_str()) : static_cast<int>(hyperloop::defaultThreads());
 	auto bitArch = arguments.count("-bit") ? arguments["-bit"] : "64";
 	auto includes = hyperloop::tokenize(arguments["-hsp"], ",");
 	auto frameworks = hyperloop::tokenize(arguments["-fsp"], ",");
+	auto moduleCache = arguments.count("-modules") ? arguments["-modules"] : "";
+	auto astCache = arguments.count("-ast-cache") ? arguments["-ast-cache"] : "";
 
-	std::string min_ios_version_command("-mios-simulator-version-min=" + min_ios_version);
-
-	std::vector<const char*> args;
-	args.push_back("-x");
-	args.push_back("objective-c");
-	args.push_back(min_ios_version_command.c_str());
-	args.push_back("-O0");
-	args.push_back("-g");
-	args.push_back("-fobjc-abi-version=2");
-	args.push_back("-fobjc-legacy-dispatch");
-	args.push_back("-fpascal-strings");
-	args.push_back("-fexceptions");
-	args.push_back("-fasm-blocks");
-	args.push_back("-fstrict-aliasing");
-	args.push_back("-fmessage-length=0");
-	args.push_back("-fdiagnostics-show-note-include-stack");
-	args.push_back("-fmacro-backtrace-limit=0");
-
-	if (includes.size() > 0) {
-		for (auto i = 0; i < includes.size(); i++) {
-			auto each = includes[i];
-			if (each.at(0) == (int)'"') {
-				each = each.substr(1);
-			}
-			if (each.at(each.length() - 1) == (int)'"') {
-				each = each.substr(0, each.length() - 1);
-			}
-			args.push_back("-I");
-			args.push_back(strdup(each.c_str()));
+	// every version is written from one parse at the lowest of them
+	auto targets = hyperloop::tokenize(min_ios_version, ",");
+	for (auto it = targets.begin(); it != targets.end(); it++) {
+		hyperloop::trim(*it);
+	}
+	std::stable_sort(targets.begin(), targets.end(), [](const std::string &a, const std::string &b) {
+		return hyperloop::compareVersions(hyperloop::parseVersion(a), hyperloop::parseVersion(b)) < 0;
+	});
+	targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+	if (targets.empty()) {
+		std::cerr << "no minimum iOS version given" << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (!shardsDir.empty() && targets.size() > 1) {
+		std::cerr << "shards are written for one minimum iOS version" << std::endl;
+		return EXIT_FAILURE;
+	}
+	min_ios_version = targets.front();
+	std::vector<std::string> outputFiles;
+	for (auto it = targets.begin(); it != targets.end() && !output_file.empty(); it++) {
+		outputFiles.push_back(targets.size() > 1 ? targetOutputFile(output_file, *it) : output_file);
+	}
+	if (!shardsDir.empty() && mkdir(shardsDir.c_str(), 0755) != 0 && errno != EEXIST) {
+		std::cerr << "couldn't create shards directory: " << shardsDir << " with error code " << strerror(errno) << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	auto compilerArgs = hyperloop::compilerArguments(input_header, iphone_sim_root, min_ios_version, includes, frameworks, moduleCache);
+
+	std::vector<std::unique_ptr<std::ofstream>> outs;
+	for (auto it = outputFiles.begin(); it != outputFiles.end(); it++) {
+		outs.emplace_back(new std::ofstream(*it));
+		if (outs.back()->fail()) {
+			std::cerr << "open failed for file: " << *it << " with error code " << strerror(errno) << std::endl;
+			return EXIT_FAILURE;
 		}
 	}
-	if (frameworks.size() > 0) {
-		for (auto i = 0; i < frameworks.size(); i++) {
-			auto each = frameworks[i];
-			if (each.at(0) == (int)'"') {
-				each = each.substr(1);
-			}
-			if (each.at(each.length() - 1) == (int)'"') {
-				each = each.substr(0, each.length() - 1);
+	std::unique_ptr<hyperloop::Stats> stats(statsFile.empty() ? nullptr : new hyperloop::Stats());
+	std::unique_ptr<hyperloop::Trace> trace(traceFile.empty() ? nullptr : new hyperloop::Trace(static_cast<unsigned long long>(traceThreshold * 1000)));
+	std::unique_ptr<hyperloop::HeaderReport> report(reportFile.empty() ? nullptr : new hyperloop::HeaderReport());
+	std::unique_ptr<hyperloop::ClangProfiler> profiler(profileFile.empty() ? nullptr : new hyperloop::ClangProfiler());
+	hyperloop::ClangProfiler::setCurrent(profiler.get());
+	hyperloop::Diagnostics diagnostics(diagnosticsLimit < 0 ? 0 : diagnosticsLimit);
+	std::unique_ptr<hyperloop::ShardWriter> shards(shardsDir.empty() ? nullptr : new hyperloop::ShardWriter(shardsDir, schema, prettify, writeIndex));
+	// diagnostics are collected from the translation unit instead of printed
+	// declarations loaded from modules are only visited if not excluded
+	auto index = clang_createIndex(moduleCache.empty() ? 1 : 0, 0);
+	CXTranslationUnit tu;
+	{
+		hyperloop::StatsPhase phase(stats.get(), "parseTranslationUnit");
+		hyperloop::TraceSpan span(trace.get(), "parseTranslationUnit");
+		hyperloop::ClangSite site("parseTranslationUnit");
+		tu = hyperloop::parseTranslationUnit(index, compilerArgs, astCache, diagnostics);
+	}
+	auto ctx = hyperloop::parse(tu, iphone_sim_root, min_ios_version, excludeSys, stats.get(), trace.get(), report.get(), &diagnostics, shards.get());
+	ctx->setThreads(threads < 1 ? 1 : threads);
+	auto tree = ctx->getParserTree();
+	if (shards) {
+		hyperloop::StatsPhase phase(stats.get(), "shards");
+		hyperloop::TraceSpan span(trace.get(), "shards");
+		if (!shards->finish(ctx->getThreads())) {
+			std::cerr << "couldn't write shards to directory: " << shardsDir << std::endl;
+			return EXIT_FAILURE;
+		}
+		if (stats && outputFiles.empty()) {
+			stats->sampleInstances();
+		}
+	}
+	// the report, stats and index describe the first, lowest target. Resolving
+	// rewrites types in place as their definitions are found, and the higher
+	// the target the fewer are available, so targets are resolved highest
+	// first: what one rewrites, every lower target would rewrite the same way
+	Json::Value root;
+	std::vector<std::unique_ptr<hyperloop::MetabaseWriter>> writers(outputFiles.size());
+	for (size_t i = outputFiles.size(); i-- > 0;) {
+		auto target = tree->toJSON(schema, targets[i]);
+		if (stats && i == 0) {
+			// while the whole model is still alive
+			stats->sampleInstances();
+			stats->measureDocument(target);
+		}
+		auto &out = *outs[i];
+		writers[i].reset(new hyperloop::MetabaseWriter(out, prettify));
+		{
+			hyperloop::StatsPhase phase(stats.get(), "write");
+			hyperloop::TraceSpan span(trace.get(), "write");
+			writers[i]->write(target);
+			out << std::endl;
+			out.flush();
+			out.close();
+		}
+		if (i == 0) {
+			root.swap(target);
+		}
+	}
+	delete ctx;
+
+	clang_disposeTranslationUnit(tu);
+	clang_disposeIndex(index);
+
+	// the index is keyed on the size and time of the finished file, so write it last
+	if (writeIndex) {
+		hyperloop::StatsPhase phase(stats.get(), "index");
+		hyperloop::TraceSpan span(trace.get(), "index");
+		for (size_t i = 0; i < outputFiles.size(); i++) {
+			if (!hyperloop::MetabaseIndex::write(outputFiles[i], writers[i]->getEntries())) {
+				std::cerr << "couldn't write index for file: " << outputFiles[i] << std::endl;
+				return EXIT_FAILURE;
 			}
-			args.push_back("-F");
-			args.push_back(strdup(each.c_str()));
 		}
 	}
 
-	args.push_back("-v");
-	args.push_back("-isysroot");
-	args.push_back(iphone_sim_root.c_str());
-	args.push_back(input_header.c_str());
+	if (report) {
+		if (!writers.empty()) {
+			report->addBytes(root, writers.front()->getEntries());
+		}
+		if (!report->write(reportFile, reportSort)) {
+			std::cerr << "couldn't write report to file: " << reportFile << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
 
-	std::ofstream out(output_file);
-	if (out.fail()) {
-		std::cerr << "open failed for file: " << output_file << " with error code " << strerror(errno) << std::endl;
+	if (trace && !trace->write(traceFile)) {
+		std::cerr << "couldn't write trace to file: " << traceFile << std::endl;
 		return EXIT_FAILURE;
 	}
-	auto index = clang_createIndex(1, 1);
-	auto tu = clang_parseTranslationUnit(index, nullptr, &args[0], (int)args.size(), nullptr, 0, 0);
-	auto ctx = hyperloop::parse(tu, iphone_sim_root, min_ios_version, excludeSys);
-	auto tree = ctx->getParserTree();
-	auto root = tree->toJSON();
-	Json::Reader reader;
-	Json::StreamWriterBuilder builder;
-
-	if (prettify) {
-		builder.settings_["commentStyle"] = "None";
-		builder.settings_["indentation"] = "\t";
-	} else {
+
+	if (!diagnosticsFile.empty()) {
+		if (!diagnostics.write(diagnosticsFile)) {
+			std::cerr << "couldn't write diagnostics to file: " << diagnosticsFile << std::endl;
+			return EXIT_FAILURE;
+		}
+	} else if (diagnostics.getCount() > 0) {
+		// one bounded summary instead of a line per message
+		Json::StreamWriterBuilder builder;
 		builder.settings_["indentation"] = "";
+		std::cerr << Json::writeString(builder, diagnostics.toJSON()) << std::endl;
 	}
-	out << Json::writeString(builder, root) << std::endl;
-	out.flush();
-	out.close();
 
-	delete ctx;
+	if (profiler) {
+		hyperloop::ClangProfiler::setCurrent(nullptr);
+		if (!profiler->write(profileFile)) {
+			std::cerr << "couldn't write libclang profile to file: " << profileFile << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
 
-	clang_disposeTranslationUnit(tu);
-	clang_disposeIndex(index);
+	if (stats) {
+		stats->setBytesWritten((writers.empty() ? 0 : writers.front()->getBytesWritten()) + (shards ? shards->getBytesWritten() : 0));
+		if (!stats->write(statsFile)) {
+			std::cerr << "couldn't write stats to file: " << statsFile << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
 
 	return EXIT_SUCCESS;
 }
@@ -0,0 +1,217 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sys/stat.h>
+#include <vector>
+#include "merge.h"
+#include "index.h"
+#include "parser.h"
+#include "schema.h"
+#include "util.h"
+#include "writer.h"
+#include "json/json.h"
+
+namespace hyperloop {
+
+	static bool isDirectory (const std::string &path) {
+		struct stat st;
+		return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+	}
+
+	static bool readJSON (const std::string &path, Json::Value &json) {
+		std::ifstream in(path);
+		Json::CharReaderBuilder builder;
+		std::string errors;
+		return !in.fail() && Json::parseFromStream(builder, in, &json, &errors) && json.isObject();
+	}
+
+	/**
+	 * the metabases of the inputs in order, a directory stands for the
+	 * frameworks listed in its shards.json or in the index.json of an SDK
+	 * cache, in the order of their names
+	 */
+	static bool listInputs (const std::vector<std::string> &inputs, std::vector<std::string> &files) {
+		for (auto it = inputs.begin(); it != inputs.end(); it++) {
+			auto input = *it;
+			trim(input);
+			if (!isDirectory(input)) {
+				files.push_back(input);
+				continue;
+			}
+			Json::Value list;
+			if (!readJSON(input + "/shards.json", list) && !readJSON(input + "/index.json", list)) {
+				std::cerr << "no shards.json or index.json in directory: " << input << std::endl;
+				return false;
+			}
+			auto &frameworks = list["frameworks"];
+			for (auto fit = frameworks.begin(); fit != frameworks.end(); fit++) {
+				if (fit->isMember("status") && (*fit)["status"] != "ok") {
+					std::cerr << "skipping failed framework " << fit.name() << " of " << input << std::endl;
+					continue;
+				}
+				files.push_back(input + "/" + (*fit)["file"].asString());
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * append the names of from missing in to
+	 */
+	static void mergeNames (Json::Value &to, const Json::Value &from) {
+		std::set<std::string> names;
+		for (auto it = to.begin(); it != to.end(); it++) {
+			names.insert(it->asString());
+		}
+		for (auto it = from.begin(); it != from.end(); it++) {
+			if (names.insert(it->asString()).second) {
+				to.append(*it);
+			}
+		}
+	}
+
+	/**
+	 * merge a class or protocol into another of the same name, the same as
+	 * ClassDefinition::copy: methods and properties are added by name and
+	 * replace those of the same name, the superclass is only set if missing
+	 */
+	static void mergeClass (Json::Value &to, Json::Value &from) {
+		const char *members[] = { "methods", "properties" };
+		for (auto member : members) {
+			auto &values = from[member];
+			for (auto it = values.begin(); it != values.end(); it++) {
+				to[member][it.name()].swap(*it);
+			}
+		}
+		const char *lists[] = { "protocols", "categories" };
+		for (auto list : lists) {
+			if (from.isMember(list)) {
+				mergeNames(to[list], from[list]);
+			}
+		}
+		if (from.isMember("superclass") && !to.isMember("superclass")) {
+			to["superclass"] = from["superclass"];
+		}
+	}
+
+	/**
+	 * the blocks of a framework once per signature, in the order first seen
+	 */
+	static void mergeBlocks (Json::Value &to, Json::Value &from, std::set<std::string> &signatures) {
+		if (to.isNull()) {
+			to = Json::Value(Json::arrayValue);
+		}
+		for (auto it = from.begin(); it != from.end(); it++) {
+			if (signatures.insert((*it)["signature"].asString()).second) {
+				to.append(Json::Value());
+				to[to.size() - 1].swap(*it);
+			}
+		}
+	}
+
+	/**
+	 * move the definitions of input into result. The first definition of a
+	 * name is kept for sections other than classes and protocols, so the
+	 * result only depends on the order of the inputs
+	 */
+	static void mergeInto (Json::Value &result, Json::Value &input, Json::Value &extensions, std::map<std::string, std::set<std::string>> &signatures, size_t &conflicts) {
+		if (result["metadata"].isNull()) {
+			result["metadata"].swap(input["metadata"]);
+		}
+		auto sections = input.getMemberNames();
+		for (auto it = sections.begin(); it != sections.end(); it++) {
+			auto section = *it;
+			auto &from = input[section];
+			if (section == "metadata" || !from.isObject()) {
+				continue;
+			}
+			auto names = from.getMemberNames();
+			for (auto nit = names.begin(); nit != names.end(); nit++) {
+				auto &value = from[*nit];
+				if (section == "blocks") {
+					mergeBlocks(result[section][*nit], value, signatures[*nit]);
+				} else if (section == "extensions") {
+					mergeClass(extensions[*nit], value);
+				} else if (!result[section].isMember(*nit)) {
+					result[section][*nit].swap(value);
+				} else if (section == "classes" || section == "protocols") {
+					mergeClass(result[section][*nit], value);
+				} else if (result[section][*nit] != value) {
+					conflicts++;
+				}
+			}
+		}
+	}
+
+	int merge (std::map<std::string, std::string> &arguments) {
+		if (!arguments.count("-i") || !arguments.count("-o")) {
+			std::cerr << "merge requires the metabases to merge as -i and the output file as -o" << std::endl;
+			return EXIT_FAILURE;
+		}
+		auto schema = arguments.count("-schema") ? arguments["-schema"] : "1";
+		if (!ParserTree::isSupportedAPIVersion(schema)) {
+			std::cerr << "unsupported schema version: " << schema << std::endl;
+			return EXIT_FAILURE;
+		}
+		auto output = arguments["-o"];
+		std::vector<std::string> files;
+		if (!listInputs(tokenize(arguments["-i"], ","), files)) {
+			return EXIT_FAILURE;
+		}
+
+		// one input at a time, its definitions are moved into the result
+		Json::Value result(Json::objectValue);
+		Json::Value extensions(Json::objectValue);
+		std::map<std::string, std::set<std::string>> signatures;
+		size_t conflicts = 0;
+		for (auto it = files.begin(); it != files.end(); it++) {
+			Json::Value input;
+			if (!readJSON(*it, input)) {
+				std::cerr << "couldn't read metabase: " << *it << std::endl;
+				return EXIT_FAILURE;
+			}
+			expandSchema(input);
+			mergeInto(result, input, extensions, signatures, conflicts);
+		}
+		// extensions apply to their class wherever it came from, classes not in
+		// any of the inputs keep theirs as extensions
+		auto names = extensions.getMemberNames();
+		for (auto it = names.begin(); it != names.end(); it++) {
+			if (result["classes"].isMember(*it)) {
+				mergeClass(result["classes"][*it], extensions[*it]);
+			} else {
+				result["extensions"][*it].swap(extensions[*it]);
+			}
+		}
+		if (conflicts > 0) {
+			std::cerr << "kept the first of " << conflicts << " conflicting definitions" << std::endl;
+		}
+		result["metadata"]["api-version"] = schema;
+		if (schema != "1") {
+			compactSchema(result);
+		}
+
+		std::ofstream out(output);
+		if (out.fail()) {
+			std::cerr << "open failed for file: " << output << std::endl;
+			return EXIT_FAILURE;
+		}
+		MetabaseWriter writer(out, arguments.count("-pretty") > 0);
+		writer.write(result);
+		out << std::endl;
+		out.close();
+		if (out.fail()) {
+			std::cerr << "couldn't write file: " << output << std::endl;
+			return EXIT_FAILURE;
+		}
+		if (arguments.count("-index") && !MetabaseIndex::write(output, writer.getEntries())) {
+			std::cerr << "couldn't write index for file: " << output << std::endl;
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+}
@@ -0,0 +1,24 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_MERGE_H
+#define HYPERLOOP_MERGE_H
+
+#include <map>
+#include <string>
+
+namespace hyperloop {
+
+	/**
+	 * merge metabases, shards directories and SDK caches into one metabase.
+	 * Inputs are read one at a time and moved into the result, so no more
+	 * than the result and one input are held at once. Classes and protocols
+	 * of the same name are merged like ClassDefinition::copy, extensions are
+	 * merged into their class, and blocks are kept once per signature.
+	 * Returns the process exit code
+	 */
+	int merge (std::map<std::string, std::string> &arguments);
+}
+
+#endif
@@ -63,23 +63,23 @@ namespace hyperloop {
 		auto tree = this->context->getParserTree();
 		Json::Value kv;
 
-		kv["selector"] = this->getName();
-		kv["name"] = camelCase(this->getName());
-		kv["encoding"] = encoding;
-		kv["returns"] = returnType->toJSON();
-		kv["arguments"] = arguments.toJSON();
-		kv["instance"] = instance;
+		kv[keys::selector] = this->getName();
+		kv[keys::name] = camelCase(this->getName());
+		kv[keys::encoding] = encoding;
+		kv[keys::returns] = returnType->toJSON();
+		kv[keys::arguments] = arguments.toJSON();
+		kv[keys::instance] = instance;
 		if (optional) {
-			kv["optional"] = optional;
+			kv[keys::optional] = optional;
 		}
 		if (returnType->getType() == "typedef" && returnType->getValue() == "instancetype") {
-			kv["constructor"] = true;
+			kv[keys::constructor] = true;
 		}
 
-		resolveEncoding(tree, kv["returns"], "type", "value");
+		resolveEncoding(tree, kv[keys::returns], "type", "value");
 
-		for (auto c = 0; c < kv["arguments"].size(); c++) {
-			resolveEncoding(tree, kv["arguments"][c], "type", "value");
+		for (auto c = 0; c < kv[keys::arguments].size(); c++) {
+			resolveEncoding(tree, kv[keys::arguments][c], "type", "value");
 		}
 
 		return kv;
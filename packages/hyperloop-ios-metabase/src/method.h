@@ -13,11 +13,12 @@ namespace hyperloop {
 	/**
 	 * Method definition
 	 */
-	class MethodDefinition : public Definition {
+	class MethodDefinition : public Definition, private Counted<MethodDefinition> {
 	public:
 		MethodDefinition (CXCursor cursor, const std::string &name, ParserContext *ctx, bool instance, bool optional);
 		~MethodDefinition ();
 		Json::Value toJSON () const;
+		inline const char* getKind () const { return "method"; }
 		void addArgument(CXCursor argumentCursor);
 		void resolveReturnType();
 	private:
@@ -0,0 +1,122 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+#include "parallel.h"
+
+namespace hyperloop {
+
+	unsigned defaultThreads () {
+		auto cores = std::thread::hardware_concurrency();
+		return cores > 0 ? cores : 1;
+	}
+
+	/**
+	 * the indices a thread has left, [begin, end)
+	 */
+	struct Slice {
+		Slice () : begin(0), end(0) {}
+		std::mutex mutex;
+		size_t begin;
+		size_t end;
+	};
+
+	/**
+	 * take the next index of slice self, stealing from the fullest other
+	 * slice when it's empty. Only one slice is locked at a time.
+	 */
+	static bool nextIndex (std::vector<Slice> &slices, size_t self, size_t &index) {
+		auto &own = slices[self];
+		{
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (own.begin < own.end) {
+				index = own.begin++;
+				return true;
+			}
+		}
+		while (true) {
+			size_t victim = self, most = 0;
+			for (size_t i = 0; i < slices.size(); i++) {
+				if (i == self) {
+					continue;
+				}
+				std::lock_guard<std::mutex> lock(slices[i].mutex);
+				auto left = slices[i].end - slices[i].begin;
+				if (left > most) {
+					most = left;
+					victim = i;
+				}
+			}
+			if (most == 0) {
+				return false;
+			}
+			size_t begin, end;
+			{
+				std::lock_guard<std::mutex> lock(slices[victim].mutex);
+				auto left = slices[victim].end - slices[victim].begin;
+				if (left == 0) {
+					continue;
+				}
+				end = slices[victim].end;
+				begin = end - (left + 1) / 2;
+				slices[victim].end = begin;
+			}
+			std::lock_guard<std::mutex> lock(own.mutex);
+			own.begin = begin + 1;
+			own.end = end;
+			index = begin;
+			return true;
+		}
+	}
+
+	void parallelFor (size_t count, unsigned threads, const std::function<void(size_t)> &fn, size_t minimum) {
+		if (minimum > 0 && threads > count / minimum) {
+			threads = static_cast<unsigned>(count / minimum);
+		}
+		if (threads <= 1) {
+			for (size_t i = 0; i < count; i++) {
+				fn(i);
+			}
+			return;
+		}
+
+		std::vector<Slice> slices(threads);
+		for (size_t i = 0; i < threads; i++) {
+			slices[i].begin = count * i / threads;
+			slices[i].end = count * (i + 1) / threads;
+		}
+		std::atomic<bool> failed(false);
+		std::exception_ptr error;
+		std::mutex errorMutex;
+		auto work = [&](size_t self) {
+			size_t index;
+			while (!failed.load(std::memory_order_relaxed) && nextIndex(slices, self, index)) {
+				try {
+					fn(index);
+				} catch (...) {
+					std::lock_guard<std::mutex> lock(errorMutex);
+					if (!error) {
+						error = std::current_exception();
+					}
+					failed = true;
+				}
+			}
+		};
+
+		std::vector<std::thread> workers;
+		for (size_t i = 1; i < threads; i++) {
+			workers.emplace_back(work, i);
+		}
+		work(0);
+		for (auto it = workers.begin(); it != workers.end(); it++) {
+			it->join();
+		}
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
@@ -0,0 +1,71 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_PARALLEL_H
+#define HYPERLOOP_PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace hyperloop {
+
+	/**
+	 * threads to use by default, the number of cores
+	 */
+	unsigned defaultThreads ();
+
+	/**
+	 * call fn for every index below count on up to threads threads, returning
+	 * once all calls are done. Each thread starts on its own contiguous slice
+	 * of the indices and, when that runs out, steals the back half of the
+	 * largest slice left, so uneven work still keeps every thread busy. Fewer
+	 * than minimum indices per thread are run on the calling thread. The first
+	 * exception thrown by fn is rethrown after the other threads stop.
+	 */
+	void parallelFor (size_t count, unsigned threads, const std::function<void(size_t)> &fn, size_t minimum = 16);
+
+	/**
+	 * a memo table that can be shared by threads. Keys are spread over striped
+	 * locks and a value is computed while its stripe is locked, so every key
+	 * is computed once. compute must not use the same memo.
+	 */
+	template <typename K, typename V>
+	class ConcurrentMemo {
+		public:
+			template <typename F>
+			V get (const K &key, F compute) {
+				auto &stripe = stripes[(std::hash<K>()(key) >> 4) % StripeCount];
+				std::lock_guard<std::mutex> lock(stripe.mutex);
+				auto it = stripe.values.find(key);
+				if (it != stripe.values.end()) {
+					return it->second;
+				}
+				auto value = compute();
+				stripe.values.insert(std::make_pair(key, value));
+				return value;
+			}
+
+			/**
+			 * forget every value, not while another thread calls get
+			 */
+			void clear () {
+				for (auto &stripe : stripes) {
+					std::lock_guard<std::mutex> lock(stripe.mutex);
+					stripe.values.clear();
+				}
+			}
+
+		private:
+			static const size_t StripeCount = 32;
+			struct Stripe {
+				std::mutex mutex;
+				std::unordered_map<K, V> values;
+			};
+			Stripe stripes[StripeCount];
+	};
+}
+
+#endif
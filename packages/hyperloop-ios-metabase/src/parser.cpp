@@ -16,12 +16,20 @@
 #include "struct.h"
 #include "union.h"
 #include "block.h"
+#include "schema.h"
+#include "stats.h"
+#include "trace.h"
+#include "report.h"
+#include "diagnostics.h"
+#include "shards.h"
 
-#define APIVERSION "1"
+#define APIVERSION "2"
+#define APIVERSION_LEGACY "1"
 
 namespace hyperloop {
 
-	ParserTree::ParserTree () : context(nullptr) {
+	ParserTree::ParserTree () : context(nullptr), shared(false) {
+		target.Major = target.Minor = target.Subminor = -1;
 	}
 
 	ParserTree::~ParserTree () {
@@ -37,36 +45,43 @@ namespace hyperloop {
 	}
 
 	void ParserTree::addClass (hyperloop::ClassDefinition *definition) {
+		auto guard = lock();
 		auto key = definition->getName();
 		this->classes[key] = definition;
 	}
 
 	void ParserTree::addProtocol (hyperloop::ClassDefinition *definition) {
+		auto guard = lock();
 		auto key = definition->getName();
 		this->protocols[key] = definition;
 	}
 
 	void ParserTree::addType (TypeDefinition *definition) {
+		auto guard = lock();
 		auto key = definition->getName();
 		this->types[key] = definition;
 	}
 
 	void ParserTree::addEnum (EnumDefinition *definition) {
+		auto guard = lock();
 		auto key = definition->getName();
 		this->enums[key] = definition;
 	}
 
 	void ParserTree::addVar (VarDefinition *definition) {
+		auto guard = lock();
 		auto key = definition->getName();
 		this->vars[key] = definition;
 	}
 
 	void ParserTree::addFunction (FunctionDefinition *definition) {
+		auto guard = lock();
 		auto key = definition->getName();
 		this->functions[key] = definition;
 	}
 
 	void ParserTree::addStruct (StructDefinition *definition) {
+		auto guard = lock();
 		auto key = definition->getName();
 		key = ltrim(key, "_");
 		definition->setName(key);
@@ -74,6 +89,7 @@ namespace hyperloop {
 	}
 
 	void ParserTree::addUnion (UnionDefinition *definition) {
+		auto guard = lock();
 		auto key = definition->getName();
 		if (!key.empty()) {
 			this->unions[key] = definition;
@@ -81,9 +97,13 @@ namespace hyperloop {
 	}
 
 	void ParserTree::addBlock (BlockDefinition *definition) {
+		auto guard = lock();
 		auto key = definition->getSignature();
 		auto framework = definition->getFramework();
 		if (!framework.empty()) {
+			if (context && context->getStats()) {
+				context->getStats()->count("blocks");
+			}
 			auto frameworkBlocks = this->blocks[framework];
 			frameworkBlocks.insert(std::make_pair(key, definition));
 			this->blocks[framework] = frameworkBlocks;
@@ -91,153 +111,339 @@ namespace hyperloop {
 	}
 
 	ClassDefinition* ParserTree::getClass (const std::string &name) {
-		return this->classes[name];
+		auto guard = lock();
+		auto it = this->classes.find(name);
+		return it == this->classes.end() ? nullptr : it->second;
 	}
 
 	TypeDefinition* ParserTree::getType (const std::string &name) {
-		return this->types[name];
+		auto guard = lock();
+		auto it = this->types.find(name);
+		return it == this->types.end() ? nullptr : it->second;
 	}
 
 	StructDefinition* ParserTree::getStruct (const std::string &name) {
-		return this->structs[name];
+		auto guard = lock();
+		auto it = this->structs.find(name);
+		return it == this->structs.end() ? nullptr : it->second;
 	}
 
 	UnionDefinition* ParserTree::getUnion (const std::string &name) {
-		return this->unions[name];
+		auto guard = lock();
+		auto it = this->unions.find(name);
+		return it == this->unions.end() ? nullptr : it->second;
 	}
 
 	EnumDefinition* ParserTree::getEnum (const std::string &name) {
-		return this->enums[name];
+		auto guard = lock();
+		auto it = this->enums.find(name);
+		return it == this->enums.end() ? nullptr : it->second;
+	}
+
+	/**
+	 * true if map holds name and it is available at target, whatever its
+	 * availability before a target is set
+	 */
+	template <typename T>
+	static bool holdsAvailable (const std::map<std::string, T*> &map, const std::string &name, const CXVersion &target) {
+		if (name.empty() || map.empty()) { return false; }
+		auto it = map.find(name);
+		return it != map.end() && (target.Major < 0 || it->second->getAvailability().isAvailableIn(target));
 	}
 
 	bool ParserTree::hasClass (const std::string &name) {
-		if (name.empty() || this->classes.empty()) { return false; }
-		return (this->classes.find(name) != this->classes.end());
+		auto guard = lock();
+		return holdsAvailable(this->classes, name, target);
 	}
 
 	bool ParserTree::hasType (const std::string &name) {
-		if (name.empty() || this->types.empty()) { return false; }
-		return (this->types.find(name) != this->types.end());
+		auto guard = lock();
+		return holdsAvailable(this->types, name, target);
 	}
 
 	bool ParserTree::hasStruct (const std::string &name) {
-		if (name.empty() || this->structs.empty()) { return false; }
-		return (this->structs.find(name) != this->structs.end());
+		auto guard = lock();
+		return holdsAvailable(this->structs, name, target);
 	}
 
 	bool ParserTree::hasUnion (const std::string &name) {
-		if (name.empty() || this->unions.empty()) { return false; }
-		return (this->unions.find(name) != this->unions.end());
+		auto guard = lock();
+		return holdsAvailable(this->unions, name, target);
 	}
 
 	bool ParserTree::hasEnum (const std::string &name) {
-		if (name.empty() || this->enums.empty()) { return false; }
-		return (this->enums.find(name) != this->enums.end());
+		auto guard = lock();
+		return holdsAvailable(this->enums, name, target);
+	}
+
+	std::string ParserTree::getStructEncoding (StructDefinition *definition) {
+		return structEncodings.get(definition, [definition]() {
+			return structDefinitionToEncoding(definition);
+		});
+	}
+
+	std::pair<std::string, std::string> ParserTree::getTypedefEncoding (TypeDefinition *definition) {
+		return typedefEncodings.get(definition, [this, definition]() {
+			return typedefToEncoding(this, definition);
+		});
+	}
+
+	std::unique_lock<std::recursive_mutex> ParserTree::lock () {
+		return shared ? std::unique_lock<std::recursive_mutex>(mutex) : std::unique_lock<std::recursive_mutex>();
+	}
+
+	/**
+	 * true if map holds definition under its name
+	 */
+	template <typename T>
+	static bool holds (const std::map<std::string, T*> &map, Definition *definition) {
+		auto it = map.find(definition->getName());
+		return it != map.end() && it->second == definition;
+	}
+
+	const char* ParserTree::getSection (Definition *definition) {
+		auto guard = lock();
+		std::string kind(definition->getKind());
+		if (kind == "class") {
+			return holds(classes, definition) ? "classes" : holds(protocols, definition) ? "protocols" : nullptr;
+		} else if (kind == "typedef") {
+			return holds(types, definition) ? "typedefs" : nullptr;
+		} else if (kind == "enum") {
+			return holds(enums, definition) ? "enums" : nullptr;
+		} else if (kind == "var") {
+			return holds(vars, definition) ? "vars" : nullptr;
+		} else if (kind == "function") {
+			return holds(functions, definition) ? "functions" : nullptr;
+		} else if (kind == "struct") {
+			return holds(structs, definition) ? "structs" : nullptr;
+		} else if (kind == "union") {
+			return holds(unions, definition) ? "unions" : nullptr;
+		}
+		return nullptr;
+	}
+
+	bool ParserTree::isSupportedAPIVersion (const std::string &apiVersion) {
+		return apiVersion == APIVERSION || apiVersion == APIVERSION_LEGACY;
 	}
 
 	Json::Value ParserTree::toJSON() const {
+		return toJSON(APIVERSION_LEGACY);
+	}
 
+	/**
+	 * the definitions of map available in target, and declared in framework
+	 * unless it's empty, null if there are none. Definitions are resolved on
+	 * threads and added in the order of the map, so the result is the same
+	 * for any number of threads.
+	 */
+	template <typename T>
+	static Json::Value availableToJSON (const std::map<std::string, T*> &map, const CXVersion &target, unsigned threads, const std::string &framework) {
+		std::vector<std::pair<const std::string *, T *>> available;
+		for (auto it = map.begin(); it != map.end(); it++) {
+			if (!framework.empty() && it->second->getFramework() != framework) {
+				continue;
+			}
+			if (it->second->getAvailability().isAvailableIn(target)) {
+				available.push_back(std::make_pair(&it->first, it->second));
+			}
+		}
+		std::vector<Json::Value> values(available.size());
+		parallelFor(available.size(), threads, [&](size_t i) {
+			ResolveScope scope(available[i].second);
+			values[i] = available[i].second->toJSON();
+		});
 		Json::Value kv;
-		Json::Value metadata;
+		for (size_t i = 0; i < available.size(); i++) {
+			kv[*available[i].first].swap(values[i]);
+		}
+		return kv;
+	}
+
+	Json::Value ParserTree::toJSON(const std::string &apiVersion) const {
+		return toJSON(apiVersion, context->getMinVersion());
+	}
 
-		metadata["api-version"] = APIVERSION;
+	Json::Value ParserTree::metadataToJSON (const std::string &apiVersion, const std::string &minVersion) const {
+		Json::Value metadata;
+		metadata["api-version"] = apiVersion;
 		if (context->getSDKPath().find("iPhone") != std::string::npos) {
 			metadata["platform"] = "ios";
 		}
 		metadata["sdk-path"] = context->getSDKPath();
-		metadata["min-version"] = context->getMinVersion();
+		metadata["min-version"] = minVersion;
 		auto t = std::time(NULL);
 		char mbstr[100];
-		if (std::strftime(mbstr, sizeof(mbstr), "%FT%TZ", std::gmtime(&t))) {
+		// shards are written on several threads, so not the static std::gmtime
+		struct tm utc;
+		if (std::strftime(mbstr, sizeof(mbstr), "%FT%TZ", gmtime_r(&t, &utc))) {
 			metadata["generated"] = mbstr;
 		}
 		metadata["system-generated"] = context->excludeSystemAPIs() ? "false" : "true";
-		kv["metadata"] = metadata;
+		return metadata;
+	}
 
-		if (types.size() > 0) {
-			Json::Value typesKV;
-			for (auto it = types.begin(); it != types.end(); it++) {
-				typesKV[it->first] = it->second->toJSON();
-			}
+	static Json::Value blockToJSON (BlockDefinition *block) {
+		ResolveScope scope(block);
+		auto kv = block->toJSON();
+		kv["returns"] = generateBlockReturnJson(block);
+		return kv;
+	}
+
+	Json::Value ParserTree::blocksToJSON (const std::string &framework) {
+		auto guard = lock();
+		auto found = blocks.find(framework);
+		if (found == blocks.end()) {
+			return Json::Value();
+		}
+		Json::Value set;
+		for (auto it = found->second.begin(); it != found->second.end(); it++) {
+			set.append(blockToJSON(it->second));
+		}
+		return set;
+	}
+
+	Json::Value ParserTree::toJSON(const std::string &apiVersion, const std::string &minVersion) const {
+		return toJSON(apiVersion, minVersion, "");
+	}
+
+	Json::Value ParserTree::frameworkToJSON(const std::string &apiVersion, const std::string &minVersion, const std::string &framework) const {
+		return toJSON(apiVersion, minVersion, framework);
+	}
+
+	Json::Value ParserTree::toJSON(const std::string &apiVersion, const std::string &minVersion, const std::string &framework) const {
+
+		Json::Value kv;
+		kv["metadata"] = metadataToJSON(apiVersion, minVersion);
+
+		auto target = parseVersion(minVersion);
+		auto threads = context->getThreads();
+
+		// lookups while resolving see the tree as a parse at target would, and
+		// the encodings resolved for another version don't carry over
+		if (compareVersions(target, this->target) != 0) {
+			structEncodings.clear();
+			typedefEncodings.clear();
+			this->target = target;
+		}
+
+		// every definition resolves its types and encodings while serializing.
+		// Resolving rewrites the types of typedefs and of struct fields in place,
+		// so the sections are resolved one after another in this order and only
+		// the definitions within a section on several threads
+		auto stats = context->getStats();
+		auto trace = context->getTrace();
+		auto resolveStart = trace ? trace->now() : 0;
+		if (stats) {
+			stats->begin("resolve");
+		}
+
+		auto typesKV = availableToJSON(types, target, threads, framework);
+		if (!typesKV.isNull()) {
 			kv["typedefs"] = typesKV;
 		}
 
-		if (classes.size() > 0) {
-			Json::Value classesKV;
-			for (auto it = classes.begin(); it != classes.end(); it++) {
-				classesKV[it->first] = it->second->toJSON();
-			}
+		auto classesKV = availableToJSON(classes, target, threads, framework);
+		if (!classesKV.isNull()) {
 			kv["classes"] = classesKV;
 		}
 
-		if (protocols.size() > 0) {
-			Json::Value protocolsKV;
-			for (auto it = protocols.begin(); it != protocols.end(); it++) {
-				protocolsKV[it->first] = it->second->toJSON();
-			}
+		auto protocolsKV = availableToJSON(protocols, target, threads, framework);
+		if (!protocolsKV.isNull()) {
 			kv["protocols"] = protocolsKV;
 		}
 
-		if (enums.size() > 0) {
-			Json::Value enumsKV;
-			for (auto it = enums.begin(); it != enums.end(); it++) {
-				enumsKV[it->first] = it->second->toJSON();
-			}
+		auto enumsKV = availableToJSON(enums, target, threads, framework);
+		if (!enumsKV.isNull()) {
 			kv["enums"] = enumsKV;
 		}
 
-		if (vars.size() > 0) {
-			Json::Value varsKV;
-			for (auto it = vars.begin(); it != vars.end(); it++) {
-				varsKV[it->first] = it->second->toJSON();
-			}
+		auto varsKV = availableToJSON(vars, target, threads, framework);
+		if (!varsKV.isNull()) {
 			kv["vars"] = varsKV;
 		}
 
-		if (functions.size() > 0) {
-			Json::Value functionsKV;
-			for (auto it = functions.begin(); it != functions.end(); it++) {
-				functionsKV[it->first] = it->second->toJSON();
-			}
+		auto functionsKV = availableToJSON(functions, target, threads, framework);
+		if (!functionsKV.isNull()) {
 			kv["functions"] = functionsKV;
 		}
 
-		if (structs.size() > 0) {
-			Json::Value structsKV;
-			for (auto it = structs.begin(); it != structs.end(); it++) {
-				structsKV[it->first] = it->second->toJSON();
-			}
+		auto structsKV = availableToJSON(structs, target, threads, framework);
+		if (!structsKV.isNull()) {
 			kv["structs"] = structsKV;
 		}
 
-		if (unions.size() > 0) {
-			Json::Value unionsKV;
-			for (auto it = unions.begin(); it != unions.end(); it++) {
-				unionsKV[it->first] = it->second->toJSON();
-			}
+		auto unionsKV = availableToJSON(unions, target, threads, framework);
+		if (!unionsKV.isNull()) {
 			kv["unions"] = unionsKV;
 		}
 
+		if (!framework.empty()) {
+			Json::Value extensions;
+			for (auto it = classes.begin(); it != classes.end(); it++) {
+				if (it->second->getFramework() == framework || !it->second->getAvailability().isAvailableIn(target)) {
+					continue;
+				}
+				ResolveScope scope(it->second);
+				auto extension = it->second->extensionToJSON(framework);
+				if (!extension.isNull()) {
+					extensions[it->first].swap(extension);
+				}
+			}
+			if (!extensions.isNull()) {
+				kv["extensions"] = extensions;
+			}
+		}
+
 		if (blocks.size() > 0) {
+			std::vector<BlockDefinition *> all;
+			for (auto it = blocks.begin(); it != blocks.end(); it++) {
+				if (!framework.empty() && it->first != framework) {
+					continue;
+				}
+				for (auto iit = it->second.begin(); iit != it->second.end(); iit++) {
+					all.push_back(iit->second);
+				}
+			}
+			std::vector<Json::Value> values(all.size());
+			parallelFor(all.size(), threads, [&](size_t i) {
+				values[i] = blockToJSON(all[i]);
+			});
 			Json::Value blockSet;
+			size_t index = 0;
 			for (auto it = blocks.begin(); it != blocks.end(); it++) {
+				if (!framework.empty() && it->first != framework) {
+					continue;
+				}
 				auto key = it->first;
 				Json::Value set;
 				for (auto iit = it->second.begin(); iit != it->second.end(); iit++) {
-					BlockDefinition *block = iit->second;
-					Json::Value blockData = block->toJSON();
-					blockData["returns"] = generateBlockReturnJson(block);
-					set.append(blockData);
+					set.append(Json::Value());
+					set[set.size() - 1].swap(values[index++]);
 				}
 				blockSet[key] = set;
 			}
-			kv["blocks"] = blockSet;
+			if (!blockSet.isNull()) {
+				kv["blocks"] = blockSet;
+			}
+		}
+
+		if (stats) {
+			stats->end("resolve");
+		}
+		if (trace) {
+			trace->span("resolve", "phase", resolveStart, trace->now());
+		}
+
+		if (apiVersion != APIVERSION_LEGACY) {
+			StatsPhase compact(stats, "compact");
+			TraceSpan span(trace, "compact");
+			compactSchema(kv);
 		}
 
 		return kv;
 	}
 
-	ParserContext::ParserContext (const std::string &_sdkPath, const std::string &_minVersion, bool _excludeSys) : sdkPath(_sdkPath), minVersion(_minVersion), excludeSys(_excludeSys), previous(nullptr), current(nullptr) {
+	ParserContext::ParserContext (const std::string &_sdkPath, const std::string &_minVersion, bool _excludeSys) : sdkPath(_sdkPath), minVersion(_minVersion), minVersionNumber(parseVersion(_minVersion)), excludeSys(_excludeSys), previous(nullptr), current(nullptr), stats(nullptr), trace(nullptr), report(nullptr), diagnostics(nullptr), threads(1), shards(nullptr), anonymousEnums(0) {
 		this->tree.setContext(this);
 	}
 
@@ -247,10 +453,41 @@ namespace hyperloop {
 	}
 
 	void ParserContext::updateLocation (const std::map<std::string, std::string> &location) {
+		// a shard writer diagnoses at the current location from its own thread
+		std::unique_lock<std::mutex> lock(diagnosticsMutex, std::defer_lock);
+		if (shards) {
+			lock.lock();
+		}
 		this->filename = location.find("filename")->second;
 		this->line = location.find("line")->second;
 	}
 
+	/**
+	 * the definition serialized on this thread, resolving happens long after
+	 * the parse has moved on from its location
+	 */
+	static thread_local const Definition *resolving = nullptr;
+
+	ResolveScope::ResolveScope (const Definition *definition) : previous(resolving) {
+		resolving = definition;
+	}
+
+	ResolveScope::~ResolveScope () {
+		resolving = previous;
+	}
+
+	void ParserContext::diagnose (const std::string &kind, const std::string &message) {
+		if (diagnostics) {
+			// definitions are resolved on several threads
+			std::lock_guard<std::mutex> lock(diagnosticsMutex);
+			if (resolving) {
+				diagnostics->add(kind, message, resolving->getFileName(), resolving->getLine());
+			} else {
+				diagnostics->add(kind, message, filename, line);
+			}
+		}
+	}
+
 	void ParserContext::setCurrent (Definition *current) {
 		this->previous = this->current;
 		this->current = current;
@@ -272,11 +509,35 @@ namespace hyperloop {
 		return false;
 	}
 
+	/**
+	 * name of the definitions counted for a cursor kind
+	 */
+	static const char* definitionKind (CXCursorKind kind) {
+		switch (kind) {
+			case CXCursor_ObjCProtocolDecl: return "protocols";
+			case CXCursor_ObjCCategoryDecl: return "categories";
+			case CXCursor_ObjCInterfaceDecl: return "classes";
+			case CXCursor_TypedefDecl: return "typedefs";
+			case CXCursor_EnumDecl: return "enums";
+			case CXCursor_VarDecl: return "vars";
+			case CXCursor_FunctionDecl: return "functions";
+			case CXCursor_StructDecl: return "structs";
+			case CXCursor_UnionDecl: return "unions";
+			default: return "other";
+		}
+	}
+
 	/**
 	 * begin parsing the translation unit
 	 */
 	CXChildVisitResult begin(CXCursor cursor, CXCursor parent, CXClientData clientData) {
 
+		auto ctx = (ParserContext *)static_cast<ParserContext *>(clientData);
+		if (ctx->getStats()) {
+			ctx->getStats()->count("cursors");
+		}
+		HeaderTimer timer(ctx->getReport());
+
 		auto displayName = CXStringToString(clang_getCursorDisplayName(cursor));
 
 		if (clang_getCursorAvailability(cursor) != CXAvailability_Available) {
@@ -290,66 +551,41 @@ namespace hyperloop {
 			return CXChildVisit_Continue;
 		}
 
-		auto ctx = (ParserContext *)static_cast<ParserContext *>(clientData);
-
 		// get parser source information
 		std::map<std::string, std::string> location;
 		getSourceLocation(cursor, ctx, location);
 		ctx->updateLocation(location);
+		if (ctx->getTrace()) {
+			ctx->getTrace()->visit(location["filename"]);
+		}
+		timer.setFilename(location["filename"]);
+		if (ctx->getShards()) {
+			ctx->getShards()->visit(location["filename"]);
+		}
 
 		if (ctx->excludeSystemAPIs() && ctx->isSystemLocation(location["filename"])) {
 			return CXChildVisit_Continue;
 		}
 
-		CXPlatformAvailability availability[10];
-		int always_deprecated, always_unavailable;
-		CXString deprecated_message, unavailable_message;
-		CXVersion introducedIn;
-		introducedIn.Major = 0;
-		introducedIn.Minor = 0;
-		introducedIn.Subminor = 0;
-
-		int size = clang_getCursorPlatformAvailability(cursor,
-											&always_deprecated,
-											&deprecated_message,
-											&always_unavailable,
-											&unavailable_message,
-											(CXPlatformAvailability *)&availability, 10);
-
-		// check and make sure this API is available
-		if (size > 0) {
-			bool unavailable = false;
-			for (int c = 0; c < size; c++) {
-				auto platformAvailability = availability[c];
-				// We only care for ios, so skip this platform if it's anything else
-				auto platformNameCString = clang_getCString(platformAvailability.Platform);
-				std::string platformName = platformNameCString;
-				if (platformName.compare("ios") != 0) {
-					continue;
-				}
-
-				if (availability[c].Unavailable) {
-					unavailable = true;
-				}
+		// availability is kept in the model so every target can be written from
+		// this parse, only what isn't available in the lowest target is skipped
+		auto availability = getAvailability(cursor);
+		if (!availability.isAvailableIn(ctx->getMinVersionNumber())) {
+			return CXChildVisit_Continue;
+		}
 
-				introducedIn = platformAvailability.Introduced;
-				// Here we change -1 into 0. versions may be specified as simply 12, which becomes 12,-1,-1 here.
-				// So we change to 12.0.0
-				// There's also a number of all -1 cases, which we coerce to 0.0.0 now, not sure how to handle it...
-				if (introducedIn.Major == -1) {
-					introducedIn.Major = 0;
-				}
-				if (introducedIn.Minor == -1) {
-					introducedIn.Minor = 0;
-				}
-				if (introducedIn.Subminor == -1) {
-					introducedIn.Subminor = 0;
-				}
-			}
-			clang_disposeCXPlatformAvailability(availability);
-			if (unavailable || always_deprecated || always_unavailable) {
-				return CXChildVisit_Continue;
-			}
+		// Here we change -1 into 0. versions may be specified as simply 12, which becomes 12,-1,-1 here.
+		// So we change to 12.0.0
+		// There's also a number of all -1 cases, which we coerce to 0.0.0 now, not sure how to handle it...
+		CXVersion introducedIn = availability.introduced;
+		if (introducedIn.Major == -1) {
+			introducedIn.Major = 0;
+		}
+		if (introducedIn.Minor == -1) {
+			introducedIn.Minor = 0;
+		}
+		if (introducedIn.Subminor == -1) {
+			introducedIn.Subminor = 0;
 		}
 
 		// figure out the element and then delegate
@@ -396,9 +632,21 @@ namespace hyperloop {
 		}
 
 		if (definition) {
+			if (ctx->getStats()) {
+				ctx->getStats()->count(definitionKind(kind));
+			}
+			if (ctx->getReport()) {
+				ctx->getReport()->addDefinition(location["filename"]);
+			}
 			definition->setIntroducedIn(introducedIn);
+			definition->setAvailability(availability);
+			// a shard writer only reads the model between definitions
+			auto guard = ctx->getParserTree()->lock();
 			ctx->setCurrent(definition);
 			definition->parse(cursor, parent, ctx);
+			if (ctx->getShards()) {
+				ctx->getShards()->addDefinition(definition);
+			}
 		}
 
 		// std::cout << "EXIT AST: " << displayName << " kind: " << kind << ", location: " << location["filename"] << ":" << location["line"] << std::endl;
@@ -409,11 +657,38 @@ namespace hyperloop {
 	/**
 	 * parse the translation unit and output to outputFile
 	 */
-	ParserContext* parse (CXTranslationUnit tu, std::string &sdkPath, std::string &minVersion, bool excludeSys) {
+	ParserContext* parse (CXTranslationUnit tu, std::string &sdkPath, std::string &minVersion, bool excludeSys, Stats *stats, Trace *trace, HeaderReport *report, Diagnostics *diagnostics, ShardWriter *shards) {
 		auto cursor = clang_getTranslationUnitCursor(tu);
 		auto ctx = new ParserContext(sdkPath, minVersion, excludeSys);
-		clang_visitChildren(cursor, begin, ctx);
-		ClassDefinition::complete(ctx);
+		ctx->setStats(stats);
+		ctx->setTrace(trace);
+		ctx->setReport(report);
+		ctx->setDiagnostics(diagnostics);
+		if (report) {
+			report->addInclusions(tu);
+		}
+		if (shards) {
+			ctx->setShards(shards);
+			shards->addInclusions(tu);
+			shards->start(ctx);
+		}
+		{
+			StatsPhase traverse(stats, "traverse");
+			TraceSpan span(trace, "traverse");
+			clang_visitChildren(cursor, begin, ctx);
+			if (trace) {
+				trace->endVisits();
+			}
+		}
+		if (shards) {
+			// complete changes classes the serializer may be reading
+			shards->drain();
+		}
+		{
+			StatsPhase complete(stats, "complete");
+			TraceSpan span(trace, "ClassDefinition::complete");
+			ClassDefinition::complete(ctx);
+		}
 		return ctx;
 	}
 }
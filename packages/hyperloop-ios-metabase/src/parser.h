@@ -8,8 +8,12 @@
 #include <string>
 #include <map>
 #include <set>
+#include <mutex>
+#include <utility>
+#include <vector>
 #include "clang-c/Index.h"
 #include "def.h"
+#include "parallel.h"
 
 namespace hyperloop {
 
@@ -22,6 +26,11 @@ namespace hyperloop {
 	class StructDefinition;
 	class UnionDefinition;
 	class ParserContext;
+	class Stats;
+	class Trace;
+	class HeaderReport;
+	class Diagnostics;
+	class ShardWriter;
 
 	typedef std::map<std::string, ClassDefinition *> ClassMap;
 	typedef std::map<std::string, TypeDefinition *> TypeMap;
@@ -56,15 +65,69 @@ namespace hyperloop {
 			UnionDefinition* getUnion (const std::string &name);
 			EnumDefinition* getEnum (const std::string &name);
 
+			/**
+			 * while the tree is serialized for a version, definitions
+			 * unavailable in it are absent
+			 */
 			bool hasClass (const std::string &name);
 			bool hasType (const std::string &name);
 			bool hasStruct (const std::string &name);
 			bool hasUnion (const std::string &name);
 			bool hasEnum (const std::string &name);
 
+			/**
+			 * encoding of a struct and the type and encoding a typedef resolves
+			 * to, computed once and shared by the threads resolving the model
+			 */
+			std::string getStructEncoding (StructDefinition *definition);
+			std::pair<std::string, std::string> getTypedefEncoding (TypeDefinition *definition);
+
+			/**
+			 * section of the metabase definition is written to, nullptr if it
+			 * isn't in the tree, such as a category merged into its class
+			 */
+			const char* getSection (Definition *definition);
+
+			/**
+			 * the metadata of a metabase for minVersion, and the blocks of one
+			 * framework as written to the blocks section
+			 */
+			Json::Value metadataToJSON (const std::string &apiVersion, const std::string &minVersion) const;
+			Json::Value blocksToJSON (const std::string &framework);
+
+			/**
+			 * lock the tree on every access while a shard writer reads it from
+			 * another thread, the lock is recursive so it can be held around a
+			 * definition's toJSON
+			 */
+			inline void setShared (bool _shared) { shared = _shared; }
+			std::unique_lock<std::recursive_mutex> lock ();
+
 			void setContext (ParserContext *);
+			inline ParserContext* getContext() const { return context; }
 			virtual Json::Value toJSON() const;
 
+			/**
+			 * serialize using the schema of a specific api-version, "1" is the
+			 * legacy layout and "2" the compact layout with shared tables
+			 */
+			Json::Value toJSON(const std::string &apiVersion) const;
+
+			/**
+			 * serialize only the definitions available in minVersion, so one
+			 * parse can be written for several deployment targets
+			 */
+			Json::Value toJSON(const std::string &apiVersion, const std::string &minVersion) const;
+
+			/**
+			 * serialize only the definitions declared in framework, resolved
+			 * against the whole tree. Methods and properties its categories add
+			 * to classes of other frameworks are written to an extensions
+			 * section, keyed by the class they extend.
+			 */
+			Json::Value frameworkToJSON(const std::string &apiVersion, const std::string &minVersion, const std::string &framework) const;
+			static bool isSupportedAPIVersion (const std::string &apiVersion);
+
 		private:
 			ParserContext *context;
 			ClassMap classes;
@@ -76,6 +139,14 @@ namespace hyperloop {
 			Blocks blocks;
 			StructMap structs;
 			UnionMap unions;
+			mutable ConcurrentMemo<StructDefinition *, std::string> structEncodings;
+			mutable ConcurrentMemo<TypeDefinition *, std::pair<std::string, std::string>> typedefEncodings;
+			std::recursive_mutex mutex;
+			bool shared;
+			// the version serialized, set by toJSON. Major is -1 until then
+			mutable CXVersion target;
+
+			Json::Value toJSON(const std::string &apiVersion, const std::string &minVersion, const std::string &framework) const;
 	};
 
 	/**
@@ -88,6 +159,7 @@ namespace hyperloop {
 			void updateLocation (const std::map<std::string, std::string> &location);
 			inline const std::string& getSDKPath() const { return sdkPath; }
 			inline const std::string& getMinVersion() const { return minVersion; }
+			inline const CXVersion& getMinVersionNumber() const { return minVersionNumber; }
 			inline const bool excludeSystemAPIs() const { return excludeSys; }
 			inline const std::string& getCurrentFilename () const { return filename; }
 			inline const std::string& getCurrentLine () const { return line; }
@@ -96,21 +168,81 @@ namespace hyperloop {
 			inline Definition* getCurrent() { return current; }
 			inline Definition* getPrevious() { return previous; }
 			bool isSystemLocation (const std::string &location) const;
+			inline void setStats (Stats *_stats) { stats = _stats; }
+			inline Stats* getStats() const { return stats; }
+			inline void setTrace (Trace *_trace) { trace = _trace; }
+			inline Trace* getTrace() const { return trace; }
+			inline void setReport (HeaderReport *_report) { report = _report; }
+			inline HeaderReport* getReport() const { return report; }
+			inline void setDiagnostics (Diagnostics *_diagnostics) { diagnostics = _diagnostics; }
+			inline Diagnostics* getDiagnostics() const { return diagnostics; }
+
+			/**
+			 * threads resolving the model in toJSON, 1 by default
+			 */
+			inline void setThreads (unsigned _threads) { threads = _threads > 0 ? _threads : 1; }
+			inline unsigned getThreads() const { return threads; }
+			inline void setShards (ShardWriter *_shards) { shards = _shards; }
+			inline ShardWriter* getShards() const { return shards; }
+
+			/**
+			 * classes and categories by name waiting for their class, merged by
+			 * ClassDefinition::merge and complete. Kept here and not in globals
+			 * so that translation units can be parsed on several threads.
+			 */
+			inline std::map<std::string, std::vector<ClassDefinition *>>& getPendingClasses() { return pendingClasses; }
+
+			/**
+			 * number naming the next anonymous enum
+			 */
+			inline size_t nextAnonymousEnum() { return anonymousEnums++; }
+
+			/**
+			 * record a diagnostic at the location of the definition resolved on
+			 * this thread, else at the current location. Does nothing without
+			 * diagnostics
+			 */
+			void diagnose (const std::string &kind, const std::string &message);
 		private:
 			std::string sdkPath;
 			std::string minVersion;
+			CXVersion minVersionNumber;
 			bool excludeSys;
 			std::string filename;
 			std::string line;
 			ParserTree tree;
 			Definition* previous;
 			Definition* current;
+			Stats* stats;
+			Trace* trace;
+			HeaderReport* report;
+			Diagnostics* diagnostics;
+			std::mutex diagnosticsMutex;
+			unsigned threads;
+			ShardWriter* shards;
+			std::map<std::string, std::vector<ClassDefinition *>> pendingClasses;
+			size_t anonymousEnums;
+	};
+
+	/**
+	 * marks the definition serialized on this thread while the scope lives,
+	 * so diagnostics about resolving it are recorded at its location
+	 */
+	class ResolveScope {
+		public:
+			ResolveScope (const Definition *definition);
+			~ResolveScope ();
+		private:
+			const Definition *previous;
 	};
 
 	/**
-	 * parse the translation unit and return a ParserContext
+	 * parse the translation unit and return a ParserContext, timing the phases
+	 * and counting definitions into stats, recording spans into trace and the
+	 * cost of each header into report and warnings into diagnostics when given.
+	 * With shards, frameworks are written by it while the traversal goes on.
 	 */
-	ParserContext* parse (CXTranslationUnit tu, std::string &sdkPath,  std::string &minVersion, bool excludeSystemAPIs);
+	ParserContext* parse (CXTranslationUnit tu, std::string &sdkPath,  std::string &minVersion, bool excludeSystemAPIs, Stats *stats = nullptr, Trace *trace = nullptr, HeaderReport *report = nullptr, Diagnostics *diagnostics = nullptr, ShardWriter *shards = nullptr);
 }
 
 
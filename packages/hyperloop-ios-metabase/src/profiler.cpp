@@ -0,0 +1,143 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <algorithm>
+#include <fstream>
+#include "profiler.h"
+
+namespace hyperloop {
+
+	ClangProfiler *ClangProfiler::current = nullptr;
+
+	ClangProfiler::ClangProfiler () : site("parser") {
+	}
+
+	void ClangProfiler::setCurrent (ClangProfiler *profiler) {
+		current = profiler;
+	}
+
+	void ClangProfiler::exit (const char *function, unsigned long long nanos) {
+		auto nested = children.back();
+		children.pop_back();
+		if (!children.empty()) {
+			children.back() += nanos;
+		}
+		auto &cost = costs[std::make_pair(site, function)];
+		cost.calls++;
+		cost.time += nanos;
+		cost.self += nanos > nested ? nanos - nested : 0;
+	}
+
+	/**
+	 * one row of the profile
+	 */
+	struct ProfileRow {
+		ProfileRow () : calls(0), time(0), self(0) {}
+		std::string name;
+		unsigned long long calls;
+		unsigned long long time;
+		unsigned long long self;
+	};
+
+	static void addCost (ProfileRow &row, unsigned long long calls, unsigned long long time, unsigned long long self) {
+		row.calls += calls;
+		row.time += time;
+		row.self += self;
+	}
+
+	/**
+	 * inclusive time only means something per function, summed over a site
+	 * it would count nested calls twice
+	 */
+	static Json::Value rowToJSON (const ProfileRow &row, bool inclusive) {
+		Json::Value kv;
+		kv["name"] = row.name;
+		kv["calls"] = static_cast<Json::UInt64>(row.calls);
+		if (inclusive) {
+			kv["time"] = row.time / 1000000.0;
+		}
+		kv["self"] = row.self / 1000000.0;
+		return kv;
+	}
+
+	/**
+	 * rows of a map sorted by exclusive time, most expensive first
+	 */
+	static std::vector<ProfileRow> sortRows (const std::map<std::string, ProfileRow> &rows) {
+		std::vector<ProfileRow> list;
+		for (auto it = rows.begin(); it != rows.end(); it++) {
+			list.push_back(it->second);
+			list.back().name = it->first;
+		}
+		std::stable_sort(list.begin(), list.end(), [](const ProfileRow &a, const ProfileRow &b) {
+			return a.self > b.self;
+		});
+		return list;
+	}
+
+	Json::Value ClangProfiler::toJSON () const {
+		std::map<std::string, ProfileRow> functions, sites;
+		std::map<std::string, std::map<std::string, ProfileRow>> siteFunctions;
+		ProfileRow total;
+		for (auto it = costs.begin(); it != costs.end(); it++) {
+			auto &cost = it->second;
+			addCost(functions[it->first.second], cost.calls, cost.time, cost.self);
+			addCost(sites[it->first.first], cost.calls, cost.time, cost.self);
+			addCost(siteFunctions[it->first.first][it->first.second], cost.calls, cost.time, cost.self);
+			addCost(total, cost.calls, 0, cost.self);
+		}
+
+		Json::Value kv;
+		Json::Value totals;
+		totals["calls"] = static_cast<Json::UInt64>(total.calls);
+		totals["self"] = total.self / 1000000.0;
+		kv["total"] = totals;
+		Json::Value functionsKV(Json::arrayValue);
+		auto functionRows = sortRows(functions);
+		for (auto it = functionRows.begin(); it != functionRows.end(); it++) {
+			functionsKV.append(rowToJSON(*it, true));
+		}
+		kv["functions"] = functionsKV;
+		Json::Value sitesKV(Json::arrayValue);
+		auto siteRows = sortRows(sites);
+		for (auto it = siteRows.begin(); it != siteRows.end(); it++) {
+			auto site = rowToJSON(*it, false);
+			Json::Value calls(Json::arrayValue);
+			auto rows = sortRows(siteFunctions[it->name]);
+			for (auto row = rows.begin(); row != rows.end(); row++) {
+				calls.append(rowToJSON(*row, true));
+			}
+			site["functions"] = calls;
+			sitesKV.append(site);
+		}
+		kv["sites"] = sitesKV;
+		return kv;
+	}
+
+	bool ClangProfiler::write (const std::string &file) const {
+		std::ofstream out(file, std::ios::out | std::ios::trunc);
+		if (out.fail()) {
+			return false;
+		}
+		Json::StreamWriterBuilder builder;
+		builder.settings_["commentStyle"] = "None";
+		builder.settings_["indentation"] = "\t";
+		out << Json::writeString(builder, toJSON()) << std::endl;
+		out.close();
+		return !out.fail();
+	}
+
+	ClangSite::ClangSite (const char *site) : profiler(ClangProfiler::getCurrent()), previous(nullptr) {
+		if (profiler) {
+			previous = profiler->getSite();
+			profiler->setSite(site);
+		}
+	}
+
+	ClangSite::~ClangSite () {
+		if (profiler) {
+			profiler->setSite(previous);
+		}
+	}
+}
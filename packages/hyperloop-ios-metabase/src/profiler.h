@@ -0,0 +1,187 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_PROFILER_H
+#define HYPERLOOP_PROFILER_H
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "clang-c/Index.h"
+#include "json/json.h"
+
+namespace hyperloop {
+
+	/**
+	 * Counts and times every libclang call made by the generator, written as
+	 * JSON with -profile-clang. Calls are attributed to the function and to
+	 * the site they were made from, the kind of definition being parsed.
+	 * Time is reported both inclusive and exclusive of nested calls, since
+	 * clang_visitChildren runs the generator's visitors. The exclusive time
+	 * of clang_visitChildren includes the visitors' own code.
+	 *
+	 * The libclang functions used are wrapped by the macros at the end of
+	 * this file, which cost a pointer check when no profiler is installed.
+	 */
+	class ClangProfiler {
+		public:
+			ClangProfiler ();
+
+			/**
+			 * the profiler calls are recorded in, nullptr when not profiling
+			 */
+			static inline ClangProfiler* getCurrent () { return current; }
+			static void setCurrent (ClangProfiler *profiler);
+
+			inline const char* getSite () const { return site; }
+			inline void setSite (const char *_site) { site = _site; }
+
+			/**
+			 * start and finish a call to function, nanos is its inclusive time
+			 */
+			inline void enter () { children.push_back(0); }
+			void exit (const char *function, unsigned long long nanos);
+
+			/**
+			 * functions and sites sorted by exclusive time, times in milliseconds
+			 */
+			Json::Value toJSON () const;
+
+			/**
+			 * write the profile to file, returns false if it can't be written
+			 */
+			bool write (const std::string &file) const;
+
+		private:
+			struct Cost {
+				Cost () : calls(0), time(0), self(0) {}
+				unsigned long long calls;
+				unsigned long long time;
+				unsigned long long self;
+			};
+
+			static ClangProfiler *current;
+			const char *site;
+			std::vector<unsigned long long> children;
+			// keyed by the literals themselves, merged by name in toJSON
+			std::map<std::pair<const char *, const char *>, Cost> costs;
+	};
+
+	/**
+	 * sets the site of the current profiler for the lifetime of the object
+	 */
+	class ClangSite {
+		public:
+			ClangSite (const char *site);
+			~ClangSite ();
+		private:
+			ClangProfiler *profiler;
+			const char *previous;
+	};
+
+	/**
+	 * a libclang function called through the current profiler
+	 */
+	template <typename R, typename... P>
+	class ClangCall {
+		public:
+			ClangCall (const char *_name, R (*_function)(P...)) : name(_name), function(_function) {}
+
+			template <typename... A>
+			R operator() (A&&... args) const {
+				auto profiler = ClangProfiler::getCurrent();
+				if (!profiler) {
+					return function(std::forward<A>(args)...);
+				}
+				Timer timer(profiler, name);
+				return function(std::forward<A>(args)...);
+			}
+
+		private:
+			class Timer {
+				public:
+					Timer (ClangProfiler *_profiler, const char *_name) : profiler(_profiler), name(_name), start(std::chrono::steady_clock::now()) {
+						profiler->enter();
+					}
+					~Timer () {
+						auto elapsed = std::chrono::steady_clock::now() - start;
+						profiler->exit(name, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+					}
+				private:
+					ClangProfiler *profiler;
+					const char *name;
+					std::chrono::steady_clock::time_point start;
+			};
+
+			const char *name;
+			R (*function)(P...);
+	};
+
+	template <typename R, typename... P>
+	inline ClangCall<R, P...> clangCall (const char *name, R (*function)(P...)) {
+		return ClangCall<R, P...>(name, function);
+	}
+}
+
+#define HYPERLOOP_CLANG_CALL(function) hyperloop::clangCall(#function, &::function)
+
+#define clang_createIndex(...) HYPERLOOP_CLANG_CALL(clang_createIndex)(__VA_ARGS__)
+#define clang_disposeIndex(...) HYPERLOOP_CLANG_CALL(clang_disposeIndex)(__VA_ARGS__)
+#define clang_parseTranslationUnit(...) HYPERLOOP_CLANG_CALL(clang_parseTranslationUnit)(__VA_ARGS__)
+#define clang_reparseTranslationUnit(...) HYPERLOOP_CLANG_CALL(clang_reparseTranslationUnit)(__VA_ARGS__)
+#define clang_defaultReparseOptions(...) HYPERLOOP_CLANG_CALL(clang_defaultReparseOptions)(__VA_ARGS__)
+#define clang_createTranslationUnit2(...) HYPERLOOP_CLANG_CALL(clang_createTranslationUnit2)(__VA_ARGS__)
+#define clang_saveTranslationUnit(...) HYPERLOOP_CLANG_CALL(clang_saveTranslationUnit)(__VA_ARGS__)
+#define clang_defaultSaveOptions(...) HYPERLOOP_CLANG_CALL(clang_defaultSaveOptions)(__VA_ARGS__)
+#define clang_getClangVersion(...) HYPERLOOP_CLANG_CALL(clang_getClangVersion)(__VA_ARGS__)
+#define clang_disposeTranslationUnit(...) HYPERLOOP_CLANG_CALL(clang_disposeTranslationUnit)(__VA_ARGS__)
+#define clang_getTranslationUnitCursor(...) HYPERLOOP_CLANG_CALL(clang_getTranslationUnitCursor)(__VA_ARGS__)
+#define clang_getInclusions(...) HYPERLOOP_CLANG_CALL(clang_getInclusions)(__VA_ARGS__)
+#define clang_visitChildren(...) HYPERLOOP_CLANG_CALL(clang_visitChildren)(__VA_ARGS__)
+#define clang_getCString(...) HYPERLOOP_CLANG_CALL(clang_getCString)(__VA_ARGS__)
+#define clang_disposeString(...) HYPERLOOP_CLANG_CALL(clang_disposeString)(__VA_ARGS__)
+#define clang_getFileName(...) HYPERLOOP_CLANG_CALL(clang_getFileName)(__VA_ARGS__)
+#define clang_getFileLocation(...) HYPERLOOP_CLANG_CALL(clang_getFileLocation)(__VA_ARGS__)
+#define clang_equalCursors(...) HYPERLOOP_CLANG_CALL(clang_equalCursors)(__VA_ARGS__)
+#define clang_isUnexposed(...) HYPERLOOP_CLANG_CALL(clang_isUnexposed)(__VA_ARGS__)
+#define clang_getCursorKind(...) HYPERLOOP_CLANG_CALL(clang_getCursorKind)(__VA_ARGS__)
+#define clang_getCursorKindSpelling(...) HYPERLOOP_CLANG_CALL(clang_getCursorKindSpelling)(__VA_ARGS__)
+#define clang_getCursorDisplayName(...) HYPERLOOP_CLANG_CALL(clang_getCursorDisplayName)(__VA_ARGS__)
+#define clang_getCursorSpelling(...) HYPERLOOP_CLANG_CALL(clang_getCursorSpelling)(__VA_ARGS__)
+#define clang_getCursorLocation(...) HYPERLOOP_CLANG_CALL(clang_getCursorLocation)(__VA_ARGS__)
+#define clang_getCursorDefinition(...) HYPERLOOP_CLANG_CALL(clang_getCursorDefinition)(__VA_ARGS__)
+#define clang_getCursorAvailability(...) HYPERLOOP_CLANG_CALL(clang_getCursorAvailability)(__VA_ARGS__)
+#define clang_getCursorPlatformAvailability(...) HYPERLOOP_CLANG_CALL(clang_getCursorPlatformAvailability)(__VA_ARGS__)
+#define clang_disposeCXPlatformAvailability(...) HYPERLOOP_CLANG_CALL(clang_disposeCXPlatformAvailability)(__VA_ARGS__)
+#define clang_getCursorType(...) HYPERLOOP_CLANG_CALL(clang_getCursorType)(__VA_ARGS__)
+#define clang_getCursorResultType(...) HYPERLOOP_CLANG_CALL(clang_getCursorResultType)(__VA_ARGS__)
+#define clang_getTypeSpelling(...) HYPERLOOP_CLANG_CALL(clang_getTypeSpelling)(__VA_ARGS__)
+#define clang_getCanonicalType(...) HYPERLOOP_CLANG_CALL(clang_getCanonicalType)(__VA_ARGS__)
+#define clang_getTypedefDeclUnderlyingType(...) HYPERLOOP_CLANG_CALL(clang_getTypedefDeclUnderlyingType)(__VA_ARGS__)
+#define clang_getEnumConstantDeclValue(...) HYPERLOOP_CLANG_CALL(clang_getEnumConstantDeclValue)(__VA_ARGS__)
+#define clang_getDeclObjCTypeEncoding(...) HYPERLOOP_CLANG_CALL(clang_getDeclObjCTypeEncoding)(__VA_ARGS__)
+#define clang_isFunctionTypeVariadic(...) HYPERLOOP_CLANG_CALL(clang_isFunctionTypeVariadic)(__VA_ARGS__)
+#define clang_Type_getNamedType(...) HYPERLOOP_CLANG_CALL(clang_Type_getNamedType)(__VA_ARGS__)
+#define clang_Type_getObjCEncoding(...) HYPERLOOP_CLANG_CALL(clang_Type_getObjCEncoding)(__VA_ARGS__)
+#define clang_Type_getSizeOf(...) HYPERLOOP_CLANG_CALL(clang_Type_getSizeOf)(__VA_ARGS__)
+#define clang_Type_getAlignOf(...) HYPERLOOP_CLANG_CALL(clang_Type_getAlignOf)(__VA_ARGS__)
+#define clang_Type_getOffsetOf(...) HYPERLOOP_CLANG_CALL(clang_Type_getOffsetOf)(__VA_ARGS__)
+#define clang_Type_visitFields(...) HYPERLOOP_CLANG_CALL(clang_Type_visitFields)(__VA_ARGS__)
+#define clang_Cursor_getOffsetOfField(...) HYPERLOOP_CLANG_CALL(clang_Cursor_getOffsetOfField)(__VA_ARGS__)
+#define clang_Cursor_isBitField(...) HYPERLOOP_CLANG_CALL(clang_Cursor_isBitField)(__VA_ARGS__)
+#define clang_Cursor_isAnonymous(...) HYPERLOOP_CLANG_CALL(clang_Cursor_isAnonymous)(__VA_ARGS__)
+#define clang_getFieldDeclBitWidth(...) HYPERLOOP_CLANG_CALL(clang_getFieldDeclBitWidth)(__VA_ARGS__)
+#define clang_Cursor_isObjCOptional(...) HYPERLOOP_CLANG_CALL(clang_Cursor_isObjCOptional)(__VA_ARGS__)
+#define clang_Cursor_getObjCPropertyAttributes(...) HYPERLOOP_CLANG_CALL(clang_Cursor_getObjCPropertyAttributes)(__VA_ARGS__)
+#define clang_getNumDiagnostics(...) HYPERLOOP_CLANG_CALL(clang_getNumDiagnostics)(__VA_ARGS__)
+#define clang_getDiagnostic(...) HYPERLOOP_CLANG_CALL(clang_getDiagnostic)(__VA_ARGS__)
+#define clang_getDiagnosticSeverity(...) HYPERLOOP_CLANG_CALL(clang_getDiagnosticSeverity)(__VA_ARGS__)
+#define clang_getDiagnosticSpelling(...) HYPERLOOP_CLANG_CALL(clang_getDiagnosticSpelling)(__VA_ARGS__)
+#define clang_getDiagnosticLocation(...) HYPERLOOP_CLANG_CALL(clang_getDiagnosticLocation)(__VA_ARGS__)
+#define clang_disposeDiagnostic(...) HYPERLOOP_CLANG_CALL(clang_disposeDiagnostic)(__VA_ARGS__)
+
+#endif
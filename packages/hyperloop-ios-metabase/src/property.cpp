@@ -29,16 +29,16 @@ namespace hyperloop {
 
 	Json::Value Property::toJSON() const {
 		Json::Value kv;
-		kv["type"] = type->toJSON();
-		kv["name"] = name;
+		kv[keys::type] = type->toJSON();
+		kv[keys::name] = name;
 		if (!attributes.empty()) {
 			Json::Value attrs;
 			for (auto it = attributes.begin(); it != attributes.end(); it++) {
 				attrs.append(*it);
 			}
-			kv["attributes"] = attrs;
+			kv[keys::attributes] = attrs;
 		}
-		kv["optional"] = optional;
+		kv[keys::optional] = optional;
 		return kv;
 	}
 
@@ -10,11 +10,12 @@
 
 namespace hyperloop {
 
-	class Property : public Definition {
+	class Property : public Definition, private Counted<Property> {
 		public:
 			Property(CXCursor cursor, const std::string &name, ParserContext *context);
 			~Property();
 			Json::Value toJSON () const;
+			inline const char* getKind () const { return "property"; }
 		private:
 			Type *type;
 			std::vector<std::string> attributes;
@@ -0,0 +1,227 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <iostream>
+#include <set>
+#include "query.h"
+#include "index.h"
+#include "schema.h"
+#include "util.h"
+
+namespace hyperloop {
+
+	/**
+	 * sections that are keyed by symbol name
+	 */
+	static const char *symbolSections[] = {
+		"classes", "protocols", "typedefs", "enums", "vars", "functions", "structs", "unions"
+	};
+
+	/**
+	 * reads definitions through the index of a metabase, expanded into the
+	 * legacy layout when the metabase is written in the compact one
+	 */
+	class Definitions {
+		public:
+			Definitions (const MetabaseIndex &_index) : index(_index) {}
+
+			/**
+			 * read the files, frameworks and types tables of a compact metabase,
+			 * returns false if it is compact and they can't be read
+			 */
+			bool load () {
+				Json::Value version;
+				if (!index.read("metadata", "api-version", version) || version.asString() != "2") {
+					return true;
+				}
+				const char *names[] = { "files", "frameworks", "types" };
+				for (auto name : names) {
+					if (!index.read(name, "", tables[name])) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			bool read (const std::string &section, const std::string &name, Json::Value &fragment) const {
+				if (!index.read(section, name, fragment)) {
+					return false;
+				}
+				if (tables.isNull() || section == "metadata") {
+					return true;
+				}
+				if (fragment.isArray()) {
+					// blocks are grouped by framework
+					for (auto it = fragment.begin(); it != fragment.end(); it++) {
+						expandDefinition(tables, *it);
+					}
+				} else if (fragment.isObject()) {
+					expandDefinition(tables, fragment);
+				}
+				return true;
+			}
+
+		private:
+			const MetabaseIndex &index;
+			Json::Value tables;
+	};
+
+	/**
+	 * merge the members of an inherited section (methods or properties) that the
+	 * subclass doesn't already define, marking where they came from
+	 */
+	static void mergeInherited (Json::Value &into, const Json::Value &from, const std::string &key, const std::string &superclass) {
+		if (!from.isMember(key)) {
+			return;
+		}
+		auto &members = from[key];
+		for (auto it = members.begin(); it != members.end(); it++) {
+			auto name = it.name();
+			if (!into[key].isMember(name)) {
+				Json::Value member = *it;
+				member["inheritedFrom"] = superclass;
+				into[key][name] = member;
+			}
+		}
+	}
+
+	/**
+	 * class X with its superclass chain and inherited methods and properties
+	 */
+	static bool queryClass (const Definitions &metabase, const std::string &name, Json::Value &result) {
+		if (!metabase.read("classes", name, result)) {
+			// protocols have no superclass chain but are looked up the same way
+			return metabase.read("protocols", name, result);
+		}
+		Json::Value superclasses(Json::arrayValue);
+		std::set<std::string> visited;
+		visited.insert(name);
+		auto superclass = result.get("superclass", "").asString();
+		while (!superclass.empty() && visited.find(superclass) == visited.end()) {
+			visited.insert(superclass);
+			superclasses.append(superclass);
+			Json::Value parent;
+			if (!metabase.read("classes", superclass, parent)) {
+				// not part of this metabase, i.e. generated with system APIs excluded
+				break;
+			}
+			mergeInherited(result, parent, "methods", superclass);
+			mergeInherited(result, parent, "properties", superclass);
+			superclass = parent.get("superclass", "").asString();
+		}
+		result["superclasses"] = superclasses;
+		return true;
+	}
+
+	/**
+	 * every section and framework that defines a symbol named Y
+	 */
+	static bool querySymbol (const Definitions &metabase, const std::string &name, Json::Value &result) {
+		Json::Value definitions(Json::arrayValue);
+		for (auto section : symbolSections) {
+			Json::Value fragment;
+			if (metabase.read(section, name, fragment)) {
+				Json::Value definition;
+				definition["section"] = section;
+				definition["framework"] = fragment.get("framework", "");
+				definition["filename"] = fragment.get("filename", "");
+				definition["line"] = fragment.get("line", "");
+				definitions.append(definition);
+			}
+		}
+		result["name"] = name;
+		result["definitions"] = definitions;
+		return definitions.size() > 0;
+	}
+
+	/**
+	 * encoding and fields of struct Z, following typedefs to the struct
+	 */
+	static bool queryStruct (const Definitions &metabase, const std::string &name, Json::Value &result) {
+		Json::Value typedefFragment, structFragment;
+		std::string structName = name;
+		std::string encoding;
+		std::set<std::string> visited;
+		// typedef chains end at the struct, e.g. CGRect -> struct CGRect
+		while (!metabase.read("structs", structName, structFragment) && visited.find(structName) == visited.end()) {
+			visited.insert(structName);
+			if (!metabase.read("typedefs", structName, typedefFragment)) {
+				return false;
+			}
+			if (encoding.empty()) {
+				encoding = typedefFragment.get("encoding", "").asString();
+			}
+			auto value = typedefFragment.get("value", "").asString();
+			value = replace(value, "struct ", "");
+			structName = ltrim(trim(value), "_");
+			if (structName.empty()) {
+				return false;
+			}
+		}
+		if (structFragment.isNull()) {
+			return false;
+		}
+		if (encoding.empty() || encoding == "?") {
+			// build it the same way the generator does for struct members
+			encoding = "{" + structName + "=";
+			auto &fields = structFragment["fields"];
+			for (auto it = fields.begin(); it != fields.end(); it++) {
+				encoding += (*it).get("encoding", "").asString();
+			}
+			encoding += "}";
+		}
+		result["name"] = name;
+		result["struct"] = structName;
+		result["encoding"] = encoding;
+		result["fields"] = structFragment.isMember("fields") ? structFragment["fields"] : Json::Value(Json::arrayValue);
+		return true;
+	}
+
+	int query (std::map<std::string, std::string> &arguments) {
+		if (!arguments.count("-m")) {
+			std::cerr << "query requires the metabase to search, use -m <metabase.json>" << std::endl;
+			return EXIT_FAILURE;
+		}
+		MetabaseIndex index(arguments["-m"]);
+		Definitions metabase(index);
+		if (!index.load() || !metabase.load()) {
+			std::cerr << "couldn't read metabase: " << arguments["-m"] << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		Json::Value result;
+		std::string name;
+		bool found = false;
+		if (arguments.count("-class")) {
+			name = arguments["-class"];
+			found = queryClass(metabase, name, result);
+		} else if (arguments.count("-symbol")) {
+			name = arguments["-symbol"];
+			found = querySymbol(metabase, name, result);
+		} else if (arguments.count("-struct")) {
+			name = arguments["-struct"];
+			found = queryStruct(metabase, name, result);
+		} else if (arguments.count("-section") && arguments.count("-name")) {
+			name = arguments["-name"];
+			found = metabase.read(arguments["-section"], name, result);
+		} else {
+			std::cerr << "query needs one of -class, -symbol, -struct or -section with -name" << std::endl;
+			return EXIT_FAILURE;
+		}
+		if (!found) {
+			std::cerr << "not found in metabase: " << name << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		Json::StreamWriterBuilder builder;
+		if (arguments.count("-pretty") > 0) {
+			builder.settings_["commentStyle"] = "None";
+			builder.settings_["indentation"] = "\t";
+		} else {
+			builder.settings_["indentation"] = "";
+		}
+		std::cout << Json::writeString(builder, result) << std::endl;
+		return EXIT_SUCCESS;
+	}
+}
@@ -0,0 +1,20 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_QUERY_H
+#define HYPERLOOP_QUERY_H
+
+#include <map>
+#include <string>
+
+namespace hyperloop {
+
+	/**
+	 * answer a symbol lookup against an existing metabase and print the result
+	 * as JSON to stdout. returns the process exit code
+	 */
+	int query (std::map<std::string, std::string> &arguments);
+}
+
+#endif
@@ -0,0 +1,216 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <algorithm>
+#include <fstream>
+#include "report.h"
+#include "util.h"
+
+namespace hyperloop {
+
+	/**
+	 * remember the import in the main file each included file came through
+	 */
+	static void visitInclusion (CXFile file, CXSourceLocation *stack, unsigned depth, CXClientData clientData) {
+		auto imports = static_cast<std::map<std::string, std::string> *>(clientData);
+		auto filename = CXStringToString(clang_getFileName(file));
+		if (depth < 2) {
+			// the main file itself or one of its own imports
+			imports->insert(std::make_pair(filename, filename));
+			return;
+		}
+		// the last entry of the stack is the import in the main file, the one
+		// before it sits in the header that import brought in
+		CXFile imported;
+		unsigned line, column, offset;
+		clang_getFileLocation(stack[depth - 2], &imported, &line, &column, &offset);
+		imports->insert(std::make_pair(filename, CXStringToString(clang_getFileName(imported))));
+	}
+
+	HeaderReport::HeaderReport () {
+	}
+
+	bool HeaderReport::isSupportedSortKey (const std::string &sortKey) {
+		return sortKey == "time" || sortKey == "bytes" || sortKey == "definitions";
+	}
+
+	void HeaderReport::addInclusions (CXTranslationUnit tu) {
+		clang_getInclusions(tu, visitInclusion, &imports);
+	}
+
+	void HeaderReport::addTime (const std::string &filename, unsigned long long nanos) {
+		headers[filename].time += nanos;
+	}
+
+	void HeaderReport::addDefinition (const std::string &filename) {
+		headers[filename].definitions++;
+	}
+
+	/**
+	 * filename of a definition in either schema, the compact one refers to
+	 * the shared files table instead
+	 */
+	static std::string filenameOf (const Json::Value &root, const Json::Value &definition) {
+		if (definition.isMember("filename")) {
+			return definition["filename"].asString();
+		}
+		if (definition.isMember("file") && root.isMember("files")) {
+			return root["files"][definition["file"].asUInt()].get("filename", "").asString();
+		}
+		return "";
+	}
+
+	void HeaderReport::addBytes (const Json::Value &root, const std::vector<IndexEntry> &entries) {
+		Json::StreamWriterBuilder builder;
+		builder.settings_["indentation"] = "";
+		for (auto it = entries.begin(); it != entries.end(); it++) {
+			if (!root.isMember(it->section) || !root[it->section].isObject() || !root[it->section].isMember(it->name)) {
+				continue;
+			}
+			auto &value = root[it->section][it->name];
+			if (value.isObject()) {
+				auto filename = filenameOf(root, value);
+				if (!filename.empty()) {
+					headers[filename].bytes += it->length;
+				}
+			} else if (value.isArray() && value.size() > 0) {
+				// blocks are grouped per framework, split their bytes by the size of each block
+				std::vector<size_t> sizes;
+				size_t total = 0;
+				for (auto block = value.begin(); block != value.end(); block++) {
+					sizes.push_back(Json::writeString(builder, *block).size());
+					total += sizes.back();
+				}
+				size_t index = 0;
+				for (auto block = value.begin(); block != value.end(); block++, index++) {
+					auto filename = filenameOf(root, *block);
+					if (!filename.empty() && total > 0) {
+						headers[filename].bytes += static_cast<unsigned long long>(it->length) * sizes[index] / total;
+					}
+				}
+			}
+		}
+	}
+
+	/**
+	 * one line of the report
+	 */
+	struct ReportRow {
+		std::string name;
+		std::string framework;
+		std::string import;
+		unsigned long long headers;
+		unsigned long long definitions;
+		unsigned long long time;
+		unsigned long long bytes;
+	};
+
+	static Json::Value rowsToJSON (std::vector<ReportRow> &rows, const std::string &sortKey, bool detail) {
+		std::stable_sort(rows.begin(), rows.end(), [&](const ReportRow &a, const ReportRow &b) {
+			if (sortKey == "bytes") {
+				return a.bytes > b.bytes;
+			}
+			if (sortKey == "definitions") {
+				return a.definitions > b.definitions;
+			}
+			return a.time > b.time;
+		});
+		Json::Value list(Json::arrayValue);
+		for (auto it = rows.begin(); it != rows.end(); it++) {
+			Json::Value row;
+			row["name"] = it->name;
+			if (detail) {
+				row["framework"] = it->framework;
+				row["import"] = it->import;
+			} else {
+				row["headers"] = static_cast<Json::UInt64>(it->headers);
+			}
+			row["definitions"] = static_cast<Json::UInt64>(it->definitions);
+			row["time"] = it->time / 1000000.0;
+			row["bytes"] = static_cast<Json::UInt64>(it->bytes);
+			list.append(row);
+		}
+		return list;
+	}
+
+	static void addRow (std::map<std::string, ReportRow> &rows, const std::string &name, const ReportRow &header) {
+		auto &row = rows[name];
+		row.name = name;
+		row.headers++;
+		row.definitions += header.definitions;
+		row.time += header.time;
+		row.bytes += header.bytes;
+	}
+
+	Json::Value HeaderReport::toJSON (const std::string &sortKey) const {
+		std::vector<ReportRow> headerRows;
+		std::map<std::string, ReportRow> frameworkRows, importRows;
+		ReportRow total = ReportRow();
+		for (auto it = headers.begin(); it != headers.end(); it++) {
+			ReportRow row = ReportRow();
+			row.name = it->first;
+			row.framework = getFrameworkName(it->first);
+			auto import = imports.find(it->first);
+			row.import = import == imports.end() ? it->first : import->second;
+			row.headers = 1;
+			row.definitions = it->second.definitions;
+			row.time = it->second.time;
+			row.bytes = it->second.bytes;
+			headerRows.push_back(row);
+			addRow(frameworkRows, row.framework, row);
+			addRow(importRows, row.import, row);
+			total.headers++;
+			total.definitions += row.definitions;
+			total.time += row.time;
+			total.bytes += row.bytes;
+		}
+
+		std::vector<ReportRow> frameworks, importList;
+		for (auto it = frameworkRows.begin(); it != frameworkRows.end(); it++) {
+			frameworks.push_back(it->second);
+		}
+		for (auto it = importRows.begin(); it != importRows.end(); it++) {
+			importList.push_back(it->second);
+		}
+
+		Json::Value kv;
+		kv["sort"] = sortKey;
+		Json::Value totals;
+		totals["headers"] = static_cast<Json::UInt64>(total.headers);
+		totals["definitions"] = static_cast<Json::UInt64>(total.definitions);
+		totals["time"] = total.time / 1000000.0;
+		totals["bytes"] = static_cast<Json::UInt64>(total.bytes);
+		kv["total"] = totals;
+		kv["imports"] = rowsToJSON(importList, sortKey, false);
+		kv["frameworks"] = rowsToJSON(frameworks, sortKey, false);
+		kv["headers"] = rowsToJSON(headerRows, sortKey, true);
+		return kv;
+	}
+
+	bool HeaderReport::write (const std::string &file, const std::string &sortKey) const {
+		std::ofstream out(file, std::ios::out | std::ios::trunc);
+		if (out.fail()) {
+			return false;
+		}
+		Json::StreamWriterBuilder builder;
+		builder.settings_["commentStyle"] = "None";
+		builder.settings_["indentation"] = "\t";
+		out << Json::writeString(builder, toJSON(sortKey)) << std::endl;
+		out.close();
+		return !out.fail();
+	}
+
+	HeaderTimer::HeaderTimer (HeaderReport *_report) : report(_report) {
+		if (report) {
+			start = std::chrono::steady_clock::now();
+		}
+	}
+
+	HeaderTimer::~HeaderTimer () {
+		if (report && !filename.empty()) {
+			auto elapsed = std::chrono::steady_clock::now() - start;
+			report->addTime(filename, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+		}
+	}
+}
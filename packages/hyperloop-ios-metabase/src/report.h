@@ -0,0 +1,94 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_REPORT_H
+#define HYPERLOOP_REPORT_H
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "clang-c/Index.h"
+#include "json/json.h"
+#include "index.h"
+
+namespace hyperloop {
+
+	/**
+	 * Attributes the cost of a metabase to the headers it came from, written
+	 * with -report. Every header gets the definitions extracted from it, the
+	 * time spent traversing its top level cursors and the bytes its
+	 * definitions take in the output. Headers are rolled up by framework and
+	 * by the import in the input header that pulled them in, so the report
+	 * shows which imports are worth trimming.
+	 */
+	class HeaderReport {
+		public:
+			HeaderReport ();
+
+			/**
+			 * record the import in the input header that first included each
+			 * header of the translation unit
+			 */
+			void addInclusions (CXTranslationUnit tu);
+
+			/**
+			 * add traversal time in nanoseconds spent on a cursor from filename
+			 */
+			void addTime (const std::string &filename, unsigned long long nanos);
+
+			/**
+			 * count a definition extracted from filename
+			 */
+			void addDefinition (const std::string &filename);
+
+			/**
+			 * attribute the byte ranges written for each symbol to the headers
+			 * the symbols were defined in
+			 */
+			void addBytes (const Json::Value &root, const std::vector<IndexEntry> &entries);
+
+			/**
+			 * the report with every list sorted by sortKey, one of "time",
+			 * "bytes" or "definitions", in descending order
+			 */
+			Json::Value toJSON (const std::string &sortKey) const;
+
+			/**
+			 * write the report to file, returns false if it can't be written
+			 */
+			bool write (const std::string &file, const std::string &sortKey) const;
+
+			static bool isSupportedSortKey (const std::string &sortKey);
+
+		private:
+			struct Cost {
+				Cost () : definitions(0), time(0), bytes(0) {}
+				unsigned long long definitions;
+				unsigned long long time;
+				unsigned long long bytes;
+			};
+
+			std::map<std::string, Cost> headers;
+			std::map<std::string, std::string> imports;
+	};
+
+	/**
+	 * adds the time between construction and destruction to the header set
+	 * with setFilename, does nothing without a report
+	 */
+	class HeaderTimer {
+		public:
+			HeaderTimer (HeaderReport *report);
+			~HeaderTimer ();
+			inline void setFilename (const std::string &_filename) { filename = _filename; }
+		private:
+			HeaderReport *report;
+			std::string filename;
+			std::chrono::steady_clock::time_point start;
+	};
+}
+
+#endif
@@ -0,0 +1,214 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <map>
+#include <string>
+#include "schema.h"
+
+namespace hyperloop {
+
+	/**
+	 * string interning table which builds the JSON array as it goes
+	 */
+	class SchemaTable {
+		public:
+			SchemaTable () : values(Json::arrayValue) {}
+
+			Json::ArrayIndex add (const std::string &key, const Json::Value &value) {
+				auto it = indices.find(key);
+				if (it != indices.end()) {
+					return it->second;
+				}
+				auto index = values.size();
+				indices[key] = index;
+				values.append(value);
+				return index;
+			}
+
+			inline Json::Value& getValues() { return values; }
+
+		private:
+			std::map<std::string, Json::ArrayIndex> indices;
+			Json::Value values;
+	};
+
+	struct SchemaTables {
+		SchemaTable frameworks;
+		SchemaTable files;
+		SchemaTable types;
+	};
+
+	/**
+	 * returns true if kv is the base of a definition as written by Definition::toJSONBase
+	 */
+	static bool isDefinition (const Json::Value &kv) {
+		return kv.isMember("filename") && kv["filename"].isString() && kv.isMember("framework") && kv["framework"].isString();
+	}
+
+	/**
+	 * returns true if kv only describes a type, optionally with the name of an argument or field
+	 * and where the field is laid out
+	 */
+	static bool isTypeDescription (const Json::Value &kv) {
+		if (!kv.isMember("type") || !kv["type"].isString() || !kv.isMember("encoding") || !kv["encoding"].isString()) {
+			return false;
+		}
+		for (auto it = kv.begin(); it != kv.end(); it++) {
+			auto key = it.name();
+			if (key != "name" && key != "type" && key != "value" && key != "encoding" &&
+				key != "offset" && key != "bitOffset" && key != "bitWidth" && key != "fields") {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static Json::ArrayIndex addType (SchemaTables &tables, const Json::Value &kv) {
+		Json::Value type;
+		type["type"] = kv["type"];
+		if (kv.isMember("value")) {
+			type["value"] = kv["value"];
+		}
+		type["encoding"] = kv["encoding"];
+		// struct fields have no value, keep them apart from an empty value
+		auto key = kv["type"].asString() + '\0' + kv["encoding"].asString() + '\0' + (kv.isMember("value") ? "v" + kv["value"].asString() : "");
+		return tables.types.add(key, type);
+	}
+
+	static Json::ArrayIndex addFile (SchemaTables &tables, const Json::Value &kv) {
+		auto filename = kv["filename"].asString();
+		auto framework = kv["framework"].asString();
+		Json::Value file;
+		file["filename"] = filename;
+		file["framework"] = tables.frameworks.add(framework, framework);
+		file["thirdparty"] = kv.get("thirdparty", false);
+		return tables.files.add(filename, file);
+	}
+
+	static void compactValue (SchemaTables &tables, Json::Value &kv) {
+		if (kv.isObject() && isTypeDescription(kv)) {
+			auto index = addType(tables, kv);
+			if (kv.isMember("name")) {
+				// arguments and fields keep their name next to the type
+				kv.removeMember("value");
+				kv.removeMember("encoding");
+				kv["type"] = index;
+				if (kv.isMember("fields")) {
+					// of an anonymous struct or union
+					compactValue(tables, kv["fields"]);
+				}
+			} else {
+				kv = index;
+			}
+			return;
+		}
+		if (kv.isObject() && isDefinition(kv)) {
+			kv["file"] = addFile(tables, kv);
+			kv.removeMember("filename");
+			kv.removeMember("framework");
+			kv.removeMember("thirdparty");
+		}
+		if (kv.isArray() || kv.isObject()) {
+			for (auto it = kv.begin(); it != kv.end(); it++) {
+				compactValue(tables, *it);
+			}
+		}
+	}
+
+	void compactSchema (Json::Value &root) {
+		SchemaTables tables;
+		for (auto it = root.begin(); it != root.end(); it++) {
+			if (it.name() != "metadata") {
+				compactValue(tables, *it);
+			}
+		}
+		root["frameworks"] = tables.frameworks.getValues();
+		root["files"] = tables.files.getValues();
+		root["types"] = tables.types.getValues();
+	}
+
+	static void expandType (const Json::Value &types, const Json::Value &index, Json::Value &into) {
+		auto &type = types[index.asUInt()];
+		for (auto it = type.begin(); it != type.end(); it++) {
+			into[it.name()] = *it;
+		}
+	}
+
+	static void expandArgument (const Json::Value &types, Json::Value &kv) {
+		if (kv["type"].isIntegral()) {
+			auto index = kv["type"];
+			kv.removeMember("type");
+			expandType(types, index, kv);
+		}
+		if (kv.isMember("fields")) {
+			for (auto it = kv["fields"].begin(); it != kv["fields"].end(); it++) {
+				expandArgument(types, *it);
+			}
+		}
+	}
+
+	void expandDefinition (const Json::Value &root, Json::Value &kv) {
+		auto &types = root["types"];
+		if (kv.isMember("file") && kv["file"].isIntegral()) {
+			auto &file = root["files"][kv["file"].asUInt()];
+			kv["filename"] = file["filename"];
+			kv["framework"] = root["frameworks"][file["framework"].asUInt()];
+			kv["thirdparty"] = file["thirdparty"];
+			kv.removeMember("file");
+		}
+		if (kv.isMember("returns") && kv["returns"].isIntegral()) {
+			auto index = kv["returns"];
+			kv["returns"] = Json::Value();
+			expandType(types, index, kv["returns"]);
+		}
+		const char *lists[] = { "arguments", "fields" };
+		for (auto list : lists) {
+			if (kv.isMember(list)) {
+				for (auto it = kv[list].begin(); it != kv[list].end(); it++) {
+					expandArgument(types, *it);
+				}
+			}
+		}
+		if (kv.isMember("methods")) {
+			for (auto it = kv["methods"].begin(); it != kv["methods"].end(); it++) {
+				expandDefinition(root, *it);
+			}
+		}
+		if (kv.isMember("properties")) {
+			for (auto it = kv["properties"].begin(); it != kv["properties"].end(); it++) {
+				if ((*it)["type"].isIntegral()) {
+					auto index = (*it)["type"];
+					(*it)["type"] = Json::Value();
+					expandType(types, index, (*it)["type"]);
+				}
+			}
+		}
+	}
+
+	void expandSchema (Json::Value &root) {
+		if (root["metadata"]["api-version"] != "2") {
+			return;
+		}
+		for (auto it = root.begin(); it != root.end(); it++) {
+			auto section = it.name();
+			if (section == "metadata" || section == "files" || section == "frameworks" || section == "types") {
+				continue;
+			}
+			for (auto dit = it->begin(); dit != it->end(); dit++) {
+				if (dit->isArray()) {
+					// blocks are grouped by framework
+					for (auto bit = dit->begin(); bit != dit->end(); bit++) {
+						expandDefinition(root, *bit);
+					}
+				} else {
+					expandDefinition(root, *dit);
+				}
+			}
+		}
+		root.removeMember("files");
+		root.removeMember("frameworks");
+		root.removeMember("types");
+		root["metadata"]["api-version"] = "1";
+	}
+}
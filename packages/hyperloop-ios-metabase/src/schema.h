@@ -0,0 +1,43 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_SCHEMA_H
+#define HYPERLOOP_SCHEMA_H
+
+#include "json/json.h"
+
+namespace hyperloop {
+
+	/**
+	 * Rewrite a metabase from the legacy (api-version 1) layout into the
+	 * compact layout (api-version 2).
+	 *
+	 * The compact layout adds three top-level tables:
+	 *
+	 *   "frameworks": ["UIKit", ...]
+	 *   "files":      [{"filename": "...", "framework": 0, "thirdparty": false}, ...]
+	 *   "types":      [{"type": "pointer", "value": "NSString *", "encoding": "@"}, ...]
+	 *
+	 * Definitions replace their filename, framework and thirdparty members with
+	 * "file": <index into files>. Type descriptions become an index into types:
+	 * returns and property types are replaced by the index itself, arguments
+	 * and struct/union fields keep their "name" next to "type": <index>.
+	 */
+	void compactSchema (Json::Value &root);
+
+	/**
+	 * Rewrite a metabase from the compact layout back into the legacy layout,
+	 * the same as expandMetabase in lib/metabase.js. Metabases already in the
+	 * legacy layout are left unchanged.
+	 */
+	void expandSchema (Json::Value &root);
+
+	/**
+	 * Rewrite one definition of a compact metabase into the legacy layout.
+	 * Only the files, frameworks and types tables of root are read.
+	 */
+	void expandDefinition (const Json::Value &root, Json::Value &definition);
+}
+
+#endif
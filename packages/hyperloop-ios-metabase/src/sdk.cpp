@@ -0,0 +1,340 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <vector>
+#include "sdk.h"
+#include "astcache.h"
+#include "diagnostics.h"
+#include "index.h"
+#include "parallel.h"
+#include "parser.h"
+#include "util.h"
+#include "writer.h"
+#include "json/json.h"
+
+namespace hyperloop {
+
+	/**
+	 * one framework of the SDK and what became of it
+	 */
+	struct Framework {
+		Framework () : ok(false), reused(false), astReused(false), parse(0), bytes(0), diagnostics(0) {}
+		std::string name;
+		std::string umbrella;
+
+		bool ok;
+		bool reused;
+		bool astReused;
+		std::string error;
+		std::set<std::string> dependencies;
+		double parse;
+		size_t bytes;
+		unsigned long long diagnostics;
+	};
+
+	static double millisSince (std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	static bool fileExists (const std::string &path) {
+		struct stat st;
+		return stat(path.c_str(), &st) == 0;
+	}
+
+	static std::string readFile (const std::string &path) {
+		std::ifstream in(path);
+		std::stringstream buffer;
+		buffer << in.rdbuf();
+		return buffer.str();
+	}
+
+	/**
+	 * the version of the SDK from its SDKSettings, or from the name of its
+	 * directory like iPhoneSimulator9.0.sdk
+	 */
+	static std::string sdkVersion (const std::string &sdkPath) {
+		std::ifstream in(sdkPath + "/SDKSettings.json");
+		Json::Value settings;
+		Json::CharReaderBuilder builder;
+		std::string errors;
+		if (!in.fail() && Json::parseFromStream(builder, in, &settings, &errors) && settings["Version"].isString()) {
+			return settings["Version"].asString();
+		}
+		auto plist = readFile(sdkPath + "/SDKSettings.plist");
+		auto key = plist.find("<key>Version</key>");
+		if (key != std::string::npos) {
+			auto start = plist.find("<string>", key);
+			auto end = plist.find("</string>", start);
+			if (start != std::string::npos && end != std::string::npos) {
+				start += strlen("<string>");
+				return plist.substr(start, end - start);
+			}
+		}
+		auto path = sdkPath;
+		while (path.size() > 1 && path.back() == '/') {
+			path.pop_back();
+		}
+		auto name = path.substr(path.find_last_of('/') + 1);
+		auto digit = name.find_first_of("0123456789");
+		if (digit != std::string::npos) {
+			auto end = name.find_first_not_of("0123456789.", digit);
+			auto version = name.substr(digit, end == std::string::npos ? std::string::npos : end - digit);
+			while (!version.empty() && version.back() == '.') {
+				version.pop_back();
+			}
+			if (!version.empty()) {
+				return version;
+			}
+		}
+		return "unknown";
+	}
+
+	/**
+	 * the frameworks of the SDK with an umbrella header named like them, in
+	 * the same way as the system frameworks mapping of the build
+	 */
+	static std::vector<Framework> listFrameworks (const std::string &sdkPath, const std::set<std::string> &only) {
+		std::vector<Framework> frameworks;
+		auto dir = sdkPath + "/System/Library/Frameworks";
+		auto handle = opendir(dir.c_str());
+		if (!handle) {
+			return frameworks;
+		}
+		while (auto entry = readdir(handle)) {
+			std::string filename = entry->d_name;
+			auto suffix = filename.rfind(".framework");
+			if (suffix == std::string::npos || suffix + strlen(".framework") != filename.size()) {
+				continue;
+			}
+			Framework framework;
+			framework.name = filename.substr(0, suffix);
+			framework.umbrella = dir + "/" + filename + "/Headers/" + framework.name + ".h";
+			if ((only.empty() || only.count(framework.name)) && fileExists(framework.umbrella)) {
+				frameworks.push_back(framework);
+			}
+		}
+		closedir(handle);
+		std::sort(frameworks.begin(), frameworks.end(), [](const Framework &a, const Framework &b) {
+			return a.name < b.name;
+		});
+		return frameworks;
+	}
+
+	/**
+	 * create dir and the directories above it
+	 */
+	static bool makeDirectories (const std::string &dir) {
+		for (size_t slash = dir.find('/', 1); ; slash = dir.find('/', slash + 1)) {
+			auto path = dir.substr(0, slash);
+			if (!path.empty() && mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+				return false;
+			}
+			if (slash == std::string::npos) {
+				return true;
+			}
+		}
+	}
+
+	static void visitInclusion (CXFile file, CXSourceLocation *stack, unsigned depth, CXClientData clientData) {
+		auto filename = CXStringToString(clang_getFileName(file));
+		if (filename.find(".framework/") != std::string::npos) {
+			static_cast<std::set<std::string> *>(clientData)->insert(getFrameworkName(filename));
+		}
+	}
+
+	/**
+	 * parse the umbrella header of a framework and write the definitions
+	 * declared in it. The translation unit includes the frameworks it depends
+	 * on, so their types resolve, but they're left to their own metabases.
+	 */
+	static void writeFramework (Framework &framework, const std::string &sdkPath, const std::string &minVersion, const std::string &schema, const std::vector<std::string> &includes, const std::vector<std::string> &frameworks, const std::string &moduleCache, const std::string &astCache, const std::string &dir, bool pretty, bool writeIndex, unsigned threads) {
+		auto compilerArgs = compilerArguments(framework.umbrella, sdkPath, minVersion, includes, frameworks, moduleCache);
+
+		auto start = std::chrono::steady_clock::now();
+		auto index = clang_createIndex(moduleCache.empty() ? 1 : 0, 0);
+		Diagnostics diagnostics;
+		auto tu = parseTranslationUnit(index, compilerArgs, astCache, diagnostics, &framework.astReused);
+		if (!tu) {
+			clang_disposeIndex(index);
+			framework.error = "couldn't parse header: " + framework.umbrella;
+			return;
+		}
+		clang_getInclusions(tu, visitInclusion, &framework.dependencies);
+		framework.dependencies.erase(framework.name);
+		auto path = sdkPath;
+		auto version = minVersion;
+		std::unique_ptr<ParserContext> ctx(parse(tu, path, version, false, nullptr, nullptr, nullptr, &diagnostics));
+		ctx->setThreads(threads);
+		auto json = ctx->getParserTree()->frameworkToJSON(schema, minVersion, framework.name);
+		framework.parse = millisSince(start);
+		framework.diagnostics = diagnostics.getCount();
+		ctx.reset();
+		clang_disposeTranslationUnit(tu);
+		clang_disposeIndex(index);
+
+		auto file = dir + "/" + framework.name + ".json";
+		std::ofstream out(file);
+		if (out.fail()) {
+			framework.error = "open failed for file: " + file;
+			return;
+		}
+		MetabaseWriter writer(out, pretty);
+		writer.write(json);
+		out << std::endl;
+		out.close();
+		if (out.fail()) {
+			framework.error = "couldn't write file: " + file;
+			return;
+		}
+		if (writeIndex && !MetabaseIndex::write(file, writer.getEntries())) {
+			framework.error = "couldn't write index for file: " + file;
+			return;
+		}
+		framework.bytes = writer.getBytesWritten();
+		framework.ok = true;
+	}
+
+	static Json::Value frameworkToJSON (const Framework &framework) {
+		Json::Value kv;
+		kv["file"] = framework.name + ".json";
+		kv["umbrella"] = framework.umbrella;
+		Json::Value dependencies(Json::arrayValue);
+		for (auto it = framework.dependencies.begin(); it != framework.dependencies.end(); it++) {
+			dependencies.append(*it);
+		}
+		kv["dependencies"] = dependencies;
+		kv["status"] = framework.ok ? "ok" : "failed";
+		if (!framework.ok) {
+			kv["error"] = framework.error;
+		} else {
+			kv["parse"] = framework.parse;
+			kv["bytes"] = static_cast<Json::UInt64>(framework.bytes);
+			kv["diagnostics"] = static_cast<Json::UInt64>(framework.diagnostics);
+			if (framework.astReused) {
+				kv["ast-reused"] = true;
+			}
+		}
+		return kv;
+	}
+
+	int sdk (std::map<std::string, std::string> &arguments) {
+		if (!arguments.count("-sim-sdk-path") || !arguments.count("-min-ios-ver") || !arguments.count("-o")) {
+			std::cerr << "sdk requires -sim-sdk-path, -min-ios-ver and the cache directory as -o" << std::endl;
+			return EXIT_FAILURE;
+		}
+		auto sdkPath = arguments["-sim-sdk-path"];
+		auto minVersion = arguments["-min-ios-ver"];
+		trim(minVersion);
+		if (minVersion.empty() || minVersion.find(',') != std::string::npos) {
+			std::cerr << "the SDK cache is written for one minimum iOS version" << std::endl;
+			return EXIT_FAILURE;
+		}
+		auto schema = arguments.count("-schema") ? arguments["-schema"] : "1";
+		if (!ParserTree::isSupportedAPIVersion(schema)) {
+			std::cerr << "unsupported schema version: " << schema << std::endl;
+			return EXIT_FAILURE;
+		}
+		auto threads = arguments.count("-threads") ? atoi(arguments["-threads"].c_str()) : static_cast<int>(defaultThreads());
+		auto pretty = arguments.count("-pretty") > 0;
+		auto force = arguments.count("-force") > 0;
+		auto writeIndex = arguments.count("-index") > 0;
+		auto includes = tokenize(arguments["-hsp"], ",");
+		auto searchPaths = tokenize(arguments["-fsp"], ",");
+		auto moduleCache = arguments.count("-modules") ? arguments["-modules"] : "";
+		auto astCache = arguments.count("-ast-cache") ? arguments["-ast-cache"] : "";
+		auto names = tokenize(arguments["-frameworks"], ",");
+		std::set<std::string> only;
+		for (auto it = names.begin(); it != names.end(); it++) {
+			trim(*it);
+			only.insert(*it);
+		}
+
+		auto version = sdkVersion(sdkPath);
+		auto dir = arguments["-o"] + "/" + version + "/" + minVersion;
+		if (!makeDirectories(dir)) {
+			std::cerr << "couldn't create cache directory: " << dir << " with error code " << strerror(errno) << std::endl;
+			return EXIT_FAILURE;
+		}
+		auto frameworks = listFrameworks(sdkPath, only);
+		if (frameworks.empty()) {
+			std::cerr << "no frameworks found in SDK: " << sdkPath << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		// a framework written by an earlier run of the same schema is kept
+		Json::Value previous;
+		{
+			std::ifstream in(dir + "/index.json");
+			Json::CharReaderBuilder builder;
+			std::string errors;
+			if (in.fail() || !Json::parseFromStream(builder, in, &previous, &errors) || previous["metadata"]["api-version"] != schema) {
+				previous = Json::Value();
+			}
+		}
+		std::vector<size_t> pending;
+		for (size_t i = 0; i < frameworks.size(); i++) {
+			auto &entry = previous["frameworks"][frameworks[i].name];
+			if (!force && entry["status"] == "ok" && fileExists(dir + "/" + frameworks[i].name + ".json")) {
+				frameworks[i].reused = true;
+			} else {
+				pending.push_back(i);
+			}
+		}
+
+		// frameworks are parsed side by side, each resolves on the threads left over
+		unsigned workers = threads < 1 ? 1 : threads;
+		unsigned resolvers = pending.empty() || workers <= pending.size() ? 1 : workers / static_cast<unsigned>(pending.size());
+		parallelFor(pending.size(), workers, [&](size_t i) {
+			auto &framework = frameworks[pending[i]];
+			try {
+				writeFramework(framework, sdkPath, minVersion, schema, includes, searchPaths, moduleCache, astCache, dir, pretty, writeIndex, resolvers);
+			} catch (const std::exception &e) {
+				framework.ok = false;
+				framework.error = e.what();
+			}
+		}, 1);
+
+		Json::Value kv;
+		kv["metadata"]["sdk-path"] = sdkPath;
+		kv["metadata"]["sdk-version"] = version;
+		kv["metadata"]["min-version"] = minVersion;
+		kv["metadata"]["api-version"] = schema;
+		kv["frameworks"] = previous["frameworks"].isObject() ? previous["frameworks"] : Json::Value(Json::objectValue);
+		size_t failed = 0;
+		for (auto it = frameworks.begin(); it != frameworks.end(); it++) {
+			if (it->reused) {
+				continue;
+			}
+			if (!it->ok) {
+				std::cerr << "couldn't generate framework " << it->name << ": " << it->error << std::endl;
+				failed++;
+			}
+			kv["frameworks"][it->name] = frameworkToJSON(*it);
+		}
+		Json::StreamWriterBuilder writer;
+		writer.settings_["commentStyle"] = "None";
+		writer.settings_["indentation"] = "\t";
+		std::ofstream out(dir + "/index.json");
+		out << Json::writeString(writer, kv) << std::endl;
+		out.close();
+		if (out.fail()) {
+			std::cerr << "couldn't write index to directory: " << dir << std::endl;
+			return EXIT_FAILURE;
+		}
+		std::cout << dir << std::endl;
+		return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+}
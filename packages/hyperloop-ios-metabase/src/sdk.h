@@ -0,0 +1,26 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_SDK_H
+#define HYPERLOOP_SDK_H
+
+#include <map>
+#include <string>
+
+namespace hyperloop {
+
+	/**
+	 * write a metabase per framework of an SDK into a cache directory keyed by
+	 * the SDK version and minimum version. Every framework with an umbrella
+	 * header in System/Library/Frameworks is parsed in its own translation
+	 * unit, which brings in the frameworks it depends on, and only its own
+	 * definitions are written. Frameworks are parsed concurrently on up to
+	 * -threads threads, those already in the cache are kept unless -force.
+	 * Writes an index.json of the frameworks and prints the directory written
+	 * to, returns the process exit code
+	 */
+	int sdk (std::map<std::string, std::string> &arguments);
+}
+
+#endif
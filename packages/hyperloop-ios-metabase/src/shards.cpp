@@ -0,0 +1,232 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <algorithm>
+#include <fstream>
+#include "shards.h"
+#include "class.h"
+#include "def.h"
+#include "parallel.h"
+#include "parser.h"
+#include "schema.h"
+#include "util.h"
+#include "writer.h"
+
+namespace hyperloop {
+
+	/**
+	 * the include order clang saw: the position of each header and the
+	 * position of the last header included below it
+	 */
+	struct Inclusions {
+		size_t count;
+		std::map<std::string, size_t> first;
+		std::map<std::string, size_t> last;
+	};
+
+	static void visitInclusion (CXFile file, CXSourceLocation *stack, unsigned depth, CXClientData clientData) {
+		auto inclusions = static_cast<Inclusions *>(clientData);
+		auto position = inclusions->count++;
+		auto filename = CXStringToString(clang_getFileName(file));
+		inclusions->first.insert(std::make_pair(filename, position));
+		inclusions->last[filename] = position;
+		for (unsigned i = 0; i < depth; i++) {
+			CXFile includer;
+			unsigned line, column, offset;
+			clang_getFileLocation(stack[i], &includer, &line, &column, &offset);
+			auto &last = inclusions->last[CXStringToString(clang_getFileName(includer))];
+			last = std::max(last, position);
+		}
+	}
+
+	/**
+	 * file name of the shard of a framework, headers outside of a framework
+	 * are named by their path
+	 */
+	static std::string shardFile (const std::string &framework) {
+		auto name = framework;
+		std::replace(name.begin(), name.end(), '/', '_');
+		return name + ".json";
+	}
+
+	ShardWriter::ShardWriter (const std::string &_dir, const std::string &_apiVersion, bool _pretty, bool _writeIndex) :
+		dir(_dir), apiVersion(_apiVersion), pretty(_pretty), writeIndex(_writeIndex), context(nullptr), nextEnd(0), reached(0),
+		busy(false), stopping(false), failed(false), bytesWritten(0) {
+	}
+
+	ShardWriter::~ShardWriter () {
+		stop();
+	}
+
+	void ShardWriter::addInclusions (CXTranslationUnit tu) {
+		Inclusions inclusions;
+		inclusions.count = 0;
+		clang_getInclusions(tu, visitInclusion, &inclusions);
+		std::map<std::string, size_t> ends;
+		for (auto it = inclusions.first.begin(); it != inclusions.first.end(); it++) {
+			auto &end = ends[getFrameworkName(it->first)];
+			end = std::max(end, inclusions.last[it->first]);
+		}
+		fileOrder.swap(inclusions.first);
+		for (auto it = ends.begin(); it != ends.end(); it++) {
+			frameworkEnds.push_back(std::make_pair(it->second, it->first));
+		}
+		std::sort(frameworkEnds.begin(), frameworkEnds.end());
+	}
+
+	void ShardWriter::start (ParserContext *ctx) {
+		context = ctx;
+		context->getParserTree()->setShared(true);
+		thread = std::thread(&ShardWriter::run, this);
+	}
+
+	void ShardWriter::visit (const std::string &filename) {
+		if (filename == lastFile) {
+			return;
+		}
+		lastFile = filename;
+		auto found = fileOrder.find(filename);
+		if (found == fileOrder.end() || found->second <= reached) {
+			return;
+		}
+		reached = found->second;
+		while (nextEnd < frameworkEnds.size() && frameworkEnds[nextEnd].first < reached) {
+			auto &framework = frameworkEnds[nextEnd++].second;
+			// classes and categories still waiting for their class are merged
+			// at the end, so their framework is written then
+			if (ClassDefinition::hasPendingClasses(context, framework)) {
+				continue;
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			if (definitions.find(framework) != definitions.end()) {
+				handed.insert(framework);
+				queue.push_back(framework);
+				wake.notify_one();
+			}
+		}
+	}
+
+	void ShardWriter::addDefinition (Definition *definition) {
+		auto framework = definition->getFramework();
+		std::lock_guard<std::mutex> lock(mutex);
+		definitions[framework].push_back(definition);
+		if (handed.count(framework)) {
+			stale.insert(framework);
+		}
+	}
+
+	void ShardWriter::changed (const std::string &framework) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (handed.count(framework)) {
+			stale.insert(framework);
+		}
+	}
+
+	void ShardWriter::drain () {
+		std::unique_lock<std::mutex> lock(mutex);
+		idle.wait(lock, [this]() { return queue.empty() && !busy; });
+	}
+
+	void ShardWriter::run () {
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true) {
+			wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+			if (queue.empty()) {
+				return;
+			}
+			auto framework = queue.front();
+			queue.pop_front();
+			auto defs = definitions[framework];
+			busy = true;
+			lock.unlock();
+			auto written = write(framework, defs);
+			lock.lock();
+			busy = false;
+			if (written) {
+				early.insert(framework);
+			}
+			idle.notify_all();
+		}
+	}
+
+	void ShardWriter::stop () {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+			wake.notify_all();
+		}
+		if (thread.joinable()) {
+			thread.join();
+		}
+	}
+
+	bool ShardWriter::write (const std::string &framework, const std::vector<Definition *> &defs) {
+		auto tree = context->getParserTree();
+		auto target = context->getMinVersionNumber();
+		Json::Value kv;
+		kv["metadata"] = tree->metadataToJSON(apiVersion, context->getMinVersion());
+		for (auto it = defs.begin(); it != defs.end(); it++) {
+			auto definition = *it;
+			// the parse only changes a definition while holding the tree lock
+			auto guard = tree->lock();
+			auto section = tree->getSection(definition);
+			if (section && definition->getAvailability().isAvailableIn(target)) {
+				ResolveScope scope(definition);
+				kv[section][definition->getName()] = definition->toJSON();
+			}
+		}
+		auto blocks = tree->blocksToJSON(framework);
+		if (!blocks.isNull()) {
+			kv["blocks"][framework].swap(blocks);
+		}
+		if (apiVersion != "1") {
+			compactSchema(kv);
+		}
+
+		auto file = shardFile(framework);
+		auto path = dir + "/" + file;
+		std::ofstream out(path);
+		MetabaseWriter writer(out, pretty);
+		writer.write(kv);
+		out << std::endl;
+		out.close();
+		auto ok = !out.fail() && (!writeIndex || MetabaseIndex::write(path, writer.getEntries()));
+
+		std::lock_guard<std::mutex> lock(mutex);
+		files[framework] = file;
+		bytesWritten += writer.getBytesWritten();
+		if (!ok) {
+			failed = true;
+		}
+		return ok;
+	}
+
+	bool ShardWriter::finish (unsigned threads) {
+		stop();
+		std::vector<std::pair<std::string, std::vector<Definition *>>> left;
+		for (auto it = definitions.begin(); it != definitions.end(); it++) {
+			if (!early.count(it->first) || stale.count(it->first)) {
+				left.push_back(*it);
+			}
+		}
+		parallelFor(left.size(), threads, [&](size_t i) {
+			write(left[i].first, left[i].second);
+		}, 1);
+
+		Json::Value kv;
+		kv["frameworks"] = Json::Value(Json::objectValue);
+		for (auto it = files.begin(); it != files.end(); it++) {
+			Json::Value shard;
+			shard["file"] = it->second;
+			shard["early"] = early.count(it->first) > 0 && !stale.count(it->first);
+			kv["frameworks"][it->first] = shard;
+		}
+		std::ofstream out(dir + "/shards.json");
+		Json::StreamWriterBuilder builder;
+		builder.settings_["indentation"] = "\t";
+		out << Json::writeString(builder, kv) << std::endl;
+		out.close();
+		return !failed && !out.fail();
+	}
+}
@@ -0,0 +1,128 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_SHARDS_H
+#define HYPERLOOP_SHARDS_H
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "clang-c/Index.h"
+#include "json/json.h"
+
+namespace hyperloop {
+
+	class Definition;
+	class ParserContext;
+
+	/**
+	 * Writes a metabase per framework into a directory with -shards, while the
+	 * translation unit is still being traversed. Headers are traversed in the
+	 * order clang entered them, so once the traversal passes the last header
+	 * included through a framework, nothing more of it can follow. A finished
+	 * framework with no classes or categories waiting in pendingClasses is
+	 * handed to a serializer thread, which resolves and writes its shard and
+	 * drops the JSON, so the whole document is never held at once.
+	 *
+	 * Shards are resolved against the definitions seen so far. Classes that
+	 * change after their shard is written, when ClassDefinition::complete
+	 * merges categories into them, are written again at the end.
+	 */
+	class ShardWriter {
+		public:
+			ShardWriter (const std::string &dir, const std::string &apiVersion, bool pretty, bool writeIndex);
+			~ShardWriter ();
+
+			/**
+			 * record when the traversal is done with each framework, from the
+			 * order clang included the headers of tu
+			 */
+			void addInclusions (CXTranslationUnit tu);
+
+			/**
+			 * start the serializer thread on the tree of ctx
+			 */
+			void start (ParserContext *ctx);
+
+			/**
+			 * the traversal reached a cursor in filename, hands the frameworks
+			 * it's done with to the serializer
+			 */
+			void visit (const std::string &filename);
+
+			/**
+			 * a definition extracted at the top level of the translation unit
+			 */
+			void addDefinition (Definition *definition);
+
+			/**
+			 * a class of framework changed, its shard is written again at the
+			 * end if it was handed to the serializer already
+			 */
+			void changed (const std::string &framework);
+
+			/**
+			 * wait until the serializer has written what it was handed, before
+			 * the model changes under it
+			 */
+			void drain ();
+
+			/**
+			 * write the frameworks left and the ones changed after they were
+			 * written on up to threads threads, and a shards.json listing them.
+			 * Returns false if a file can't be written.
+			 */
+			bool finish (unsigned threads);
+
+			inline unsigned long long getBytesWritten () const { return bytesWritten; }
+
+			/**
+			 * frameworks written while the traversal was still running
+			 */
+			inline size_t getEarlyCount () const { return early.size(); }
+
+		private:
+			std::string dir;
+			std::string apiVersion;
+			bool pretty;
+			bool writeIndex;
+			ParserContext *context;
+
+			// the position of each header in clang's include order, and the
+			// position after which a framework has nothing left
+			std::map<std::string, size_t> fileOrder;
+			std::vector<std::pair<size_t, std::string>> frameworkEnds;
+			size_t nextEnd;
+			size_t reached;
+			std::string lastFile;
+
+			std::mutex mutex;
+			std::condition_variable wake;
+			std::condition_variable idle;
+			std::thread thread;
+			std::deque<std::string> queue;
+			bool busy;
+			bool stopping;
+			bool failed;
+			std::map<std::string, std::vector<Definition *>> definitions;
+			std::set<std::string> handed;
+			std::set<std::string> early;
+			std::set<std::string> stale;
+			std::map<std::string, std::string> files;
+			unsigned long long bytesWritten;
+
+			void run ();
+			bool write (const std::string &framework, const std::vector<Definition *> &defs);
+			void stop ();
+	};
+}
+
+#endif
@@ -0,0 +1,201 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+#include "instances.h"
+#include "stats.h"
+
+namespace hyperloop {
+
+	/**
+	 * milliseconds on a monotonic clock
+	 */
+	static double wallTime () {
+		auto now = std::chrono::steady_clock::now().time_since_epoch();
+		return std::chrono::duration<double, std::milli>(now).count();
+	}
+
+	/**
+	 * user plus system CPU time of the process in milliseconds
+	 */
+	static double cpuTime () {
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0) {
+			return 0;
+		}
+		return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+			(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+	}
+
+	/**
+	 * milliseconds rounded to the microsecond for the report
+	 */
+	static double roundMillis (double ms) {
+		return std::floor(ms * 1000 + 0.5) / 1000;
+	}
+
+	Stats::Stats () : bytesWritten(0), documentValues(0), documentBytes(0), wallStart(wallTime()), cpuStart(cpuTime()) {
+	}
+
+	Stats::Phase& Stats::getPhase (const std::string &name) {
+		for (auto it = phases.begin(); it != phases.end(); it++) {
+			if (it->name == name) {
+				return *it;
+			}
+		}
+		Phase phase = { name, 0, 0, 0, 0, 0, -1, -1 };
+		phases.push_back(phase);
+		return phases.back();
+	}
+
+	void Stats::begin (const std::string &name) {
+		auto &phase = getPhase(name);
+		if (phase.calls == 0) {
+			phase.rssBefore = currentRSS();
+		}
+		phase.wallStart = wallTime();
+		phase.cpuStart = cpuTime();
+	}
+
+	void Stats::end (const std::string &name) {
+		auto &phase = getPhase(name);
+		phase.wall += wallTime() - phase.wallStart;
+		phase.cpu += cpuTime() - phase.cpuStart;
+		phase.calls++;
+		phase.rssAfter = currentRSS();
+	}
+
+	double Stats::getWallTime (const std::string &name) const {
+		for (auto it = phases.begin(); it != phases.end(); it++) {
+			if (it->name == name) {
+				return it->wall;
+			}
+		}
+		return 0;
+	}
+
+	void Stats::count (const std::string &name, unsigned long long n) {
+		counters[name] += n;
+	}
+
+	unsigned long long Stats::getCount (const std::string &name) const {
+		auto it = counters.find(name);
+		return it == counters.end() ? 0 : it->second;
+	}
+
+	long long Stats::peakRSS () {
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0) {
+			return -1;
+		}
+#if defined(__APPLE__)
+		// bytes on darwin, kilobytes everywhere else
+		return static_cast<long long>(usage.ru_maxrss);
+#else
+		return static_cast<long long>(usage.ru_maxrss) * 1024;
+#endif
+	}
+
+	long long Stats::currentRSS () {
+#if defined(__APPLE__)
+		mach_task_basic_info_data_t info;
+		mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+		if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+			return -1;
+		}
+		return static_cast<long long>(info.resident_size);
+#else
+		// second field of statm is resident pages
+		FILE *file = fopen("/proc/self/statm", "r");
+		if (!file) {
+			return -1;
+		}
+		long long size = 0, resident = 0;
+		auto read = fscanf(file, "%lld %lld", &size, &resident);
+		fclose(file);
+		if (read != 2) {
+			return -1;
+		}
+		return resident * sysconf(_SC_PAGESIZE);
+#endif
+	}
+
+	void Stats::sampleInstances () {
+		instances = InstanceCounter::toJSON();
+	}
+
+	void Stats::measureDocument (const Json::Value &root) {
+		documentValues = 0;
+		documentBytes = 0;
+		hyperloop::measureDocument(root, documentValues, documentBytes);
+	}
+
+	Json::Value Stats::toJSON () const {
+		Json::Value kv;
+		Json::Value phasesKV(Json::arrayValue);
+		for (auto it = phases.begin(); it != phases.end(); it++) {
+			Json::Value phase;
+			phase["name"] = it->name;
+			phase["wall"] = roundMillis(it->wall);
+			phase["cpu"] = roundMillis(it->cpu);
+			phase["calls"] = it->calls;
+			phase["rss"]["before"] = static_cast<Json::Int64>(it->rssBefore);
+			phase["rss"]["after"] = static_cast<Json::Int64>(it->rssAfter);
+			phasesKV.append(phase);
+		}
+		kv["phases"] = phasesKV;
+		Json::Value total;
+		total["wall"] = roundMillis(wallTime() - wallStart);
+		total["cpu"] = roundMillis(cpuTime() - cpuStart);
+		kv["total"] = total;
+		Json::Value countersKV(Json::objectValue);
+		for (auto it = counters.begin(); it != counters.end(); it++) {
+			countersKV[it->first] = static_cast<Json::UInt64>(it->second);
+		}
+		kv["counts"] = countersKV;
+		kv["bytesWritten"] = static_cast<Json::UInt64>(bytesWritten);
+		kv["peakRSS"] = static_cast<Json::Int64>(peakRSS());
+		kv["rss"] = static_cast<Json::Int64>(currentRSS());
+		kv["instances"] = instances.isNull() ? InstanceCounter::toJSON() : instances;
+		Json::Value document;
+		document["values"] = static_cast<Json::UInt64>(documentValues);
+		document["bytes"] = static_cast<Json::UInt64>(documentBytes);
+		kv["document"] = document;
+		return kv;
+	}
+
+	bool Stats::write (const std::string &file) const {
+		std::ofstream out(file, std::ios::out | std::ios::trunc);
+		if (out.fail()) {
+			return false;
+		}
+		Json::StreamWriterBuilder builder;
+		builder.settings_["commentStyle"] = "None";
+		builder.settings_["indentation"] = "\t";
+		out << Json::writeString(builder, toJSON()) << std::endl;
+		out.close();
+		return !out.fail();
+	}
+
+	StatsPhase::StatsPhase (Stats *_stats, const std::string &_phase) : stats(_stats), phase(_phase) {
+		if (stats) {
+			stats->begin(phase);
+		}
+	}
+
+	StatsPhase::~StatsPhase () {
+		if (stats) {
+			stats->end(phase);
+		}
+	}
+}
@@ -0,0 +1,117 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_STATS_H
+#define HYPERLOOP_STATS_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "json/json.h"
+
+namespace hyperloop {
+
+	/**
+	 * Wall and CPU time of the generator's phases plus a handful of counters,
+	 * written as JSON with -stats so slow runs can be broken down without a
+	 * profiler. Phases are reported in the order they were started, with the
+	 * resident set size when the phase was first entered and last left.
+	 */
+	class Stats {
+		public:
+			Stats ();
+
+			/**
+			 * start and stop timing a phase, time spent in a phase that is
+			 * entered more than once adds up
+			 */
+			void begin (const std::string &phase);
+			void end (const std::string &phase);
+
+			/**
+			 * add to a named counter
+			 */
+			void count (const std::string &name, unsigned long long n = 1);
+
+			/**
+			 * set the number of bytes of metabase JSON written
+			 */
+			inline void setBytesWritten (unsigned long long bytes) { bytesWritten = bytes; }
+
+			/**
+			 * wall time of a phase in milliseconds, 0 if it never ran
+			 */
+			double getWallTime (const std::string &phase) const;
+
+			/**
+			 * value of a counter, 0 if never counted
+			 */
+			unsigned long long getCount (const std::string &name) const;
+
+			/**
+			 * snapshot the live and peak instances of every model type
+			 */
+			void sampleInstances ();
+
+			/**
+			 * record the number of values and approximate heap bytes of the
+			 * metabase JSON document
+			 */
+			void measureDocument (const Json::Value &root);
+
+			Json::Value toJSON () const;
+
+			/**
+			 * write the report to file, returns false if it can't be written
+			 */
+			bool write (const std::string &file) const;
+
+			/**
+			 * process peak resident set size in bytes
+			 */
+			static long long peakRSS ();
+
+			/**
+			 * process resident set size in bytes right now, -1 if unknown
+			 */
+			static long long currentRSS ();
+
+		private:
+			struct Phase {
+				std::string name;
+				double wall;
+				double cpu;
+				double wallStart;
+				double cpuStart;
+				unsigned calls;
+				long long rssBefore;
+				long long rssAfter;
+			};
+			Phase& getPhase (const std::string &name);
+
+			std::vector<Phase> phases;
+			std::map<std::string, unsigned long long> counters;
+			unsigned long long bytesWritten;
+			unsigned long long documentValues;
+			unsigned long long documentBytes;
+			Json::Value instances;
+			double wallStart;
+			double cpuStart;
+	};
+
+	/**
+	 * times a phase for the lifetime of the object, does nothing without stats
+	 */
+	class StatsPhase {
+		public:
+			StatsPhase (Stats *stats, const std::string &phase);
+			~StatsPhase ();
+		private:
+			Stats *stats;
+			std::string phase;
+	};
+}
+
+#endif
@@ -22,7 +22,7 @@ namespace hyperloop {
 			case CXCursor_FieldDecl: {
 //				std::cout << "struct field " << displayName << ", type: " << argType.kind << ", encoding: " << encoding << " struct: " << structDef->getName() << std::endl;
 				auto type = new Type(cursor, structDef->getContext());
-				structDef->addField(displayName, type);
+				structDef->addField(cursor, displayName, type);
 				addBlockIfFound(structDef, cursor, parent);
 				break;
 			}
@@ -33,10 +33,7 @@ namespace hyperloop {
 				break;
 			}
 			default: {
-				std::cerr << "not handled, struct: " << displayName << " kind: " << kind << std::endl;
-				std::map<std::string, std::string> location;
-				getSourceLocation(cursor, structDef->getContext(), location);
-				std::cerr << "struct: " << displayName << " kind: " << kind << ", " << hyperloop::toJSON(location) << std::endl;
+				structDef->getContext()->diagnose("unhandled.struct", structDef->getName() + ":" + displayName + " kind: " + std::to_string(kind));
 				break;
 			}
 		}
@@ -44,7 +41,7 @@ namespace hyperloop {
 	}
 
 	StructDefinition::StructDefinition (CXCursor cursor, const std::string &name, ParserContext *ctx) :
-		Definition(cursor, name, ctx) {
+		Definition(cursor, name, ctx), size(-1), alignment(-1) {
 	}
 
 	StructDefinition::~StructDefinition () {
@@ -57,6 +54,10 @@ namespace hyperloop {
 	Json::Value StructDefinition::toJSON () const {
 		Json::Value kv;
 		toJSONBase(kv);
+		if (size >= 0 && alignment >= 0) {
+			kv[keys::size] = static_cast<Json::UInt64>(size);
+			kv[keys::alignment] = static_cast<Json::UInt64>(alignment);
+		}
 		if (fields.size() > 0) {
 			Json::Value fkv;
 			for (auto it = fields.begin(); it != fields.end(); it++) {
@@ -64,13 +65,13 @@ namespace hyperloop {
 				v.removeMember("value");
 				fkv.append(v);
 			}
-			kv["fields"] = fkv;
+			kv[keys::fields] = fkv;
 		}
 		return kv;
 	}
 
-	void StructDefinition::addField (const std::string &name, Type *type) {
-		auto arg = new Argument(name, type);
+	void StructDefinition::addField (CXCursor cursor, const std::string &name, Type *type) {
+		auto arg = new Field(cursor, name, type, this->getContext());
 		fields.push_back(arg);
 	}
 
@@ -88,6 +89,9 @@ namespace hyperloop {
 		if (!clang_isUnexposed(kind) && !this->getName().empty()) {
 			context->getParserTree()->addStruct(this);
 		}
+		auto recordType = clang_getCursorType(cursor);
+		this->size = clang_Type_getSizeOf(recordType);
+		this->alignment = clang_Type_getAlignOf(recordType);
 		clang_visitChildren(cursor, parseStructMember, this);
 		return CXChildVisit_Continue;
 	}
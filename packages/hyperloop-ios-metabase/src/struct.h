@@ -10,17 +10,21 @@
 
 namespace hyperloop {
 
-	class StructDefinition : public Definition {
+	class StructDefinition : public Definition, private Counted<StructDefinition> {
 	public:
 		StructDefinition (CXCursor cursor, const std::string &name, ParserContext *ctx);
 		~StructDefinition();
 		Json::Value toJSON () const;
-		void addField (const std::string &name, Type *type);
+		inline const char* getKind () const { return "struct"; }
+		void addField (CXCursor cursor, const std::string &name, Type *type);
 		inline Type *getType() { return this->type; }
 		std::vector<Argument *> getFields();
 	private:
 		Type *type;
 		std::vector<Argument *> fields;
+		// in bytes as laid out by clang, negative if the type is incomplete
+		long long size;
+		long long alignment;
 		CXChildVisitResult executeParse(CXCursor cursor, ParserContext *context);
 	};
 }
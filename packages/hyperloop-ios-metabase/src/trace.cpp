@@ -0,0 +1,93 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <fstream>
+#include <unistd.h>
+#include "trace.h"
+#include "util.h"
+
+namespace hyperloop {
+
+	Trace::Trace (unsigned long long _threshold) : started(std::chrono::steady_clock::now()), threshold(_threshold),
+		events(Json::arrayValue), visitStart(0), visitCursors(0) {
+		// name the process so the trace viewer doesn't just show a pid
+		Json::Value event;
+		event["name"] = "process_name";
+		event["ph"] = "M";
+		event["pid"] = static_cast<int>(getpid());
+		event["tid"] = 1;
+		event["args"]["name"] = "metabase";
+		events.append(event);
+	}
+
+	unsigned long long Trace::now () const {
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+	}
+
+	void Trace::span (const std::string &name, const std::string &category, unsigned long long start, unsigned long long end, const Json::Value &args) {
+		Json::Value event;
+		event["name"] = name;
+		event["cat"] = category;
+		event["ph"] = "X";
+		event["ts"] = static_cast<Json::UInt64>(start);
+		event["dur"] = static_cast<Json::UInt64>(end - start);
+		event["pid"] = static_cast<int>(getpid());
+		event["tid"] = 1;
+		if (!args.isNull()) {
+			event["args"] = args;
+		}
+		events.append(event);
+	}
+
+	void Trace::visit (const std::string &filename) {
+		if (filename == visitFile) {
+			visitCursors++;
+			return;
+		}
+		endVisits();
+		visitFile = filename;
+		visitStart = now();
+		visitCursors = 1;
+	}
+
+	void Trace::endVisits () {
+		if (visitCursors == 0) {
+			return;
+		}
+		Json::Value args;
+		args["filename"] = visitFile;
+		args["cursors"] = visitCursors;
+		span(getFrameworkName(visitFile), "visit", visitStart, now(), args);
+		visitFile.clear();
+		visitCursors = 0;
+	}
+
+	bool Trace::write (const std::string &file) {
+		endVisits();
+		std::ofstream out(file, std::ios::out | std::ios::trunc);
+		if (out.fail()) {
+			return false;
+		}
+		Json::Value kv;
+		kv["traceEvents"] = events;
+		kv["displayTimeUnit"] = "ms";
+		Json::StreamWriterBuilder builder;
+		builder.settings_["indentation"] = "";
+		out << Json::writeString(builder, kv) << std::endl;
+		out.close();
+		return !out.fail();
+	}
+
+	TraceSpan::TraceSpan (Trace *_trace, const std::string &_name, const std::string &_category) : trace(_trace), name(_name), category(_category), start(0) {
+		if (trace) {
+			start = trace->now();
+		}
+	}
+
+	TraceSpan::~TraceSpan () {
+		if (trace) {
+			trace->span(name, category, start, trace->now());
+		}
+	}
+}
@@ -0,0 +1,83 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_TRACE_H
+#define HYPERLOOP_TRACE_H
+
+#include <chrono>
+#include <string>
+
+#include "json/json.h"
+
+namespace hyperloop {
+
+	/**
+	 * Records spans in the Chrome trace event format, written with -trace so a
+	 * slow run can be opened in chrome://tracing or Perfetto.
+	 *
+	 * Top level cursors are grouped into one span per run of consecutive
+	 * cursors from the same header, named after its framework. Definitions
+	 * are only recorded when parsing them took at least the threshold, which
+	 * keeps traces of a whole SDK to a manageable size.
+	 */
+	class Trace {
+		public:
+			/**
+			 * threshold is the minimum duration in microseconds of a recorded definition
+			 */
+			Trace (unsigned long long threshold);
+
+			/**
+			 * microseconds since the trace was started
+			 */
+			unsigned long long now () const;
+
+			/**
+			 * record a complete span
+			 */
+			void span (const std::string &name, const std::string &category, unsigned long long start, unsigned long long end, const Json::Value &args = Json::Value());
+
+			/**
+			 * record a top level cursor from filename, closing the span of the
+			 * previous header when the header changes
+			 */
+			void visit (const std::string &filename);
+
+			/**
+			 * close the span of the last visited header
+			 */
+			void endVisits ();
+
+			inline unsigned long long getThreshold() const { return threshold; }
+
+			/**
+			 * write the trace to file, returns false if it can't be written
+			 */
+			bool write (const std::string &file);
+
+		private:
+			std::chrono::steady_clock::time_point started;
+			unsigned long long threshold;
+			Json::Value events;
+			std::string visitFile;
+			unsigned long long visitStart;
+			unsigned visitCursors;
+	};
+
+	/**
+	 * records a span for the lifetime of the object, does nothing without a trace
+	 */
+	class TraceSpan {
+		public:
+			TraceSpan (Trace *trace, const std::string &name, const std::string &category = "phase");
+			~TraceSpan ();
+		private:
+			Trace *trace;
+			std::string name;
+			std::string category;
+			unsigned long long start;
+	};
+}
+
+#endif
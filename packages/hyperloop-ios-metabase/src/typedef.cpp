@@ -30,13 +30,13 @@ namespace hyperloop {
 		Json::Value kv;
 		toJSONBase(kv);
 		kv.removeMember("name");
-		kv["type"] = type->getType();
-		kv["value"] = type->getValue();
+		kv[keys::type] = type->getType();
+		kv[keys::value] = type->getValue();
 
 		if (encodingNeedsResolving(this->type->getEncoding())) {
-			kv["encoding"] = CXTypeUnknownToEncoding(this->context, type);
+			kv[keys::encoding] = CXTypeUnknownToEncoding(this->context, type);
 		} else {
-			kv["encoding"] = this->type->getEncoding();
+			kv[keys::encoding] = this->type->getEncoding();
 		}
 
 		return kv;
@@ -70,7 +70,7 @@ namespace hyperloop {
 							context->getParserTree()->addStruct(sd);
 						}
 						else {
-							std::cerr << "Not sure what the typedef record reference type is: " << p->toJSON() << std::endl;
+							context->diagnose("typedef.record", "unknown record reference type: " + typeSpelling + " (" + p->getKind() + ")");
 						}
 					}
 				}
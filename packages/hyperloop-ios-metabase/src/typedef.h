@@ -11,11 +11,12 @@ namespace hyperloop {
 	/**
 	 * Typedef definition
 	 */
-	class TypeDefinition : public Definition {
+	class TypeDefinition : public Definition, private Counted<TypeDefinition> {
 	public:
 		TypeDefinition (CXCursor cursor, const std::string &name, ParserContext *ctx);
 		~TypeDefinition ();
 		Json::Value toJSON () const;
+		inline const char* getKind () const { return "typedef"; }
 		void setType(hyperloop::Type *type);
 		Type* getType() { return type; }
 	private:
@@ -17,7 +17,7 @@ namespace hyperloop {
 		switch (kind) {
 			case CXCursor_FieldDecl: {
 				auto type = new Type(cursor, unionDef->getContext());
-				unionDef->addField(displayName, type);
+				unionDef->addField(cursor, displayName, type);
 				addBlockIfFound(unionDef, cursor, parent);
 				break;
 			}
@@ -40,7 +40,7 @@ namespace hyperloop {
 	}
 
 	UnionDefinition::UnionDefinition (CXCursor cursor, const std::string &name, ParserContext *ctx) :
-		Definition(cursor, name, ctx) {
+		Definition(cursor, name, ctx), size(-1), alignment(-1) {
 	}
 
 	UnionDefinition::~UnionDefinition () {
@@ -52,6 +52,10 @@ namespace hyperloop {
 	Json::Value UnionDefinition::toJSON () const {
 		Json::Value kv;
 		toJSONBase(kv);
+		if (size >= 0 && alignment >= 0) {
+			kv[keys::size] = static_cast<Json::UInt64>(size);
+			kv[keys::alignment] = static_cast<Json::UInt64>(alignment);
+		}
 		if (fields.size() > 0) {
 			Json::Value fkv;
 			for (std::vector<Argument *>::const_iterator it = fields.begin(); it != fields.end(); it++) {
@@ -59,7 +63,7 @@ namespace hyperloop {
 				v.removeMember("value");
 				fkv.append(v);
 			}
-			kv["fields"] = fkv;
+			kv[keys::fields] = fkv;
 		}
 		return kv;
 	}
@@ -69,8 +73,8 @@ namespace hyperloop {
 		return "?";
 	}
 
-	void UnionDefinition::addField (const std::string &name, Type *type) {
-		auto arg = new Argument(name, type);
+	void UnionDefinition::addField (CXCursor cursor, const std::string &name, Type *type) {
+		auto arg = new Field(cursor, name, type, this->getContext());
 		fields.push_back(arg);
 	}
 
@@ -82,6 +86,9 @@ namespace hyperloop {
 		auto kind = clang_getCursorKind(cursor);
 		if (!clang_isUnexposed(kind)) {
 			context->getParserTree()->addUnion(this);
+			auto recordType = clang_getCursorType(cursor);
+			this->size = clang_Type_getSizeOf(recordType);
+			this->alignment = clang_Type_getAlignOf(recordType);
 			clang_visitChildren(cursor, parseUnionMember, this);
 		}
 		return CXChildVisit_Continue;
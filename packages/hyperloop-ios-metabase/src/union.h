@@ -10,16 +10,20 @@
 
 namespace hyperloop {
 
-	class UnionDefinition : public Definition {
+	class UnionDefinition : public Definition, private Counted<UnionDefinition> {
 	public:
 		UnionDefinition (CXCursor cursor, const std::string &name, ParserContext *ctx);
 		~UnionDefinition();
 		Json::Value toJSON () const;
-		void addField (const std::string &name, Type *type);
+		inline const char* getKind () const { return "union"; }
+		void addField (CXCursor cursor, const std::string &name, Type *type);
 		std::vector<Argument *> getFields();
 		std::string getEncoding();
 	private:
 		std::vector<Argument *> fields;
+		// in bytes as laid out by clang, negative if the type is incomplete
+		long long size;
+		long long alignment;
 		CXChildVisitResult executeParse(CXCursor cursor, ParserContext *context);
 	};
 }
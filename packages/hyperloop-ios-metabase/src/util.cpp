@@ -6,6 +6,7 @@
 #include <string>
 #include <algorithm>
 #include <regex>
+#include <sys/stat.h>
 #include "util.h"
 #include "def.h"
 #include "parser.h"
@@ -14,6 +15,7 @@
 #include "typedef.h"
 #include "enum.h"
 #include "block.h"
+#include "encoding.h"
 
 namespace hyperloop {
 	/**
@@ -172,50 +174,7 @@ namespace hyperloop {
 	}
 
 	std::string getEncodingFromType (const std::string &str) {
-		if (str == "char" || str == "char16" || str == "char32" || str == "s_char" || str == "char_s") {
-			return "c";
-		} else if (str == "int") {
-			return "i";
-		} else if (str == "short") {
-			return "s";
-		} else if (str == "long") {
-			return "l";
-		} else if (str == "long_long" || str == "long long") {
-			return "q";
-		} else if (str == "char_u" || str == "uchar" || str == "unsigned char") {
-			return "C";
-		} else if (str == "uint" || str == "unsigned int") {
-			return "I";
-		} else if (str == "ushort" || str == "unsigned short") {
-			return "S";
-		} else if (str == "ulong" || str == "unsigned long") {
-			return "L";
-		} else if (str == "long_double" || str == "long double") {
-			return "D";
-		} else if (str == "ulonglong" || str == "unsigned long long") {
-			return "Q";
-		} else if (str == "float") {
-			return "f";
-		} else if (str == "double") {
-			return "d";
-		} else if (str == "bool" || str == "_Bool") {
-			return "B";
-		} else if (str == "void") {
-			return "v";
-		} else if (str == "char *") {
-			return "*";
-		} else if (str == "obj_interface" || str == "id" || str == "objc_pointer") {
-			return "@";
-		} else if (str == "enum") {
-			return "i";
-		} else if (str == "Class") {
-			return "#";
-		} else if (str == "SEL") {
-			return ":";
-		} else if (str == "block") {
-			return "@?";
-		}
-		return "?";
+		return encodingOf(primitiveForType(str));
 	}
 
 	/**
@@ -227,47 +186,15 @@ namespace hyperloop {
 		if (str.empty() && value.empty()) {
 			return "?";
 		}
-		if (str == "char" || str == "char16" || str == "char32" || str == "s_char" || str == "char_s") {
-			return "c";
-		} else if (str == "int") {
-			return "i";
-		} else if (str == "short") {
-			return "s";
-		} else if (str == "long") {
-			return "l";
-		} else if (str == "long_long" || str == "long long") {
-			return "q";
-		} else if (str == "char_u" || str == "uchar" || str == "unsigned char") {
-			return "C";
-		} else if (str == "uint" || str == "unsigned int") {
-			return "I";
-		} else if (str == "ushort" || str == "unsigned short") {
-			return "S";
-		} else if (str == "ulong" || str == "unsigned long") {
-			return "L";
-		} else if (str == "long_double" || str == "long double") {
-			return "D";
-		} else if (str == "ulonglong" || str == "unsigned long long") {
-			return "Q";
-		} else if (str == "float") {
-			return "f";
-		} else if (str == "double") {
-			return "d";
-		} else if (str == "bool" || str == "_Bool") {
-			return "B";
-		} else if (str == "void") {
-			return "v";
-		} else if (str == "char *") {
-			return "*";
-		} else if (str == "obj_interface" || str == "id" || value == "id" || str == "objc_pointer") {
+		// a block still goes through the function pointer checks on its value below
+		auto primitive = primitiveForType(str);
+		if (primitive != Primitive::None && primitive != Primitive::Block) {
+			return encodingOf(primitive);
+		}
+		if (value == "id") {
 			return "@";
-		} else if (str == "enum") {
-			return "i";
-		} else if (str == "Class") {
-			return "#";
-		} else if (str == "SEL") {
-			return ":";
-		} else if (value.find("(*)") != std::string::npos) {
+		}
+		if (value.find("(*)") != std::string::npos) {
 			return "^?";
 		} else if (value.find("(**)") != std::string::npos) {
 			return "^^?";
@@ -395,7 +322,7 @@ namespace hyperloop {
 			std::string s = replace(value, "_Complex", "");
 			return getEncodingFromType(s);
 		}
-		std::cerr << "don't know how to encode: " << str << " (" << value << ")" << std::endl;
+		context->diagnose("encoding.unknown", "don't know how to encode: " + str + " (" + value + ")");
 		return "?";
 	}
 
@@ -415,46 +342,9 @@ namespace hyperloop {
 			return "unknown";
 		}
 		std::string encoding = filterEncoding(encoding_);
-		if (encoding == "i") {
-			return "int";
-		} else if (encoding == "l") {
-			return "long";
-		} else if (encoding == "c") {
-			return "c";
-		} else if (encoding == "d") {
-			return "double";
-		} else if (encoding == "f") {
-			return "float";
-		} else if (encoding == "s") {
-			return "short";
-		} else if (encoding == "q") {
-			return "long long";
-		} else if (encoding == "C") {
-			return "unsigned char";
-		} else if (encoding == "I") {
-			return "unsigned int";
-		} else if (encoding == "S") {
-			return "unsigned short";
-		} else if (encoding == "L") {
-			return "unsigned long";
-		} else if (encoding == "S") {
-			return "unsigned short";
-		} else if (encoding == "Q") {
-			return "unsigned long long";
-		} else if (encoding == "B") {
-			return "bool";
-		} else if (encoding == "v") {
-			return "void";
-		} else if (encoding == "*") {
-			return "char *";
-		} else if (encoding == "@") {
-			return "id";
-		} else if (encoding == "#") {
-			return "Class";
-		} else if (encoding == ":") {
-			return "SEL";
-		} else if (encoding == "@?") {
-			return "block";
+		auto primitive = primitiveForEncoding(encoding);
+		if (primitive != Primitive::None) {
+			return typeOf(primitive);
 		}
 		char ch = encoding.at(0);
 		switch (ch) {
@@ -675,6 +565,34 @@ namespace hyperloop {
 		return encoding;
 	}
 
+	std::pair<std::string, std::string> typedefToEncoding (ParserTree *tree, TypeDefinition *def) {
+		auto type = def->getType();
+		auto typestr = type->getType();
+		auto valstr = type->getValue();
+//		std::cout << "found typedef: " << def->getName() << ", type: " << typestr << ", value: " << type->getValue() << std::endl;
+		if (typestr == "enum") {
+			auto pos = valstr.find("enum ");
+			if (pos == 0) {
+				valstr = valstr.substr(5);
+			}
+//			std::cout << "looking for enum [" << valstr << "]" << std::endl;
+			if (tree->hasEnum(valstr)) {
+				return std::make_pair(std::string("enum"), std::string("i"));
+			}
+		} else if (typestr == "record") {
+			// struct member
+			auto pos = valstr.find("struct ");
+			if (pos == 0) {
+				valstr = valstr.substr(7);
+			}
+//			std::cout << "looking for struct [" << valstr << "]" << std::endl;
+			if (tree->hasStruct(valstr)) {
+				return std::make_pair(std::string("struct"), tree->getStructEncoding(tree->getStruct(valstr)));
+			}
+		}
+		return std::make_pair(typestr, getEncodingFromType(typestr));
+	}
+
 	/**
 	 * resolve encoding into type
 	 */
@@ -746,7 +664,7 @@ namespace hyperloop {
 				valueString = valueString.replace(0, 7, "");
 			}
 			if (tree->hasStruct(valueString)) {
-				kv["encoding"] = structDefinitionToEncoding(tree->getStruct(valueString));
+				kv["encoding"] = tree->getStructEncoding(tree->getStruct(valueString));
 				kv[typeKey] = "struct";
 				return;
 			}
@@ -767,37 +685,9 @@ namespace hyperloop {
 		if (typeString == "typedef" || isTypeDef) {
 			if (tree->hasType(valueString)) {
 				// found the type definition, need to then resolve to root type
-				auto def = tree->getType(valueString);
-				auto type = def->getType();
-				auto typestr = type->getType();
-				auto valstr = type->getValue();
-//				std::cout << "found typedef: " << valueString << ", type: " << typestr << ", value: " << type->getValue() << std::endl;
-				if (typestr == "enum") {
-					auto pos = valstr.find("enum ");
-					if (pos == 0) {
-						valstr = valstr.substr(5);
-					}
-//					std::cout << "looking for enum [" << valstr << "]" << std::endl;
-					if (tree->hasEnum(valstr)) {
-						kv[typeKey] = "enum";
-						kv["encoding"] = "i";
-						return;
-					}
-				} else if (typestr == "record") {
-					// struct member
-					auto pos = valstr.find("struct ");
-					if (pos == 0) {
-						valstr = valstr.substr(7);
-					}
-//					std::cout << "looking for struct [" << valstr << "]" << std::endl;
-					if (tree->hasStruct(valstr)) {
-						kv[typeKey] = "struct";
-						kv["encoding"] = structDefinitionToEncoding(tree->getStruct(valstr));
-						return;
-					}
-				}
-				kv[typeKey] = typestr;
-				kv["encoding"] = getEncodingFromType(typestr);
+				auto resolved = tree->getTypedefEncoding(tree->getType(valueString));
+				kv[typeKey] = resolved.first;
+				kv["encoding"] = resolved.second;
 				return;
 			}
 			if (valueString == "instancetype") {
@@ -805,7 +695,7 @@ namespace hyperloop {
 				kv["encoding"] = "@";
 				return;
 			}
-			std::cerr << "Not sure how to handle typedef: " << typeString << " = " << valueString << std::endl;
+			tree->getContext()->diagnose("typedef.unresolved", "not sure how to handle typedef: " + typeString + " = " + valueString);
 		}
 
 		if (encodingNeedsResolving(encoding)) {
@@ -849,6 +739,60 @@ namespace hyperloop {
 		map["line"] = hyperloop::toString(line);
 	}
 
+	std::string unquote (std::string path) {
+		if (path.at(0) == (int)'"') {
+			path = path.substr(1);
+		}
+		if (path.at(path.length() - 1) == (int)'"') {
+			path = path.substr(0, path.length() - 1);
+		}
+		return path;
+	}
+
+	std::vector<std::string> compilerArguments (const std::string &header, const std::string &sdkPath, const std::string &minVersion, const std::vector<std::string> &includes, const std::vector<std::string> &frameworks, const std::string &moduleCache) {
+		std::vector<std::string> args;
+		args.push_back("-x");
+		args.push_back("objective-c");
+		args.push_back("-mios-simulator-version-min=" + minVersion);
+		args.push_back("-O0");
+		args.push_back("-g");
+		args.push_back("-fobjc-abi-version=2");
+		args.push_back("-fobjc-legacy-dispatch");
+		args.push_back("-fpascal-strings");
+		args.push_back("-fexceptions");
+		args.push_back("-fasm-blocks");
+		args.push_back("-fstrict-aliasing");
+		args.push_back("-fmessage-length=0");
+		args.push_back("-fdiagnostics-show-note-include-stack");
+		args.push_back("-fmacro-backtrace-limit=0");
+		if (!moduleCache.empty()) {
+			args.push_back("-fmodules");
+			args.push_back("-fmodules-cache-path=" + unquote(moduleCache));
+		}
+		for (auto it = includes.begin(); it != includes.end(); it++) {
+			args.push_back("-I");
+			args.push_back(unquote(*it));
+		}
+		for (auto it = frameworks.begin(); it != frameworks.end(); it++) {
+			args.push_back("-F");
+			args.push_back(unquote(*it));
+		}
+		args.push_back("-isysroot");
+		args.push_back(sdkPath);
+		args.push_back(header);
+		return args;
+	}
+
+	std::string getFrameworkName (const std::string &filename) {
+		size_t frameworkPosition = filename.find(".framework");
+		if (frameworkPosition != std::string::npos) {
+			size_t slashBeforeFrameworkPosition = filename.find_last_of("/", frameworkPosition);
+			return filename.substr(slashBeforeFrameworkPosition + 1, frameworkPosition - (slashBeforeFrameworkPosition + 1));
+		}
+
+		return filename;
+	}
+
 	/**
 	 * add a block if found as a type
 	 */
@@ -940,6 +884,99 @@ namespace hyperloop {
 		return available;
 	}
 
+	Availability getAvailability (CXCursor cursor) {
+		Availability result;
+		CXPlatformAvailability availability[10];
+		int always_deprecated, always_unavailable;
+		CXString deprecated_message, unavailable_message;
+		int size = clang_getCursorPlatformAvailability(
+			cursor,
+			&always_deprecated,
+			&deprecated_message,
+			&always_unavailable,
+			&unavailable_message,
+			(CXPlatformAvailability *)&availability,
+			10
+		);
+		if (always_deprecated) {
+			result.deprecated.Major = result.deprecated.Minor = result.deprecated.Subminor = 0;
+			result.message = CXStringToString(deprecated_message);
+		} else {
+			clang_disposeString(deprecated_message);
+		}
+		if (always_unavailable) {
+			result.unavailable = true;
+			result.message = CXStringToString(unavailable_message);
+		} else {
+			clang_disposeString(unavailable_message);
+		}
+		for (int i = 0; i < size; i++) {
+			// We only care for ios, so skip platform if it's anything else
+			std::string platformName = clang_getCString(availability[i].Platform);
+			if (platformName.compare("ios") != 0) {
+				continue;
+			}
+			result.introduced = availability[i].Introduced;
+			result.deprecated = availability[i].Deprecated;
+			result.obsoleted = availability[i].Obsoleted;
+			if (availability[i].Unavailable) {
+				result.unavailable = true;
+			}
+			auto message = clang_getCString(availability[i].Message);
+			if (message && *message) {
+				result.message = message;
+			}
+		}
+		if (size > 0) {
+			clang_disposeCXPlatformAvailability(availability);
+		}
+		return result;
+	}
+
+	CXVersion parseVersion (const std::string &version) {
+		CXVersion result;
+		result.Major = result.Minor = result.Subminor = 0;
+		auto parts = tokenize(version, ".");
+		if (parts.size() > 0) {
+			result.Major = atoi(parts[0].c_str());
+		}
+		if (parts.size() > 1) {
+			result.Minor = atoi(parts[1].c_str());
+		}
+		if (parts.size() > 2) {
+			result.Subminor = atoi(parts[2].c_str());
+		}
+		return result;
+	}
+
+	int compareVersions (const CXVersion &a, const CXVersion &b) {
+		int left[] = { a.Major, a.Minor, a.Subminor };
+		int right[] = { b.Major, b.Minor, b.Subminor };
+		for (int i = 0; i < 3; i++) {
+			auto l = left[i] < 0 ? 0 : left[i];
+			auto r = right[i] < 0 ? 0 : right[i];
+			if (l != r) {
+				return l < r ? -1 : 1;
+			}
+		}
+		return 0;
+	}
+
+	bool statFile (const std::string &path, long long &size, long long &modified) {
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0) {
+			return false;
+		}
+#ifdef __APPLE__
+		auto &mtime = st.st_mtimespec;
+#else
+		auto &mtime = st.st_mtim;
+#endif
+		size = static_cast<long long>(st.st_size);
+		modified = static_cast<long long>(mtime.tv_sec) * 1000000000LL + static_cast<long long>(mtime.tv_nsec);
+		return true;
+	}
+
 	bool isBlock(const CXCursor &cursor) {
 		auto cursorType = resolveCursorType(cursor);
 		return cursorType.kind == CXType_BlockPointer;
@@ -972,9 +1009,9 @@ namespace hyperloop {
 		auto returnString = signature.substr(0, signature.find("(^)("));
 		returnString = stripTemplateArgs(trim(returnString));
 		Json::Value returns;
-		returns["type"] = Json::Value("unexposed");
-		returns["encoding"] = Json::Value(getEncodingFromType(returnString));
-		returns["value"] = Json::Value(returnString);
+		returns[keys::type] = Json::Value("unexposed");
+		returns[keys::encoding] = Json::Value(getEncodingFromType(returnString));
+		returns[keys::value] = Json::Value(returnString);
 		resolveEncoding(tree, returns);
 		return returns;
 	}
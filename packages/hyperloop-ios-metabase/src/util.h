@@ -10,17 +10,59 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <utility>
 
 #include "clang-c/Index.h"
 #include "json/json.h"
+#include "profiler.h"
 
 namespace hyperloop {
 	class ParserTree;
 	class ParserContext;
 	class Type;
 	class StructDefinition;
+	class TypeDefinition;
 	class Definition;
 	class BlockDefinition;
+	struct Availability;
+
+	/**
+	 * member names written by the toJSON methods. Json::Value stores keys
+	 * given as a Json::StaticString by pointer instead of copying them into
+	 * every object, which adds up over tens of thousands of definitions
+	 */
+	namespace keys {
+		static const Json::StaticString name("name");
+		static const Json::StaticString type("type");
+		static const Json::StaticString value("value");
+		static const Json::StaticString encoding("encoding");
+		static const Json::StaticString framework("framework");
+		static const Json::StaticString thirdparty("thirdparty");
+		static const Json::StaticString filename("filename");
+		static const Json::StaticString line("line");
+		static const Json::StaticString introducedIn("introducedIn");
+		static const Json::StaticString selector("selector");
+		static const Json::StaticString returns("returns");
+		static const Json::StaticString arguments("arguments");
+		static const Json::StaticString instance("instance");
+		static const Json::StaticString optional("optional");
+		static const Json::StaticString constructor("constructor");
+		static const Json::StaticString attributes("attributes");
+		static const Json::StaticString fields("fields");
+		static const Json::StaticString methods("methods");
+		static const Json::StaticString properties("properties");
+		static const Json::StaticString protocols("protocols");
+		static const Json::StaticString categories("categories");
+		static const Json::StaticString superclass("superclass");
+		static const Json::StaticString values("values");
+		static const Json::StaticString variadic("variadic");
+		static const Json::StaticString signature("signature");
+		static const Json::StaticString size("size");
+		static const Json::StaticString alignment("alignment");
+		static const Json::StaticString offset("offset");
+		static const Json::StaticString bitOffset("bitOffset");
+		static const Json::StaticString bitWidth("bitWidth");
+	}
 
 	/**
 	 * stringify an unsigned value
@@ -117,6 +159,12 @@ namespace hyperloop {
 	 */
 	std::string structDefinitionToEncoding (StructDefinition *def);
 
+	/**
+	 * the type and encoding a typedef resolves to, following it to an enum
+	 * or struct when it names one
+	 */
+	std::pair<std::string, std::string> typedefToEncoding (ParserTree *tree, TypeDefinition *def);
+
 	/**
 	 * return map as JSON string
 	 */
@@ -132,6 +180,24 @@ namespace hyperloop {
 	 */
 	void getSourceLocation (CXCursor cursor, const ParserContext *ctx, std::map<std::string, std::string> &map);
 
+	/**
+	 * a search path without the quotes around it
+	 */
+	std::string unquote (std::string path);
+
+	/**
+	 * the clang arguments parsing header against the simulator SDK at sdkPath
+	 * for minVersion, the search paths may be quoted. With a moduleCache,
+	 * imports of frameworks with a module map are loaded as clang modules
+	 * built into, and reused from, that directory
+	 */
+	std::vector<std::string> compilerArguments (const std::string &header, const std::string &sdkPath, const std::string &minVersion, const std::vector<std::string> &includes, const std::vector<std::string> &frameworks, const std::string &moduleCache = "");
+
+	/**
+	 * returns the framework a header belongs to, or the filename outside of a framework
+	 */
+	std::string getFrameworkName (const std::string &filename);
+
 	/**
 	 * add a block if found as a type
 	 */
@@ -142,6 +208,30 @@ namespace hyperloop {
 	 */
 	bool isAvailableInIos(CXCursor cursor);
 
+	/**
+	 * the iOS availability of the cursor, a deprecated attribute without a
+	 * platform counts as deprecated in every version
+	 */
+	Availability getAvailability (CXCursor cursor);
+
+	/**
+	 * parse a version like 9.0 or 10.3.1, missing parts are 0
+	 */
+	CXVersion parseVersion (const std::string &version);
+
+	/**
+	 * compare two versions treating parts that aren't given as 0, returns
+	 * less than, equal to or greater than 0 like strcmp
+	 */
+	int compareVersions (const CXVersion &a, const CXVersion &b);
+
+	/**
+	 * the size and modification time in nanoseconds of a file, returns false
+	 * if it can't be stat'd. Whole seconds would miss a save of the same size
+	 * within the second of the last check
+	 */
+	bool statFile (const std::string &path, long long &size, long long &modified);
+
 	/**
 	 * Returns true if the given cursor is a block pointer
 	 */
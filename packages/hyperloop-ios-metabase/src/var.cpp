@@ -23,9 +23,9 @@ namespace hyperloop {
 	Json::Value VarDefinition::toJSON () const {
 		Json::Value kv;
 		toJSONBase(kv);
-		kv["type"] = type->getType();
-		kv["value"] = type->getValue();
-		kv["encoding"] = type->getEncoding();
+		kv[keys::type] = type->getType();
+		kv[keys::value] = type->getValue();
+		kv[keys::encoding] = type->getEncoding();
 		return kv;
 	}
 
@@ -11,13 +11,14 @@ namespace hyperloop {
 	/**
 	 * Var definition
 	 */
-	class VarDefinition : public Definition {
+	class VarDefinition : public Definition, private Counted<VarDefinition> {
 	public:
 		VarDefinition (CXCursor cursor, const std::string &name, ParserContext *ctx);
 		~VarDefinition ();
 		void setType (Type *_type) { type = _type; }
 		const Type* getType() { return type; }
 		Json::Value toJSON () const;
+		inline const char* getKind () const { return "var"; }
 	private:
 		Type *type;
 		CXChildVisitResult executeParse(CXCursor cursor, ParserContext *context);
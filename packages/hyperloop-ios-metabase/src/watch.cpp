@@ -0,0 +1,329 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+#include "watch.h"
+#include "diagnostics.h"
+#include "index.h"
+#include "parser.h"
+#include "schema.h"
+#include "util.h"
+#include "writer.h"
+#include "json/json.h"
+
+namespace hyperloop {
+
+	static double millisSince (std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	static std::string resolvePath (const std::string &path) {
+		char resolved[PATH_MAX];
+		return realpath(path.c_str(), resolved) ? std::string(resolved) : path;
+	}
+
+	static std::string parentDir (const std::string &path) {
+		auto slash = path.find_last_of('/');
+		return slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+	}
+
+	FileWatcher::FileWatcher () : fd(-1) {
+#ifdef __linux__
+		fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+	}
+
+	FileWatcher::~FileWatcher () {
+		if (fd >= 0) {
+			close(fd);
+		}
+	}
+
+	void FileWatcher::watch (const std::set<std::string> &_files, const std::set<std::string> &_dirs) {
+		files.clear();
+		dirs.clear();
+		stamps.clear();
+		for (auto it = _files.begin(); it != _files.end(); it++) {
+			files.insert(resolvePath(*it));
+		}
+		for (auto it = _dirs.begin(); it != _dirs.end(); it++) {
+			dirs.insert(resolvePath(*it));
+		}
+		std::set<std::string> watched(dirs);
+		for (auto it = files.begin(); it != files.end(); it++) {
+			watched.insert(parentDir(*it));
+		}
+#ifdef __linux__
+		// a directory watched already keeps its descriptor, so the events
+		// queued while the translation unit was parsed aren't lost
+		std::map<int, std::string> kept;
+		for (auto it = watched.begin(); it != watched.end() && fd >= 0; it++) {
+			auto wd = inotify_add_watch(fd, it->c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE);
+			if (wd < 0) {
+				// past the limit of watches, poll instead
+				close(fd);
+				fd = -1;
+				kept.clear();
+			} else {
+				kept[wd] = *it;
+			}
+		}
+		for (auto it = watches.begin(); it != watches.end() && fd >= 0; it++) {
+			if (!kept.count(it->first)) {
+				inotify_rm_watch(fd, it->first);
+			}
+		}
+		watches.swap(kept);
+#endif
+		if (fd < 0) {
+			std::set<std::string> paths;
+			poll(paths);
+		}
+	}
+
+	/**
+	 * poll the size and modification time of what is watched, returns true
+	 * if any of them changed since the last poll
+	 */
+	bool FileWatcher::poll (std::set<std::string> &paths) {
+		bool found = false;
+		std::vector<const std::set<std::string> *> sets = { &files, &dirs };
+		for (auto set : sets) {
+			for (auto it = set->begin(); it != set->end(); it++) {
+				auto stamp = std::make_pair(-1LL, -1LL);
+				statFile(*it, stamp.first, stamp.second);
+				auto previous = stamps.find(*it);
+				if (previous != stamps.end() && previous->second != stamp) {
+					paths.insert(*it);
+					found = true;
+				}
+				stamps[*it] = stamp;
+			}
+		}
+		return found;
+	}
+
+	/**
+	 * collect the changes seen within timeout milliseconds, or until one is
+	 * seen if timeout is negative. Returns true if there were any
+	 */
+	bool FileWatcher::changed (std::set<std::string> &paths, int timeout) {
+		auto start = std::chrono::steady_clock::now();
+		bool found = false;
+		while (!found && (timeout < 0 || millisSince(start) < timeout)) {
+#ifdef __linux__
+			if (fd >= 0) {
+				struct pollfd pfd = { fd, POLLIN, 0 };
+				auto left = timeout < 0 ? -1 : static_cast<int>(timeout - millisSince(start));
+				if (::poll(&pfd, 1, timeout < 0 ? -1 : (left < 0 ? 0 : left)) <= 0) {
+					continue;
+				}
+				char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+				ssize_t length;
+				while ((length = read(fd, buf, sizeof(buf))) > 0) {
+					for (char *ptr = buf; ptr < buf + length; ptr += sizeof(struct inotify_event) + reinterpret_cast<struct inotify_event *>(ptr)->len) {
+						auto event = reinterpret_cast<struct inotify_event *>(ptr);
+						auto dir = watches.find(event->wd);
+						if (dir == watches.end() || event->len == 0) {
+							continue;
+						}
+						auto path = (dir->second == "/" ? "" : dir->second) + "/" + event->name;
+						// a header of the translation unit, or an entry added to or
+						// removed from a search path, not files written there
+						if (files.count(path) || (dirs.count(dir->second) && !(event->mask & IN_CLOSE_WRITE))) {
+							paths.insert(files.count(path) ? path : dir->second);
+							found = true;
+						}
+					}
+				}
+				continue;
+			}
+#endif
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			found = poll(paths);
+		}
+		return found;
+	}
+
+	std::set<std::string> FileWatcher::wait (unsigned debounce) {
+		std::set<std::string> paths;
+		changed(paths, -1);
+		// a save is often a burst of events, wait for it to settle
+		bool settled = false;
+		while (!settled) {
+			settled = !changed(paths, static_cast<int>(debounce));
+		}
+		return paths;
+	}
+
+	static void visitInclusion (CXFile file, CXSourceLocation *stack, unsigned depth, CXClientData clientData) {
+		static_cast<std::set<std::string> *>(clientData)->insert(CXStringToString(clang_getFileName(file)));
+	}
+
+	/**
+	 * the names of the definitions added, changed and removed in each section
+	 * from one metabase to the next
+	 */
+	static Json::Value delta (const Json::Value &before, const Json::Value &after) {
+		Json::Value kv(Json::objectValue);
+		const char *kinds[] = { "added", "changed", "removed" };
+		for (auto kind : kinds) {
+			kv[kind] = Json::Value(Json::objectValue);
+		}
+		std::set<std::string> sections;
+		auto names = before.getMemberNames();
+		sections.insert(names.begin(), names.end());
+		names = after.getMemberNames();
+		sections.insert(names.begin(), names.end());
+		sections.erase("metadata");
+		for (auto it = sections.begin(); it != sections.end(); it++) {
+			auto &from = before[*it];
+			auto &to = after[*it];
+			auto fromNames = from.isObject() ? from.getMemberNames() : std::vector<std::string>();
+			auto toNames = to.isObject() ? to.getMemberNames() : std::vector<std::string>();
+			for (auto nit = toNames.begin(); nit != toNames.end(); nit++) {
+				if (!from.isObject() || !from.isMember(*nit)) {
+					kv["added"][*it].append(*nit);
+				} else if (from[*nit] != to[*nit]) {
+					kv["changed"][*it].append(*nit);
+				}
+			}
+			for (auto nit = fromNames.begin(); nit != fromNames.end(); nit++) {
+				if (!to.isObject() || !to.isMember(*nit)) {
+					kv["removed"][*it].append(*nit);
+				}
+			}
+		}
+		return kv;
+	}
+
+	static bool writeMetabase (const std::string &output, const Json::Value &json, bool pretty, bool writeIndex) {
+		std::ofstream out(output);
+		if (out.fail()) {
+			std::cerr << "open failed for file: " << output << std::endl;
+			return false;
+		}
+		MetabaseWriter writer(out, pretty);
+		writer.write(json);
+		out << std::endl;
+		out.close();
+		if (out.fail()) {
+			std::cerr << "couldn't write file: " << output << std::endl;
+			return false;
+		}
+		if (writeIndex && !MetabaseIndex::write(output, writer.getEntries())) {
+			std::cerr << "couldn't write index for file: " << output << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	int watch (std::map<std::string, std::string> &arguments) {
+		if (!arguments.count("-o") || arguments.count("-shards")) {
+			std::cerr << "watch writes one metabase, use -o <file>" << std::endl;
+			return EXIT_FAILURE;
+		}
+		auto output = arguments["-o"];
+		auto header = arguments["-i"];
+		auto sdkPath = arguments["-sim-sdk-path"];
+		auto minVersion = arguments["-min-ios-ver"];
+		trim(minVersion);
+		if (minVersion.find(',') != std::string::npos) {
+			std::cerr << "watch writes one minimum iOS version" << std::endl;
+			return EXIT_FAILURE;
+		}
+		auto schema = arguments.count("-schema") ? arguments["-schema"] : "1";
+		auto excludeSys = arguments.count("-x") > 0;
+		auto pretty = arguments.count("-pretty") > 0;
+		auto writeIndex = arguments.count("-index") > 0;
+		auto threads = arguments.count("-threads") ? atoi(arguments["-threads"].c_str()) : static_cast<int>(defaultThreads());
+		auto debounce = arguments.count("-debounce") ? atoi(arguments["-debounce"].c_str()) : 100;
+		auto includes = tokenize(arguments["-hsp"], ",");
+		auto frameworks = tokenize(arguments["-fsp"], ",");
+		auto moduleCache = arguments.count("-modules") ? arguments["-modules"] : "";
+		std::set<std::string> searchPaths;
+		for (auto it = includes.begin(); it != includes.end(); it++) {
+			searchPaths.insert(unquote(*it));
+		}
+		for (auto it = frameworks.begin(); it != frameworks.end(); it++) {
+			searchPaths.insert(unquote(*it));
+		}
+
+		auto compilerArgs = compilerArguments(header, sdkPath, minVersion, includes, frameworks, moduleCache);
+		std::vector<const char *> args;
+		for (auto it = compilerArgs.begin(); it != compilerArgs.end(); it++) {
+			args.push_back(it->c_str());
+		}
+		// declarations of the preamble are only visited if not excluded
+		auto index = clang_createIndex(0, 0);
+		CXTranslationUnit tu = nullptr;
+		FileWatcher watcher;
+		Json::Value previous;
+		Json::StreamWriterBuilder builder;
+		builder.settings_["indentation"] = "";
+		for (unsigned generation = 0;; generation++) {
+			auto start = std::chrono::steady_clock::now();
+			bool reparsed = tu && clang_reparseTranslationUnit(tu, 0, nullptr, clang_defaultReparseOptions(tu)) == 0;
+			if (!reparsed) {
+				if (tu) {
+					clang_disposeTranslationUnit(tu);
+				}
+				tu = clang_parseTranslationUnit(index, nullptr, &args[0], (int)args.size(), nullptr, 0, CXTranslationUnit_PrecompiledPreamble | CXTranslationUnit_CreatePreambleOnFirstParse);
+				if (!tu) {
+					std::cerr << "couldn't parse header: " << header << std::endl;
+					clang_disposeIndex(index);
+					return EXIT_FAILURE;
+				}
+			}
+			Diagnostics diagnostics;
+			diagnostics.addTranslationUnit(tu);
+			std::set<std::string> included;
+			clang_getInclusions(tu, visitInclusion, &included);
+			Json::Value json;
+			{
+				std::unique_ptr<ParserContext> ctx(parse(tu, sdkPath, minVersion, excludeSys, nullptr, nullptr, nullptr, &diagnostics));
+				ctx->setThreads(threads < 1 ? 1 : threads);
+				json = ctx->getParserTree()->toJSON(schema, minVersion);
+			}
+
+			// compared in the expanded layout, so a change in a shared table
+			// shows as the definitions using it
+			Json::Value expanded(json);
+			if (schema != "1") {
+				expandSchema(expanded);
+			}
+			Json::Value kv = generation == 0 ? Json::Value(Json::objectValue) : delta(previous, expanded);
+			auto changed = generation == 0 || kv["added"].size() + kv["changed"].size() + kv["removed"].size() > 0;
+			if (changed && !writeMetabase(output, json, pretty, writeIndex)) {
+				clang_disposeTranslationUnit(tu);
+				clang_disposeIndex(index);
+				return EXIT_FAILURE;
+			}
+			previous.swap(expanded);
+			kv["generation"] = generation;
+			kv["output"] = output;
+			kv["written"] = changed;
+			kv["reparsed"] = reparsed;
+			kv["parse"] = millisSince(start);
+			kv["diagnostics"] = static_cast<Json::UInt64>(diagnostics.getCount());
+			// one line per generation, flushed so the client can read it right away
+			std::cout << Json::writeString(builder, kv) << std::endl;
+
+			watcher.watch(included, searchPaths);
+			watcher.wait(debounce < 0 ? 0 : static_cast<unsigned>(debounce));
+		}
+	}
+}
@@ -0,0 +1,61 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_WATCH_H
+#define HYPERLOOP_WATCH_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+namespace hyperloop {
+
+	/**
+	 * Waits for changes to a set of files and directories. On Linux the
+	 * directories holding them are watched with inotify, so saves that
+	 * replace a file are seen too, elsewhere or if inotify fails their size
+	 * and modification time are polled.
+	 */
+	class FileWatcher {
+		public:
+			FileWatcher ();
+			~FileWatcher ();
+
+			/**
+			 * watch files for changes, and dirs for files added to or removed
+			 * from them, instead of what was watched before
+			 */
+			void watch (const std::set<std::string> &files, const std::set<std::string> &dirs);
+
+			/**
+			 * block until something watched changes, then until nothing more
+			 * changed for debounce milliseconds. Returns what changed
+			 */
+			std::set<std::string> wait (unsigned debounce);
+
+		private:
+			int fd;
+			std::map<int, std::string> watches;
+			std::set<std::string> files;
+			std::set<std::string> dirs;
+			std::map<std::string, std::pair<long long, long long>> stamps;
+
+			bool changed (std::set<std::string> &paths, int timeout);
+			bool poll (std::set<std::string> &paths);
+	};
+
+	/**
+	 * generate the metabase like the generator does, then keep the translation
+	 * unit and generate it again whenever one of the headers it included, or
+	 * a search path, changes. The translation unit is reparsed with a
+	 * precompiled preamble, the metabase is only written again if it changed,
+	 * and a line of JSON listing the definitions added, changed and removed is
+	 * printed for each generation. Runs until killed, returns the process
+	 * exit code if it can't start
+	 */
+	int watch (std::map<std::string, std::string> &arguments);
+}
+
+#endif
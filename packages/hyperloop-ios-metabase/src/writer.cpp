@@ -0,0 +1,101 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#include <sstream>
+#include "writer.h"
+
+namespace hyperloop {
+
+	MetabaseWriter::MetabaseWriter (std::ostream &_out, bool _pretty) : out(_out), pretty(_pretty), position(0) {
+		Json::StreamWriterBuilder builder;
+		if (pretty) {
+			builder.settings_["commentStyle"] = "None";
+			builder.settings_["indentation"] = "\t";
+		} else {
+			builder.settings_["indentation"] = "";
+		}
+		writer.reset(builder.newStreamWriter());
+	}
+
+	void MetabaseWriter::emit (const std::string &str) {
+		out << str;
+		position += str.size();
+	}
+
+	/**
+	 * serialize a value as it would appear nested at indent. the styled writer
+	 * starts multiline objects and arrays on their own line, that line break is
+	 * emitted here so the recorded offset points at the value itself
+	 */
+	std::string MetabaseWriter::fragment (const Json::Value &value, const std::string &indent) {
+		std::ostringstream buffer;
+		writer->write(value, &buffer);
+		auto str = buffer.str();
+		if (!pretty || indent.empty()) {
+			return str;
+		}
+		if (str.size() > 1 && (str[0] == '{' || str[0] == '[') && str[1] == '\n') {
+			emit("\n" + indent);
+		}
+		std::string indented;
+		indented.reserve(str.size() + str.size() / 8);
+		for (auto c : str) {
+			indented += c;
+			if (c == '\n') {
+				indented += indent;
+			}
+		}
+		return indented;
+	}
+
+	void MetabaseWriter::write (const Json::Value &root) {
+		// mirrors the layout of the jsoncpp styled writer: sections are the
+		// members of the root object and symbols the members of each section
+		const std::string separator = pretty ? " : " : ":";
+		if (!root.isObject() || root.empty()) {
+			emit(fragment(root, ""));
+			return;
+		}
+		emit("{");
+		for (auto section = root.begin(); section != root.end(); section++) {
+			if (section != root.begin()) {
+				emit(",");
+			}
+			auto sectionName = section.name();
+			emit(pretty ? "\n\t" : "");
+			emit(Json::valueToQuotedString(sectionName.c_str()) + separator);
+			if (!section->isObject() || section->empty()) {
+				auto str = fragment(*section, "\t");
+				if (section->isArray()) {
+					IndexEntry entry;
+					entry.section = sectionName;
+					entry.offset = position;
+					entry.length = str.size();
+					entries.push_back(entry);
+				}
+				emit(str);
+				continue;
+			}
+			emit(pretty ? "\n\t{" : "{");
+			for (auto symbol = section->begin(); symbol != section->end(); symbol++) {
+				if (symbol != section->begin()) {
+					emit(",");
+				}
+				auto name = symbol.name();
+				emit(pretty ? "\n\t\t" : "");
+				emit(Json::valueToQuotedString(name.c_str()) + separator);
+				auto str = fragment(*symbol, "\t\t");
+				IndexEntry entry;
+				entry.section = sectionName;
+				entry.name = name;
+				entry.offset = position;
+				entry.length = str.size();
+				emit(str);
+				entries.push_back(entry);
+			}
+			emit(pretty ? "\n\t}" : "}");
+		}
+		emit(pretty ? "\n}" : "}");
+	}
+}
@@ -0,0 +1,54 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+#ifndef HYPERLOOP_WRITER_H
+#define HYPERLOOP_WRITER_H
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "json/json.h"
+#include "index.h"
+
+namespace hyperloop {
+
+	/**
+	 * Writes a metabase one symbol at a time, producing the same bytes as
+	 * Json::writeString with the compact or -pretty settings while recording
+	 * where each section/symbol fragment lands in the output.
+	 */
+	class MetabaseWriter {
+		public:
+			MetabaseWriter (std::ostream &out, bool pretty);
+
+			/**
+			 * write the metabase root object
+			 */
+			void write (const Json::Value &root);
+
+			/**
+			 * returns the byte range of every symbol written so far
+			 */
+			inline std::vector<IndexEntry>& getEntries() { return entries; }
+
+			/**
+			 * returns the number of bytes written so far
+			 */
+			inline size_t getBytesWritten() const { return position; }
+
+		private:
+			std::ostream &out;
+			bool pretty;
+			size_t position;
+			std::vector<IndexEntry> entries;
+			std::unique_ptr<Json::StreamWriter> writer;
+
+			void emit (const std::string &str);
+			std::string fragment (const Json::Value &value, const std::string &indent);
+	};
+}
+
+#endif
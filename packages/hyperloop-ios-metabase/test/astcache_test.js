@@ -0,0 +1,69 @@
+var should = require('should'),
+	path = require('path'),
+	fs = require('fs-extra'),
+	helper = require('./helper');
+
+describe('ast cache', function () {
+
+	function generate (dir, cache, output, callback) {
+		helper.generate(path.join(dir, 'shards.h'), output, function (err, json) {
+			if (err) { return callback(err); }
+			var profile = fs.readFileSync(output + '.profile').toString();
+			delete json.metadata;
+			callback(null, json, profile.indexOf('clang_createTranslationUnit2') >= 0);
+		}, true, ['-fsp', dir, '-min-ios-ver', '9.0', '-ast-cache', cache, '-profile-clang', output + '.profile']);
+	}
+
+	it('should load the saved translation unit until one of its headers changes', function (done) {
+		var tmp = helper.getTempDir(),
+			dir = path.join(tmp, 'ast-shards'),
+			cache = path.join(tmp, 'ast-cache');
+		fs.copySync(helper.getFixture('shards'), dir);
+		generate(dir, cache, path.join(tmp, 'parsed.json'), function (err, parsed, loaded) {
+			if (err) { return done(err); }
+			should(loaded).be.false;
+			should(fs.readdirSync(cache).filter(function (f) { return /\.ast$/.test(f); })).have.length(1);
+			generate(dir, cache, path.join(tmp, 'loaded.json'), function (err, json, loaded) {
+				if (err) { return done(err); }
+				should(loaded).be.true;
+				should(json).be.eql(parsed);
+				// an edited header is parsed again
+				var header = path.join(dir, 'Colors.framework', 'Headers', 'Colors.h');
+				fs.writeFileSync(header, fs.readFileSync(header).toString().replace('ColorGreen', 'ColorGreen,\n\tColorBlue'));
+				generate(dir, cache, path.join(tmp, 'edited.json'), function (err, json, loaded) {
+					if (err) { return done(err); }
+					should(loaded).be.false;
+					should(json.enums.Color.values).have.property('ColorBlue', 2);
+					done();
+				});
+			});
+		});
+	});
+
+	it('should save one cache entry when batch groups parse the same arguments at once', function (done) {
+		var dir = helper.getTempDir(),
+			cache = path.join(dir, 'ast-cache'),
+			manifest = path.join(dir, 'manifest.json');
+		helper.run(function (sdk) {
+			// jobs that differ only in x are separate groups with the same compiler arguments
+			fs.writeFileSync(manifest, JSON.stringify({
+				defaults: { i: helper.getFixture('struct.h'), 'sim-sdk-path': sdk.sdkdir, 'min-ios-ver': '9.0', 'ast-cache': cache },
+				jobs: [
+					{ o: path.join(dir, 'system.json') },
+					{ o: path.join(dir, 'thirdparty.json'), x: true }
+				]
+			}));
+			return ['batch', '-m', manifest, '-threads', '2'];
+		}, function (err, e, output) {
+			if (err) { return done(err); }
+			should(e).be.eql(0);
+			should(JSON.parse(output).parses).be.eql(2);
+			var files = fs.readdirSync(cache).sort();
+			should(files.filter(function (f) { return /\.ast$/.test(f); })).have.length(1);
+			should(files.filter(function (f) { return /\.tmp/.test(f); })).be.empty;
+			should(JSON.parse(fs.readFileSync(path.join(dir, 'system.json'))).structs).have.property('A');
+			done();
+		});
+	});
+
+});
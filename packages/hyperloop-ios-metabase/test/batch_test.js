@@ -0,0 +1,44 @@
+var should = require('should'),
+	fs = require('fs'),
+	path = require('path'),
+	helper = require('./helper');
+
+describe('batch', function () {
+
+	it('should generate every job of a manifest and isolate failures', function (done) {
+		var dir = helper.getTempDir(),
+			manifest = path.join(dir, 'manifest.json'),
+			results = path.join(dir, 'results.json');
+		helper.run(function (sdk) {
+			fs.writeFileSync(manifest, JSON.stringify({
+				defaults: { 'sim-sdk-path': sdk.sdkdir, 'min-ios-ver': '9.0', x: true },
+				jobs: [
+					{ name: 'v9', i: helper.getFixture('availability.h'), o: path.join(dir, 'v9.json') },
+					{ name: 'v10', i: helper.getFixture('availability.h'), o: path.join(dir, 'v10.json'), 'min-ios-ver': '10.0', schema: '2' },
+					{ name: 'struct', i: helper.getFixture('struct.h'), o: path.join(dir, 'struct.json') },
+					{ name: 'missing', i: helper.getFixture('struct.h') }
+				]
+			}));
+			return ['batch', '-m', manifest, '-results', results, '-threads', '2'];
+		}, function (err, e) {
+			if (err) { return done(err); }
+			// one job failed
+			should(e).be.eql(1);
+			var json = JSON.parse(fs.readFileSync(results));
+			should(json.parses).be.eql(2);
+			should(json.failed).be.eql(1);
+			should(json.jobs.map(function (job) { return job.status; })).be.eql(['ok', 'ok', 'ok', 'failed']);
+			// both availability jobs come from one parse
+			should(json.jobs[0].group).be.eql(json.jobs[1].group);
+			should(json.jobs[3].error).match(/needs i, o/);
+			var v9 = JSON.parse(fs.readFileSync(path.join(dir, 'v9.json'))),
+				v10 = JSON.parse(fs.readFileSync(path.join(dir, 'v10.json')));
+			should(Object.keys(v9.functions).sort()).be.eql(['Always', 'Deprecated', 'Introduced', 'Obsoleted']);
+			should(v10.metadata['api-version']).be.eql('2');
+			should(v10.metadata['min-version']).be.eql('10.0');
+			should(fs.existsSync(path.join(dir, 'struct.json'))).be.true;
+			done();
+		});
+	});
+
+});
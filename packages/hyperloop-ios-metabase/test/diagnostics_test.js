@@ -0,0 +1,58 @@
+var should = require('should'),
+	fs = require('fs'),
+	helper = require('./helper');
+
+describe('diagnostics', function () {
+
+	it('should count diagnostics by kind with capped examples', function (done) {
+		var header = helper.getTempFile('unknown_types.h'),
+			diagnosticsfile = helper.getTempFile('unknown_types.diagnostics.json');
+		fs.writeFileSync(header, [
+			'@interface A',
+			'-(void)a:(Missing1 *)m;',
+			'-(void)b:(Missing2 *)m;',
+			'-(void)c:(Missing3 *)m;',
+			'@end'
+		].join('\n') + '\n');
+		helper.generate(header, helper.getTempFile('unknown_types.json'), function (err, json) {
+			if (err) { return done(err); }
+			var diagnostics = JSON.parse(fs.readFileSync(diagnosticsfile));
+			var errors = diagnostics.kinds.filter(function (kind) {
+				return kind.kind === 'clang.error';
+			})[0];
+			should(errors).be.an.object;
+			should(errors.count).be.above(2);
+			should(errors.examples).have.length(2);
+			errors.examples.forEach(function (example) {
+				should(example.message).be.a.String;
+			});
+			should(errors.examples[errors.examples.length - 1].filename).be.eql(header);
+			should(diagnostics.total).not.be.below(errors.count);
+			done();
+		}, true, ['-diagnostics', diagnosticsfile, '-diagnostics-limit', '2']);
+	});
+
+	it('should record diagnostics while resolving at the definition resolved', function (done) {
+		var header = helper.getTempFile('vector_types.h'),
+			diagnosticsfile = helper.getTempFile('vector_types.diagnostics.json');
+		fs.writeFileSync(header, [
+			'struct First { int x; };',
+			'typedef float float4 __attribute__((ext_vector_type(4)));',
+			'void UsesVector(float4 v);',
+			'struct Last { int x; };'
+		].join('\n') + '\n');
+		helper.generate(header, helper.getTempFile('vector_types.json'), function (err, json) {
+			if (err) { return done(err); }
+			var diagnostics = JSON.parse(fs.readFileSync(diagnosticsfile));
+			var unknown = diagnostics.kinds.filter(function (kind) {
+				return kind.kind === 'encoding.unknown';
+			})[0];
+			should(unknown).be.an.object;
+			// the typedef, not the last definition parsed
+			should(unknown.examples[0].filename).be.eql(header);
+			should(unknown.examples[0].line).be.eql('2');
+			done();
+		}, true, ['-diagnostics', diagnosticsfile]);
+	});
+
+});
@@ -0,0 +1,5 @@
+void Always(void);
+void Introduced(void) __attribute__((availability(ios,introduced=9.0)));
+void Deprecated(void) __attribute__((availability(ios,introduced=8.0,deprecated=10.0)));
+void Obsoleted(void) __attribute__((availability(ios,introduced=8.0,obsoleted=11.0)));
+void Unavailable(void) __attribute__((availability(ios,unavailable)));
@@ -0,0 +1,9 @@
+struct __attribute__((availability(ios,introduced=8.0,deprecated=9.5))) Old { int a; double b; };
+union __attribute__((availability(ios,introduced=8.0,obsoleted=10.0))) OldUnion { int i; float f; };
+typedef struct Old OldAlias;
+struct Holder { struct Old old; union OldUnion u; int count; };
+void UseOld(struct Old o);
+void UseOldPointer(struct Old *o);
+void UseAlias(OldAlias o);
+void UseUnion(union OldUnion u);
+struct Old MakeOld(void);
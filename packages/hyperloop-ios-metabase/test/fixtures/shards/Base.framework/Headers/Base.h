@@ -0,0 +1,4 @@
+@interface Root
++ (instancetype)alloc;
+- (instancetype)init;
+@end
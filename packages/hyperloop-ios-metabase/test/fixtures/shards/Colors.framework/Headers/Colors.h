@@ -0,0 +1,8 @@
+#import <Base/Base.h>
+
+typedef enum {
+	ColorRed,
+	ColorGreen
+} Color;
+
+extern Color ColorDefault(void);
@@ -0,0 +1,5 @@
+#import <Shapes/Shapes.h>
+
+@interface Shape (Extras)
+- (void)rotate:(float)degrees;
+@end
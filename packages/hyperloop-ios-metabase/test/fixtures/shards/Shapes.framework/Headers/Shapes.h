@@ -0,0 +1,10 @@
+#import <Base/Base.h>
+
+typedef struct {
+	float width;
+	float height;
+} ShapeSize;
+
+@interface Shape : Root
+- (ShapeSize)size;
+@end
@@ -0,0 +1,4 @@
+#import <Base/Base.h>
+#import <Shapes/Shapes.h>
+#import <Colors/Colors.h>
+#import <Extras/Extras.h>
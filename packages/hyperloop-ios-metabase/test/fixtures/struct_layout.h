@@ -0,0 +1,21 @@
+struct Point { short x; double y; };
+struct Flags {
+	unsigned int visible : 1;
+	unsigned int kind : 3;
+	char tag;
+	unsigned int count : 12;
+};
+struct Shape {
+	char id;
+	struct Point origin;
+	union {
+		int radius;
+		float side;
+	} size;
+	struct Flags flags;
+};
+union Value {
+	char c;
+	long long l;
+	struct Point p;
+};
@@ -52,7 +52,7 @@ function getBinary (callback) {
 	});
 }
 
-function generate (input, output, callback, excludeSystemAPIs) {
+function generate (input, output, callback, excludeSystemAPIs, extraArgs) {
 	getSimulatorSDK (function (err, sdk) {
 		if (err) { return callback(err); }
 		getBinary(function (err, bin) {
@@ -67,6 +67,9 @@ function generate (input, output, callback, excludeSystemAPIs) {
 			if (excludeSystemAPIs) {
 				args.push('-x');
 			}
+			if (extraArgs) {
+				args = args.concat(extraArgs);
+			}
 			var child = spawn(bin, args);
 			child.stderr.on('data', function (buf) {
 				// process.stderr.write(buf);
@@ -97,6 +100,48 @@ function generate (input, output, callback, excludeSystemAPIs) {
 	});
 }
 
+/**
+ * spawn the metabase binary, args are an array or a function of the
+ * simulator SDK returning one. The SDK is only looked up for a function.
+ * callback gets the child process
+ */
+function spawnMetabase (args, callback) {
+	function start (sdk) {
+		getBinary(function (err, bin) {
+			if (err) { return callback(err); }
+			callback(null, spawn(bin, typeof args === 'function' ? args(sdk) : args), sdk);
+		});
+	}
+	if (typeof args !== 'function') {
+		return start();
+	}
+	getSimulatorSDK(function (err, sdk) {
+		if (err) { return callback(err); }
+		start(sdk);
+	});
+}
+
+/**
+ * run the metabase binary to completion, writing input to its stdin if
+ * given. callback gets the exit code and stdout
+ */
+function run (args, callback, input) {
+	spawnMetabase(args, function (err, child) {
+		if (err) { return callback(err); }
+		var output = '';
+		child.stdout.on('data', function (buf) {
+			output += buf;
+		});
+		child.on('error', callback);
+		child.on('close', function (e) {
+			callback(null, e, output);
+		});
+		if (input !== undefined) {
+			child.stdin.end(input);
+		}
+	});
+}
+
 function getTempDir () {
 	var tmpdir = path.join(process.env.TEMP || process.env.TMPDIR || 'tmp', '' + Math.floor(Date.now()));
 	if (!fs.existsSync(tmpdir)) {
@@ -124,7 +169,10 @@ process.on('exit', function () {
 });
 
 exports.generate = generate;
+exports.spawnMetabase = spawnMetabase;
+exports.run = run;
 exports.getSimulatorSDK = getSimulatorSDK;
+exports.getBinary = getBinary;
 exports.getTempDir = getTempDir;
 exports.getFixture = getFixture;
 exports.getTempFile = getTempFile;
@@ -0,0 +1,32 @@
+var should = require('should'),
+	path = require('path'),
+	fs = require('fs'),
+	helper = require('./helper');
+
+describe('merge', function () {
+
+	it('should merge shards into the whole metabase', function (done) {
+		var tmp = helper.getTempDir(),
+			output = path.join(tmp, 'whole.json'),
+			dir = path.join(tmp, 'merge-shards'),
+			merged = path.join(tmp, 'merged.json');
+		helper.generate(helper.getFixture(path.join('shards', 'shards.h')), output, function (err, whole) {
+			if (err) { return done(err); }
+			// the compact shards and the whole metabase merge into the legacy layout
+			helper.run(['merge', '-i', dir + ',' + output, '-o', merged], function (err, e) {
+				if (err) { return done(err); }
+				should(e).be.eql(0);
+				var json = JSON.parse(fs.readFileSync(merged));
+				should(json.metadata['api-version']).be.eql('1');
+				should(json).not.have.property('types');
+				should(Object.keys(json.classes).sort()).be.eql(['Root', 'Shape']);
+				should(json.classes.Shape.methods).have.property('rotate:');
+				should(json.classes.Shape.categories).be.eql(['Extras']);
+				should(json.classes.Shape.framework).be.eql('Shapes');
+				should(Object.keys(json.structs)).be.eql(Object.keys(whole.structs));
+				done();
+			});
+		}, true, ['-fsp', helper.getFixture('shards'), '-shards', dir, '-min-ios-ver', '9.0', '-schema', '2']);
+	});
+
+});
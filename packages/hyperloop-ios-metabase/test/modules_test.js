@@ -0,0 +1,50 @@
+var should = require('should'),
+	path = require('path'),
+	fs = require('fs-extra'),
+	helper = require('./helper');
+
+describe('modules', function () {
+
+	function generate (output, extra, callback) {
+		helper.generate(helper.getFixture(path.join('shards', 'shards.h')), output, function (err, json) {
+			if (err) { return callback(err); }
+			delete json.metadata;
+			callback(null, json);
+		}, true, ['-fsp', helper.getFixture('shards'), '-min-ios-ver', '9.0'].concat(extra));
+	}
+
+	function listModules (dir) {
+		var found = [];
+		fs.readdirSync(dir).forEach(function (name) {
+			var file = path.join(dir, name);
+			if (fs.statSync(file).isDirectory()) {
+				found = found.concat(listModules(file));
+			} else if (/\.pcm$/.test(name)) {
+				found.push(name.split('-')[0]);
+			}
+		});
+		return found;
+	}
+
+	it('should build the framework modules once and match the textual metabase', function (done) {
+		var dir = helper.getTempDir(),
+			cache = path.join(dir, 'module-cache');
+		generate(path.join(dir, 'textual.json'), [], function (err, textual) {
+			if (err) { return done(err); }
+			generate(path.join(dir, 'cold.json'), ['-modules', cache], function (err, cold) {
+				if (err) { return done(err); }
+				should(cold).be.eql(textual);
+				should(listModules(cache).sort()).be.eql(['Base', 'Colors', 'Extras', 'Shapes']);
+				// the second run reuses the modules already built
+				var built = listModules(cache).length;
+				generate(path.join(dir, 'warm.json'), ['-modules', cache], function (err, warm) {
+					if (err) { return done(err); }
+					should(warm).be.eql(textual);
+					should(listModules(cache).length).be.eql(built);
+					done();
+				});
+			});
+		});
+	});
+
+});
@@ -0,0 +1,31 @@
+var should = require('should'),
+	fs = require('fs'),
+	helper = require('./helper');
+
+describe('profile-clang', function () {
+
+	it('should count libclang calls per function and definition kind', function (done) {
+		var profilefile = helper.getTempFile('simple_class.profile.json');
+		helper.generate(helper.getFixture('simple_class.h'), helper.getTempFile('simple_class.json'), function (err, json) {
+			if (err) { return done(err); }
+			var profile = JSON.parse(fs.readFileSync(profilefile));
+			should(profile.total.calls).be.above(0);
+			var names = profile.functions.map(function (fn) { return fn.name; });
+			should(names).containEql('clang_parseTranslationUnit');
+			should(names).containEql('clang_visitChildren');
+			profile.functions.forEach(function (fn) {
+				should(fn.calls).be.above(0);
+				should(fn.time).not.be.below(fn.self);
+			});
+			for (var c = 1; c < profile.functions.length; c++) {
+				should(profile.functions[c - 1].self).not.be.below(profile.functions[c].self);
+			}
+			var sites = profile.sites.map(function (site) { return site.name; });
+			should(sites).containEql('parseTranslationUnit');
+			should(sites).containEql('class');
+			should(sites).containEql('method');
+			done();
+		}, true, ['-profile-clang', profilefile]);
+	});
+
+});
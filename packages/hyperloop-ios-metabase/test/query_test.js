@@ -0,0 +1,141 @@
+var should = require('should'),
+	fs = require('fs'),
+	path = require('path'),
+	helper = require('./helper');
+
+describe('query', function () {
+
+	function generate (output, extra, callback) {
+		helper.run(function (sdk) {
+			return [
+				'-i', helper.getFixture('shards/shards.h'),
+				'-fsp', helper.getFixture('shards'),
+				'-o', output,
+				'-sim-sdk-path', sdk.sdkdir,
+				'-min-ios-ver', '9.0',
+				'-x'
+			].concat(extra);
+		}, function (err, e) {
+			if (err) { return callback(err); }
+			should(e).be.eql(0);
+			callback();
+		});
+	}
+
+	function query (metabase, args, callback) {
+		helper.run([ 'query', '-m', metabase ].concat(args), function (err, e, output) {
+			callback(err, e, e === 0 ? JSON.parse(output) : null);
+		});
+	}
+
+	function queries (metabase, callback) {
+		var answers = {};
+		query(metabase, [ '-class', 'Shape' ], function (err, e, json) {
+			if (err) { return callback(err); }
+			answers.class = json;
+			query(metabase, [ '-symbol', 'ColorDefault' ], function (err, e, json) {
+				if (err) { return callback(err); }
+				answers.symbol = json;
+				query(metabase, [ '-struct', 'ShapeSize' ], function (err, e, json) {
+					if (err) { return callback(err); }
+					answers.struct = json;
+					query(metabase, [ '-section', 'enums', '-name', 'Color' ], function (err, e, json) {
+						if (err) { return callback(err); }
+						answers.section = json;
+						callback(null, answers);
+					});
+				});
+			});
+		});
+	}
+
+	it('should answer lookups from the index and rebuild it when missing or stale', function (done) {
+		var metabase = path.join(helper.getTempDir(), 'query.json'),
+			sidecar = metabase + '.idx';
+		generate(metabase, [ '-index' ], function (err) {
+			if (err) { return done(err); }
+			should(fs.existsSync(sidecar)).be.true;
+			queries(metabase, function (err, answers) {
+				if (err) { return done(err); }
+				should(answers.class.name).be.eql('Shape');
+				should(answers.class.superclasses).be.eql([ 'Root' ]);
+				should(answers.class.methods).have.property('size');
+				should(answers.class.methods.init.inheritedFrom).be.eql('Root');
+				should(answers.class.methods['rotate:']).not.have.property('inheritedFrom');
+				should(answers.symbol.definitions).have.length(1);
+				should(answers.symbol.definitions[0]).have.properties({ section: 'functions', framework: 'Colors' });
+				should(answers.struct).have.properties({ name: 'ShapeSize', struct: 'ShapeSize', encoding: '{ShapeSize=ff}' });
+				should(answers.struct.fields.map(function (f) { return f.name; })).be.eql([ 'width', 'height' ]);
+				should(answers.section.values).be.eql({ ColorRed: 0, ColorGreen: 1 });
+
+				// without the sidecar the metabase is scanned and the sidecar written again
+				fs.unlinkSync(sidecar);
+				queries(metabase, function (err, scanned) {
+					if (err) { return done(err); }
+					should(scanned).be.eql(answers);
+					should(fs.existsSync(sidecar)).be.true;
+
+					// written again pretty, every offset moves and the sidecar is stale
+					var stale = fs.readFileSync(sidecar).toString();
+					generate(metabase, [ '-pretty' ], function (err) {
+						if (err) { return done(err); }
+						queries(metabase, function (err, rebuilt) {
+							if (err) { return done(err); }
+							should(rebuilt).be.eql(answers);
+							should(fs.readFileSync(sidecar).toString()).not.be.eql(stale);
+							query(metabase, [ '-class', 'Missing' ], function (err, e) {
+								if (err) { return done(err); }
+								should(e).not.be.eql(0);
+								done();
+							});
+						});
+					});
+				});
+			});
+		});
+	});
+
+	it('should rebuild the index of a metabase rewritten at the same size within a second', function (done) {
+		var dir = helper.getTempDir(),
+			metabase = path.join(dir, 'same-size.json');
+		generate(metabase, [ '-index' ], function (err) {
+			if (err) { return done(err); }
+			// same size and, to the second, the same modification time as the index
+			fs.writeFileSync(metabase, fs.readFileSync(metabase).toString().replace(/"Shape"/g, '"Shapf"'));
+			query(metabase, [ '-class', 'Shape' ], function (err, e) {
+				if (err) { return done(err); }
+				should(e).not.be.eql(0);
+				query(metabase, [ '-class', 'Shapf' ], function (err, e, json) {
+					if (err) { return done(err); }
+					should(e).be.eql(0);
+					should(json.name).be.eql('Shapf');
+					done();
+				});
+			});
+		});
+	});
+
+	it('should answer lookups in the legacy layout from a compact metabase', function (done) {
+		var dir = helper.getTempDir(),
+			legacy = path.join(dir, 'query-legacy.json'),
+			compact = path.join(dir, 'query-compact.json');
+		generate(legacy, [ '-index' ], function (err) {
+			if (err) { return done(err); }
+			generate(compact, [ '-index', '-schema', '2' ], function (err) {
+				if (err) { return done(err); }
+				queries(legacy, function (err, expected) {
+					if (err) { return done(err); }
+					queries(compact, function (err, answers) {
+						if (err) { return done(err); }
+						// file and type indexes are expanded from the compact tables
+						should(answers).be.eql(expected);
+						should(answers.class).not.have.property('file');
+						should(answers.class.framework).be.eql('Shapes');
+						done();
+					});
+				});
+			});
+		});
+	});
+
+});
@@ -0,0 +1,29 @@
+var should = require('should'),
+	fs = require('fs'),
+	helper = require('./helper');
+
+describe('report', function () {
+
+	it('should attribute definitions and bytes to headers', function (done) {
+		var reportfile = helper.getTempFile('struct.report.json');
+		helper.generate(helper.getFixture('struct.h'), helper.getTempFile('struct.json'), function (err, json) {
+			if (err) { return done(err); }
+			var report = JSON.parse(fs.readFileSync(reportfile));
+			should(report.sort).be.eql('bytes');
+			var header = report.headers.filter(function (header) {
+				return header.name === helper.getFixture('struct.h');
+			})[0];
+			should(header).be.an.object;
+			should(header.import).be.eql(helper.getFixture('struct.h'));
+			should(header.definitions).be.above(0);
+			should(header.bytes).be.above(0);
+			should(header.time).be.a.Number;
+			should(report.total.definitions).be.above(0);
+			for (var c = 1; c < report.headers.length; c++) {
+				should(report.headers[c - 1].bytes).not.be.below(report.headers[c].bytes);
+			}
+			done();
+		}, true, ['-report', reportfile, '-report-sort', 'bytes']);
+	});
+
+});
@@ -0,0 +1,65 @@
+var should = require('should'),
+	metabase = require('../lib/metabase');
+
+describe('schema', function () {
+
+	describe('expandMetabase()', function () {
+
+		it('should leave legacy metabases unchanged', function () {
+			var json = { metadata: { 'api-version': '1' }, classes: { Foo: { filename: 'Foo.h', framework: 'Foo' } } };
+			should(metabase.expandMetabase(json)).be.exactly(json);
+			should(json.classes.Foo.filename).be.eql('Foo.h');
+		});
+
+		it('should resolve file, framework and type references', function () {
+			var json = metabase.expandMetabase({
+				metadata: { 'api-version': '2' },
+				frameworks: [ 'UIKit' ],
+				files: [ { filename: '/UIKit.framework/Headers/UIView.h', framework: 0, thirdparty: false } ],
+				types: [
+					{ type: 'void', value: 'void', encoding: 'v' },
+					{ type: 'objc_pointer', value: 'NSString *', encoding: '@' },
+					{ type: 'double', encoding: 'd' },
+					{ type: 'record', encoding: '(?=d)' }
+				],
+				classes: {
+					UIView: {
+						name: 'UIView',
+						file: 0,
+						line: '10',
+						introducedIn: '2.0.0',
+						methods: {
+							'setTitle:': { selector: 'setTitle:', returns: 0, arguments: [ { name: 'title', type: 1 } ] }
+						},
+						properties: {
+							title: { name: 'title', type: 1, optional: false }
+						}
+					}
+				},
+				structs: {
+					CGPoint: { name: 'CGPoint', file: 0, fields: [ { name: 'x', type: 2, offset: 0 } ] },
+					Value: { name: 'Value', file: 0, fields: [ { name: 'v', type: 3, offset: 0, fields: [ { name: 'd', type: 2, offset: 0 } ] } ] }
+				},
+				blocks: {
+					UIKit: [ { signature: 'void (^)(void)', arguments: [], returns: 0 } ]
+				}
+			});
+			should(json.metadata['api-version']).be.eql('1');
+			should(json).not.have.property('files');
+			should(json).not.have.property('frameworks');
+			should(json).not.have.property('types');
+
+			var view = json.classes.UIView;
+			should(view.filename).be.eql('/UIKit.framework/Headers/UIView.h');
+			should(view.framework).be.eql('UIKit');
+			should(view.thirdparty).be.false;
+			should(view).not.have.property('file');
+			should(view.methods['setTitle:'].returns).be.eql({ type: 'void', value: 'void', encoding: 'v' });
+			should(view.methods['setTitle:'].arguments[0]).be.eql({ name: 'title', type: 'objc_pointer', value: 'NSString *', encoding: '@' });
+			should(view.properties.title.type).be.eql({ type: 'objc_pointer', value: 'NSString *', encoding: '@' });
+			should(json.structs.CGPoint.fields[0]).be.eql({ name: 'x', type: 'double', encoding: 'd', offset: 0 });
+			should(json.structs.Value.fields[0].fields[0]).be.eql({ name: 'd', type: 'double', encoding: 'd', offset: 0 });
+			should(json.blocks.UIKit[0].returns).be.eql({ type: 'void', value: 'void', encoding: 'v' });
+		});
+	});
+});
@@ -0,0 +1,69 @@
+var should = require('should'),
+	path = require('path'),
+	fs = require('fs-extra'),
+	helper = require('./helper');
+
+describe('sdk', function () {
+
+	// an SDK of the shards fixtures, named like a simulator SDK
+	function makeSDK (dir) {
+		var sdk = path.join(dir, 'iPhoneSimulator9.0.sdk'),
+			frameworks = path.join(sdk, 'System', 'Library', 'Frameworks');
+		fs.mkdirsSync(frameworks);
+		['Base', 'Colors', 'Extras', 'Shapes'].forEach(function (name) {
+			fs.copySync(helper.getFixture(path.join('shards', name + '.framework')), path.join(frameworks, name + '.framework'));
+		});
+		return sdk;
+	}
+
+	function run (args, callback) {
+		helper.run(['sdk'].concat(args), function (err, e, output) {
+			callback(err, e, output && output.trim());
+		});
+	}
+
+	it('should write a metabase per framework keyed by SDK and min version', function (done) {
+		var tmp = helper.getTempDir(),
+			sdk = makeSDK(tmp),
+			cache = path.join(tmp, 'sdk-cache'),
+			args = [
+				'-sim-sdk-path', sdk,
+				'-fsp', path.join(sdk, 'System', 'Library', 'Frameworks'),
+				'-min-ios-ver', '9.0',
+				'-o', cache,
+				'-threads', '2'
+			];
+		run(args, function (err, e, dir) {
+			if (err) { return done(err); }
+			should(e).be.eql(0);
+			should(dir).be.eql(path.join(cache, '9.0', '9.0'));
+			var index = JSON.parse(fs.readFileSync(path.join(dir, 'index.json')));
+			should(index.metadata['sdk-version']).be.eql('9.0');
+			should(Object.keys(index.frameworks).sort()).be.eql(['Base', 'Colors', 'Extras', 'Shapes']);
+			should(index.frameworks.Extras.dependencies).be.eql(['Base', 'Shapes']);
+			should(index.frameworks.Base.dependencies).be.eql([]);
+			var shapes = JSON.parse(fs.readFileSync(path.join(dir, 'Shapes.json'))),
+				extras = JSON.parse(fs.readFileSync(path.join(dir, 'Extras.json')));
+			// only the definitions of the framework, Root is in Base
+			should(Object.keys(shapes.classes)).be.eql(['Shape']);
+			should(shapes.structs).have.property('ShapeSize');
+			should(shapes.classes.Shape.methods).not.have.property('rotate:');
+			// the category of Extras extends the class of Shapes
+			should(extras).not.have.property('classes');
+			should(extras.extensions.Shape.methods).have.property('rotate:');
+			should(extras.extensions.Shape.categories).be.eql(['Extras']);
+
+			// a second run keeps the cached frameworks
+			var stat = fs.statSync(path.join(dir, 'Shapes.json'));
+			fs.removeSync(path.join(dir, 'Colors.json'));
+			run(args, function (err, e) {
+				if (err) { return done(err); }
+				should(e).be.eql(0);
+				should(fs.statSync(path.join(dir, 'Shapes.json')).mtime.getTime()).be.eql(stat.mtime.getTime());
+				should(fs.existsSync(path.join(dir, 'Colors.json'))).be.true;
+				done();
+			});
+		});
+	});
+
+});
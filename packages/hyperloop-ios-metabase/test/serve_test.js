@@ -0,0 +1,50 @@
+var should = require('should'),
+	path = require('path'),
+	fs = require('fs'),
+	helper = require('./helper');
+
+describe('serve', function () {
+
+	it('should reparse the edited headers of later requests', function (done) {
+		var dir = helper.getTempDir(),
+			header = path.join(dir, 'serve.h'),
+			extras = helper.getFixture(path.join('shards', 'Extras.framework', 'Headers', 'Extras.h')),
+			edited = fs.readFileSync(extras).toString() + '\n@interface Sticker : Root\n@end\n',
+			unsaved = {};
+		// the imports before the first declaration are the preamble
+		fs.writeFileSync(header, '#import <Base/Base.h>\n#import <Shapes/Shapes.h>\n#import <Colors/Colors.h>\n@class Root;\n#import <Extras/Extras.h>\n');
+		unsaved[extras] = edited;
+		helper.run(function (sdk) {
+			return [
+				'serve',
+				'-fsp', helper.getFixture('shards'),
+				'-sim-sdk-path', sdk.sdkdir,
+				'-min-ios-ver', '9.0',
+				'-x'
+			];
+		}, function (err, e, output) {
+			if (err) { return done(err); }
+			should(e).be.eql(0);
+			var results = output.trim().split('\n').map(function (line) { return JSON.parse(line); });
+			should(results.map(function (result) { return result.status; })).be.eql(['ok', 'ok', 'failed']);
+			should(results[0]).not.have.property('reparsed');
+			should(results[1].reparsed).be.true;
+			should(results[2].error).match(/needs i, o/);
+			var first = JSON.parse(fs.readFileSync(path.join(dir, 'first.json'))),
+				second = JSON.parse(fs.readFileSync(path.join(dir, 'second.json')));
+			should(first.classes).not.have.property('Sticker');
+			should(second.classes).have.property('Sticker');
+			should(second.classes.Shape.methods).have.property('rotate:');
+			delete first.metadata;
+			delete second.metadata;
+			delete second.classes.Sticker;
+			should(second).be.eql(first);
+			done();
+		}, [
+			{ i: header, o: path.join(dir, 'first.json') },
+			{ i: header, o: path.join(dir, 'second.json'), unsaved: unsaved },
+			{ i: header }
+		].map(function (request) { return JSON.stringify(request) + '\n'; }).join(''));
+	});
+
+});
@@ -0,0 +1,38 @@
+var should = require('should'),
+	path = require('path'),
+	fs = require('fs'),
+	helper = require('./helper');
+
+describe('shards', function () {
+
+	it('should write a metabase per framework matching the whole metabase', function (done) {
+		var tmp = helper.getTempDir(),
+			dir = path.join(tmp, 'shards');
+		helper.generate(helper.getFixture(path.join('shards', 'shards.h')), path.join(tmp, 'shards.json'), function (err, json) {
+			if (err) { return done(err); }
+			var list = JSON.parse(fs.readFileSync(path.join(dir, 'shards.json'))).frameworks,
+				merged = {};
+			should(Object.keys(list).sort()).be.eql(['Base', 'Colors', 'Extras', 'Shapes']);
+			// nothing of Colors is pending, the category in Extras changes Shapes after it was written
+			should(list.Colors.early).be.true;
+			should(list.Shapes.early).be.false;
+			should(list.Base.early).be.false;
+			Object.keys(list).forEach(function (framework) {
+				var shard = JSON.parse(fs.readFileSync(path.join(dir, list[framework].file)));
+				Object.keys(shard).forEach(function (section) {
+					if (section === 'metadata') { return; }
+					merged[section] = merged[section] || {};
+					Object.keys(shard[section]).forEach(function (name) {
+						should(merged[section]).not.have.property(name);
+						merged[section][name] = shard[section][name];
+					});
+				});
+			});
+			delete json.metadata;
+			should(merged).be.eql(json);
+			should(merged.classes.Shape.methods).have.property('rotate:');
+			done();
+		}, true, ['-fsp', helper.getFixture('shards'), '-shards', dir, '-min-ios-ver', '9.0']);
+	});
+
+});
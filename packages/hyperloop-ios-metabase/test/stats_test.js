@@ -0,0 +1,49 @@
+var should = require('should'),
+	fs = require('fs'),
+	helper = require('./helper');
+
+describe('stats', function () {
+
+	it('should write phase timings and counters', function (done) {
+		var statsfile = helper.getTempFile('struct.stats.json');
+		helper.generate(helper.getFixture('struct.h'), helper.getTempFile('struct.json'), function (err, json) {
+			if (err) { return done(err); }
+			var stats = JSON.parse(fs.readFileSync(statsfile));
+			should(stats.phases).be.an.Array;
+			should(stats.phases.map(function (phase) { return phase.name; })).eql([
+				'parseTranslationUnit', 'traverse', 'complete', 'resolve', 'write'
+			]);
+			stats.phases.forEach(function (phase) {
+				should(phase.wall).be.a.Number;
+				should(phase.cpu).be.a.Number;
+				should(phase.calls).be.eql(1);
+			});
+			should(stats.counts).have.property('structs', 2);
+			should(stats.counts.cursors).be.eql(2);
+			should(stats.bytesWritten).be.above(0);
+			should(stats.peakRSS).be.above(0);
+			done();
+		}, true, ['-stats', statsfile]);
+	});
+
+	it('should write memory by phase, model type and document', function (done) {
+		var statsfile = helper.getTempFile('struct.stats.json');
+		helper.generate(helper.getFixture('struct.h'), helper.getTempFile('struct.json'), function (err, json) {
+			if (err) { return done(err); }
+			var stats = JSON.parse(fs.readFileSync(statsfile));
+			stats.phases.forEach(function (phase) {
+				should(phase.rss.before).be.above(0);
+				should(phase.rss.after).be.above(0);
+			});
+			should(stats.instances).have.property('StructDefinition');
+			should(stats.instances.StructDefinition.live).be.eql(2);
+			should(stats.instances.StructDefinition.peak).be.eql(2);
+			should(stats.instances.StructDefinition.bytes).be.eql(2 * stats.instances.StructDefinition.size);
+			should(stats.instances.Type.peak).be.above(0);
+			should(stats.document.values).be.above(0);
+			should(stats.document.bytes).be.above(0);
+			done();
+		}, true, ['-stats', statsfile]);
+	});
+
+});
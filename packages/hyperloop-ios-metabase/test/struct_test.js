@@ -21,9 +21,12 @@ describe('struct', function () {
 						{
 							encoding: 'f',
 							name: 'a',
+							offset: 0,
 							type: 'float'
 						}
 					],
+					size: 4,
+					alignment: 4,
 					framework: 'fixtures',
 					thirdparty: true,
 					filename: helper.getFixture('struct.h'),
@@ -48,4 +51,29 @@ describe('struct', function () {
 		});
 	});
 
+	it('should generate struct layout', function (done) {
+		helper.generate(helper.getFixture('struct_layout.h'), helper.getTempFile('struct_layout.json'), function (err, json) {
+			if (err) { return done(err); }
+			should(json.structs.Point).have.properties({ size: 16, alignment: 8 });
+			should(json.structs.Point.fields.map(function (f) { return f.offset; })).be.eql([ 0, 8 ]);
+			// bitfields have the byte they start in, the bit in it and their width
+			should(json.structs.Flags).have.properties({ size: 4, alignment: 4 });
+			should(json.structs.Flags.fields[0]).have.properties({ name: 'visible', offset: 0, bitOffset: 0, bitWidth: 1 });
+			should(json.structs.Flags.fields[1]).have.properties({ name: 'kind', offset: 0, bitOffset: 1, bitWidth: 3 });
+			should(json.structs.Flags.fields[2]).have.properties({ name: 'tag', offset: 1 });
+			should(json.structs.Flags.fields[2]).not.have.property('bitWidth');
+			should(json.structs.Flags.fields[3]).have.properties({ name: 'count', offset: 2, bitOffset: 0, bitWidth: 12 });
+			// nested records are laid out where they are, anonymous ones with their fields
+			should(json.structs.Shape).have.properties({ size: 32, alignment: 8 });
+			should(json.structs.Shape.fields.map(function (f) { return f.offset; })).be.eql([ 0, 8, 24, 28 ]);
+			should(json.structs.Shape.fields[2].fields).be.eql([
+				{ encoding: 'i', name: 'radius', offset: 0, type: 'int' },
+				{ encoding: 'f', name: 'side', offset: 0, type: 'float' }
+			]);
+			should(json.unions.Value).have.properties({ size: 16, alignment: 8 });
+			should(json.unions.Value.fields.map(function (f) { return f.offset; })).be.eql([ 0, 0, 0 ]);
+			done();
+		});
+	});
+
 });
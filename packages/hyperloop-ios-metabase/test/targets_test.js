@@ -0,0 +1,83 @@
+var should = require('should'),
+	fs = require('fs'),
+	path = require('path'),
+	helper = require('./helper');
+
+describe('targets', function () {
+
+	function run (header, output, minVersion, callback) {
+		helper.run(function (sdk) {
+			return [
+				'-i', helper.getFixture(header),
+				'-o', output,
+				'-sim-sdk-path', sdk.sdkdir,
+				'-min-ios-ver', minVersion,
+				'-x'
+			];
+		}, function (err, e) {
+			if (err) { return callback(err); }
+			should(e).be.eql(0);
+			callback();
+		});
+	}
+
+	it('should write a metabase per minimum version from one parse', function (done) {
+		var dir = helper.getTempDir(),
+			output = path.join(dir, 'availability.json');
+		run('availability.h', output, '10.0,9.0,11.0', function (err) {
+			if (err) { return done(err); }
+			should(fs.existsSync(output)).be.false;
+			var targets = {};
+			['9.0', '10.0', '11.0'].forEach(function (version) {
+				var json = JSON.parse(fs.readFileSync(path.join(dir, 'availability-' + version + '.json')));
+				should(json.metadata['min-version']).be.eql(version);
+				targets[version] = Object.keys(json.functions).sort();
+			});
+			should(targets['9.0']).be.eql(['Always', 'Deprecated', 'Introduced', 'Obsoleted']);
+			should(targets['10.0']).be.eql(['Always', 'Introduced', 'Obsoleted']);
+			should(targets['11.0']).be.eql(['Always', 'Introduced']);
+			done();
+		});
+	});
+
+	it('should write each version as a parse at that version would', function (done) {
+		var dir = helper.getTempDir(),
+			versions = ['9.0', '10.0', '11.0'];
+
+		function read (output) {
+			var json = JSON.parse(fs.readFileSync(path.join(dir, output)));
+			delete json.metadata.generated;
+			return json;
+		}
+
+		run('availability_records.h', path.join(dir, 'records.json'), versions.join(','), function (err) {
+			if (err) { return done(err); }
+			var pending = versions.length;
+			versions.forEach(function (version) {
+				run('availability_records.h', path.join(dir, 'records.' + version + '.json'), version, function (err) {
+					if (err) { return done(err); }
+					if (--pending === 0) {
+						versions.forEach(function (version) {
+							should(read('records-' + version + '.json')).be.eql(read('records.' + version + '.json'));
+						});
+						// struct Old is deprecated in 9.5, so stays a record at 10.0
+						should(read('records-10.0.json').functions.UseOld.arguments[0]).have.properties({ type: 'record', value: 'struct Old' });
+						should(read('records-9.0.json').functions.UseOld.arguments[0]).have.properties({ type: 'struct', value: 'Old' });
+						done();
+					}
+				});
+			});
+		});
+	});
+
+	it('should keep introducedIn for a single version', function (done) {
+		helper.generate(helper.getFixture('availability.h'), helper.getTempFile('availability.json'), function (err, json) {
+			if (err) { return done(err); }
+			should(json.functions).not.have.property('Unavailable');
+			should(json.functions.Introduced.introducedIn).be.eql('9.0.0');
+			should(json.functions.Deprecated.introducedIn).be.eql('8.0.0');
+			done();
+		}, true, ['-min-ios-ver', '9.0']);
+	});
+
+});
@@ -0,0 +1,55 @@
+var should = require('should'),
+	fs = require('fs'),
+	path = require('path'),
+	helper = require('./helper');
+
+describe('trace', function () {
+
+	function events (tracefile, category) {
+		return JSON.parse(fs.readFileSync(tracefile)).traceEvents.filter(function (event) {
+			return event.cat === category;
+		});
+	}
+
+	it('should write phase, visit and parse spans', function (done) {
+		var dir = helper.getTempDir(),
+			header = helper.getFixture('struct.h'),
+			tracefile = path.join(dir, 'struct.trace.json');
+		helper.generate(header, path.join(dir, 'struct.json'), function (err, json) {
+			if (err) { return done(err); }
+			var trace = JSON.parse(fs.readFileSync(tracefile));
+			should(trace.traceEvents[0]).have.properties({ name: 'process_name', ph: 'M' });
+			trace.traceEvents.slice(1).forEach(function (event) {
+				should(event.ph).be.eql('X');
+				should(event.ts).be.a.Number;
+				should(event.dur).be.a.Number;
+			});
+			var phases = events(tracefile, 'phase').map(function (event) { return event.name; });
+			['parseTranslationUnit', 'traverse', 'resolve', 'write'].forEach(function (phase) {
+				should(phases).containEql(phase);
+			});
+			// both top level cursors of the header in one span
+			var visits = events(tracefile, 'visit');
+			should(visits).have.length(1);
+			should(visits[0].args).be.eql({ filename: header, cursors: 2 });
+			// a threshold of 0 traces every definition
+			var parsed = events(tracefile, 'parse');
+			should(parsed.map(function (event) { return event.name; })).be.eql(['A', 'B']);
+			should(parsed[0].args).be.eql({ kind: 'StructDecl', filename: header, line: '1' });
+			done();
+		}, true, ['-trace', tracefile, '-trace-threshold', '0']);
+	});
+
+	it('should leave out definitions parsed faster than the threshold', function (done) {
+		var dir = helper.getTempDir(),
+			tracefile = path.join(dir, 'struct.trace.json');
+		helper.generate(helper.getFixture('struct.h'), path.join(dir, 'struct.json'), function (err, json) {
+			if (err) { return done(err); }
+			should(events(tracefile, 'parse')).be.empty;
+			should(events(tracefile, 'visit')).have.length(1);
+			should(events(tracefile, 'phase')).not.be.empty;
+			done();
+		}, true, ['-trace', tracefile, '-trace-threshold', '60000']);
+	});
+
+});
@@ -22,19 +22,24 @@ describe('union', function () {
 						{
 							encoding: 'i',
 							name: 'i',
+							offset: 0,
 							type: 'int'
 						},
 						{
 							encoding: 'f',
 							name: 'f',
+							offset: 0,
 							type: 'float'
 						},
 						{
 							encoding: 'c',
 							name: 'c',
+							offset: 0,
 							type: 'char_s'
 						}
 					],
+					size: 4,
+					alignment: 4,
 					framework: 'fixtures',
 					thirdparty: true,
 					filename: helper.getFixture('unions.h'),
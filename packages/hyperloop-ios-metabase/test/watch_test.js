@@ -0,0 +1,54 @@
+var should = require('should'),
+	path = require('path'),
+	fs = require('fs-extra'),
+	helper = require('./helper');
+
+describe('watch', function () {
+
+	it('should generate the metabase again when an included header changes', function (done) {
+		var tmp = helper.getTempDir(),
+			dir = path.join(tmp, 'watch-shards'),
+			output = path.join(tmp, 'watch.json'),
+			header = path.join(dir, 'Colors.framework', 'Headers', 'Colors.h'),
+			generations = [],
+			buffer = '';
+		fs.copySync(helper.getFixture('shards'), dir);
+		helper.spawnMetabase(function (sdk) {
+			return [
+				'-i', path.join(dir, 'shards.h'),
+				'-fsp', dir,
+				'-o', output,
+				'-sim-sdk-path', sdk.sdkdir,
+				'-min-ios-ver', '9.0',
+				'-x',
+				'-watch'
+			];
+		}, function (err, child) {
+			if (err) { return done(err); }
+			child.on('error', done);
+			child.stdout.on('data', function (buf) {
+				buffer += buf;
+				var lines = buffer.split('\n');
+				buffer = lines.pop();
+				lines.forEach(function (line) {
+					var generation = JSON.parse(line);
+					generations.push(generation);
+					if (generations.length === 1) {
+						should(generation.written).be.true;
+						fs.writeFileSync(header, fs.readFileSync(header).toString().replace('ColorGreen', 'ColorGreen,\n\tColorBlue'));
+					} else if (generations.length === 2) {
+						child.kill();
+						should(generation.reparsed).be.true;
+						should(generation.written).be.true;
+						should(generation.changed.enums).be.eql(['Color']);
+						should(generation.added).be.eql({});
+						var json = JSON.parse(fs.readFileSync(output));
+						should(json.enums.Color.values).have.property('ColorBlue', 2);
+						done();
+					}
+				});
+			});
+		});
+	});
+
+});
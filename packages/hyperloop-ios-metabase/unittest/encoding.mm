@@ -0,0 +1,65 @@
+/**
+ * Hyperloop Metabase Generator
+ * Copyright (c) 2015 by Appcelerator, Inc.
+ */
+
+#import <XCTest/XCTest.h>
+#import <string>
+#import "encoding.h"
+#import "util.h"
+
+@interface encoding : XCTestCase
+
+@end
+
+@implementation encoding
+
+- (void)testMetabaseTypes {
+	XCTAssertTrue(hyperloop::primitiveForType("char_s") == hyperloop::Primitive::Char);
+	XCTAssertTrue(hyperloop::primitiveForType("uint") == hyperloop::Primitive::UInt);
+	XCTAssertTrue(hyperloop::primitiveForType("long_long") == hyperloop::Primitive::LongLong);
+	XCTAssertTrue(hyperloop::primitiveForType("ulonglong") == hyperloop::Primitive::ULongLong);
+	XCTAssertTrue(hyperloop::primitiveForType("objc_pointer") == hyperloop::Primitive::Object);
+	XCTAssertTrue(hyperloop::primitiveForType("enum") == hyperloop::Primitive::Int);
+	XCTAssertTrue(hyperloop::primitiveForType("block") == hyperloop::Primitive::Block);
+}
+
+- (void)testCSpellings {
+	XCTAssertTrue(hyperloop::primitiveForType("unsigned char") == hyperloop::Primitive::UChar);
+	XCTAssertTrue(hyperloop::primitiveForType("unsigned long long") == hyperloop::Primitive::ULongLong);
+	XCTAssertTrue(hyperloop::primitiveForType("long double") == hyperloop::Primitive::LongDouble);
+	XCTAssertTrue(hyperloop::primitiveForType("_Bool") == hyperloop::Primitive::Bool);
+	XCTAssertTrue(hyperloop::primitiveForType("char *") == hyperloop::Primitive::CString);
+	XCTAssertTrue(hyperloop::primitiveForType("SEL") == hyperloop::Primitive::Selector);
+}
+
+- (void)testNotPrimitive {
+	XCTAssertTrue(hyperloop::primitiveForType("") == hyperloop::Primitive::None);
+	XCTAssertTrue(hyperloop::primitiveForType("struct") == hyperloop::Primitive::None);
+	XCTAssertTrue(hyperloop::primitiveForType("pointer") == hyperloop::Primitive::None);
+	XCTAssertTrue(hyperloop::primitiveForType("NSString *") == hyperloop::Primitive::None);
+	XCTAssertTrue(hyperloop::primitiveForType("Int") == hyperloop::Primitive::None);
+	XCTAssertTrue(hyperloop::primitiveForType("int ") == hyperloop::Primitive::None);
+	XCTAssertTrue(hyperloop::primitiveForEncoding("") == hyperloop::Primitive::None);
+	XCTAssertTrue(hyperloop::primitiveForEncoding("^i") == hyperloop::Primitive::None);
+	XCTAssertTrue(hyperloop::primitiveForEncoding("{CGPoint=dd}") == hyperloop::Primitive::None);
+}
+
+- (void)testEncodings {
+	XCTAssertTrue(std::string(hyperloop::encodingOf(hyperloop::Primitive::UShort)) == "S");
+	XCTAssertTrue(std::string(hyperloop::encodingOf(hyperloop::Primitive::Block)) == "@?");
+	XCTAssertTrue(std::string(hyperloop::encodingOf(hyperloop::Primitive::None)) == "?");
+	XCTAssertTrue(hyperloop::primitiveForEncoding("@?") == hyperloop::Primitive::Block);
+	XCTAssertTrue(hyperloop::primitiveForEncoding("#") == hyperloop::Primitive::ClassObject);
+	XCTAssertTrue(std::string(hyperloop::typeOf(hyperloop::Primitive::ULong)) == "unsigned long");
+	XCTAssertTrue(std::string(hyperloop::typeOf(hyperloop::Primitive::None)) == "unknown");
+}
+
+- (void)testEncodingToType {
+	XCTAssertTrue(hyperloop::EncodingToType("q") == "long long");
+	XCTAssertTrue(hyperloop::EncodingToType("r*") == "char *");
+	XCTAssertTrue(hyperloop::EncodingToType("{CGPoint=dd}") == "struct");
+	XCTAssertTrue(hyperloop::EncodingToType("") == "unknown");
+}
+
+@end